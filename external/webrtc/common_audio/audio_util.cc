@@ -39,6 +39,93 @@ void FloatS16ToFloat(const float* src, size_t size, float* dest) {
     dest[i] = FloatS16ToFloat(src[i]);
 }
 
+void DeinterleaveS16ToFloatS16(const int16_t* interleaved,
+                               size_t samples_per_channel,
+                               int num_channels,
+                               float* const* deinterleaved) {
+  if (num_channels == 2) {
+    float* left = deinterleaved[0];
+    float* right = deinterleaved[1];
+    for (size_t i = 0; i < samples_per_channel; ++i) {
+      left[i] = interleaved[2 * i];
+      right[i] = interleaved[2 * i + 1];
+    }
+    return;
+  }
+  for (int i = 0; i < num_channels; ++i) {
+    float* channel = deinterleaved[i];
+    const int16_t* src = interleaved + i;
+    for (size_t j = 0; j < samples_per_channel; ++j)
+      channel[j] = src[j * num_channels];
+  }
+}
+
+void InterleaveFloatS16ToS16(const float* const* deinterleaved,
+                             size_t samples_per_channel,
+                             int num_channels,
+                             int16_t* interleaved) {
+  if (num_channels == 2) {
+    const float* left = deinterleaved[0];
+    const float* right = deinterleaved[1];
+    for (size_t i = 0; i < samples_per_channel; ++i) {
+      interleaved[2 * i] = FloatS16ToS16(left[i]);
+      interleaved[2 * i + 1] = FloatS16ToS16(right[i]);
+    }
+    return;
+  }
+  for (int i = 0; i < num_channels; ++i) {
+    const float* channel = deinterleaved[i];
+    int16_t* dest = interleaved + i;
+    for (size_t j = 0; j < samples_per_channel; ++j)
+      dest[j * num_channels] = FloatS16ToS16(channel[j]);
+  }
+}
+
+void UpmixMonoFloatS16ToInterleavedS16(const float* mono,
+                                       size_t num_frames,
+                                       int num_channels,
+                                       int16_t* interleaved) {
+  if (num_channels == 2) {
+    for (size_t i = 0; i < num_frames; ++i) {
+      const int16_t value = FloatS16ToS16(mono[i]);
+      interleaved[2 * i] = value;
+      interleaved[2 * i + 1] = value;
+    }
+    return;
+  }
+  for (size_t i = 0; i < num_frames; ++i) {
+    const int16_t value = FloatS16ToS16(mono[i]);
+    for (int j = 0; j < num_channels; ++j)
+      *interleaved++ = value;
+  }
+}
+
+void DownmixInterleavedS16ToMonoFloatS16(const int16_t* interleaved,
+                                         size_t num_frames,
+                                         int num_channels,
+                                         float* mono) {
+  RTC_DCHECK_GT(num_channels, 0);
+  if (num_channels == 1) {
+    for (size_t i = 0; i < num_frames; ++i)
+      mono[i] = interleaved[i];
+    return;
+  }
+  if (num_channels == 2) {
+    for (size_t i = 0; i < num_frames; ++i) {
+      mono[i] = static_cast<int16_t>(
+          (static_cast<int32_t>(interleaved[2 * i]) + interleaved[2 * i + 1]) /
+          2);
+    }
+    return;
+  }
+  for (size_t i = 0; i < num_frames; ++i) {
+    int32_t value = *interleaved++;
+    for (int j = 1; j < num_channels; ++j)
+      value += *interleaved++;
+    mono[i] = static_cast<int16_t>(value / num_channels);
+  }
+}
+
 template <>
 void DownmixInterleavedToMono<int16_t>(const int16_t* interleaved,
                                        size_t num_frames,
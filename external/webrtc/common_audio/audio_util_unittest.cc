@@ -8,6 +8,8 @@
  *  be found in the AUTHORS file in the root of the source tree.
  */
 
+#include <algorithm>
+
 #include "testing/gmock/include/gmock/gmock.h"
 #include "testing/gtest/include/gtest/gtest.h"
 #include "webrtc/common_audio/include/audio_util.h"
@@ -227,5 +229,75 @@ TEST(AudioUtilTest, DownmixToMonoTest) {
   }
 }
 
+TEST(AudioUtilTest, DeinterleaveS16ToFloatS16MatchesSeparateSteps) {
+  const size_t kNumFrames = 5;
+  const int16_t kInterleaved[3 * kNumFrames] = {
+      0,     1,      -1,     32767, -32768, 2,     -2,   100,
+      -100,  12345, -12345, 7,     -7,     30000, -30000};
+  for (int num_channels = 1; num_channels <= 3; ++num_channels) {
+    int16_t expected[3][kNumFrames];
+    int16_t* expected_ptr[3] = {expected[0], expected[1], expected[2]};
+    Deinterleave(kInterleaved, kNumFrames, num_channels, expected_ptr);
+
+    float deinterleaved[3][kNumFrames];
+    float* deinterleaved_ptr[3] = {deinterleaved[0], deinterleaved[1],
+                                   deinterleaved[2]};
+    DeinterleaveS16ToFloatS16(kInterleaved, kNumFrames, num_channels,
+                              deinterleaved_ptr);
+    for (int i = 0; i < num_channels; ++i) {
+      for (size_t j = 0; j < kNumFrames; ++j)
+        EXPECT_EQ(static_cast<float>(expected[i][j]), deinterleaved[i][j]);
+    }
+
+    int16_t interleaved[3 * kNumFrames];
+    InterleaveFloatS16ToS16(deinterleaved_ptr, kNumFrames, num_channels,
+                            interleaved);
+    ExpectArraysEq(kInterleaved, interleaved, kNumFrames * num_channels);
+  }
+}
+
+TEST(AudioUtilTest, InterleaveFloatS16ToS16RoundsAndSaturates) {
+  const size_t kNumFrames = 4;
+  const float kLeft[kNumFrames] = {0.4f, -0.6f, 40000.f, 1.5f};
+  const float kRight[kNumFrames] = {-0.4f, 0.6f, -40000.f, -1.5f};
+  const float* input[] = {kLeft, kRight};
+  const int16_t kReference[2 * kNumFrames] = {0,     0,      -1, 1,
+                                              32767, -32768, 2,  -2};
+  int16_t output[2 * kNumFrames];
+  InterleaveFloatS16ToS16(input, kNumFrames, 2, output);
+  ExpectArraysEq(kReference, output, 2 * kNumFrames);
+
+  for (int num_channels = 1; num_channels <= 3; ++num_channels) {
+    int16_t upmixed[3 * kNumFrames];
+    UpmixMonoFloatS16ToInterleavedS16(kLeft, kNumFrames, num_channels,
+                                      upmixed);
+    for (size_t i = 0; i < kNumFrames; ++i) {
+      for (int j = 0; j < num_channels; ++j)
+        EXPECT_EQ(kReference[2 * i], upmixed[i * num_channels + j]);
+    }
+  }
+}
+
+TEST(AudioUtilTest, DownmixInterleavedS16ToMonoFloatS16MatchesInt16) {
+  const size_t kNumFrames = 4;
+  const int16_t kInterleaved[3 * kNumFrames] = {
+      30000, 30000, 24001, -5, -10, -20, -30000, -30999, -30000, 1, -2, 0};
+  for (int num_channels = 1; num_channels <= 3; ++num_channels) {
+    int16_t expected[kNumFrames];
+    if (num_channels == 1) {
+      std::copy(kInterleaved, kInterleaved + kNumFrames, expected);
+    } else {
+      DownmixInterleavedToMono(kInterleaved, kNumFrames, num_channels,
+                               expected);
+    }
+
+    float downmixed[kNumFrames];
+    DownmixInterleavedS16ToMonoFloatS16(kInterleaved, kNumFrames, num_channels,
+                                        downmixed);
+    for (size_t i = 0; i < kNumFrames; ++i)
+      EXPECT_EQ(static_cast<float>(expected[i]), downmixed[i]);
+  }
+}
+
 }  // namespace
 }  // namespace webrtc
@@ -15,15 +15,17 @@ namespace webrtc {
 IFChannelBuffer::IFChannelBuffer(size_t num_frames,
                                  int num_channels,
                                  size_t num_bands)
-    : ivalid_(true),
-      ibuf_(num_frames, num_channels, num_bands),
+    : ivalid_(false),
       fvalid_(true),
-      fbuf_(num_frames, num_channels, num_bands) {}
+      fbuf_(num_frames, num_channels, num_bands),
+      num_conversions_(0) {}
+
+IFChannelBuffer::~IFChannelBuffer() {}
 
 ChannelBuffer<int16_t>* IFChannelBuffer::ibuf() {
   RefreshI();
   fvalid_ = false;
-  return &ibuf_;
+  return ibuf_.get();
 }
 
 ChannelBuffer<float>* IFChannelBuffer::fbuf() {
@@ -34,7 +36,7 @@ ChannelBuffer<float>* IFChannelBuffer::fbuf() {
 
 const ChannelBuffer<int16_t>* IFChannelBuffer::ibuf_const() const {
   RefreshI();
-  return &ibuf_;
+  return ibuf_.get();
 }
 
 const ChannelBuffer<float>* IFChannelBuffer::fbuf_const() const {
@@ -42,31 +44,54 @@ const ChannelBuffer<float>* IFChannelBuffer::fbuf_const() const {
   return &fbuf_;
 }
 
+ChannelBuffer<int16_t>* IFChannelBuffer::ibuf_for_overwrite() {
+  AllocateI();
+  ivalid_ = true;
+  fvalid_ = false;
+  return ibuf_.get();
+}
+
+ChannelBuffer<float>* IFChannelBuffer::fbuf_for_overwrite() {
+  fvalid_ = true;
+  ivalid_ = false;
+  return &fbuf_;
+}
+
+void IFChannelBuffer::AllocateI() const {
+  if (!ibuf_) {
+    ibuf_.reset(new ChannelBuffer<int16_t>(
+        fbuf_.num_frames(), fbuf_.num_channels(), fbuf_.num_bands()));
+  }
+}
+
 void IFChannelBuffer::RefreshF() const {
   if (!fvalid_) {
     assert(ivalid_);
-    const int16_t* const* int_channels = ibuf_.channels();
+    const int16_t* const* int_channels = ibuf_->channels();
     float* const* float_channels = fbuf_.channels();
-    for (int i = 0; i < ibuf_.num_channels(); ++i) {
-      for (size_t j = 0; j < ibuf_.num_frames(); ++j) {
+    for (int i = 0; i < fbuf_.num_channels(); ++i) {
+      for (size_t j = 0; j < fbuf_.num_frames(); ++j) {
         float_channels[i][j] = int_channels[i][j];
       }
     }
     fvalid_ = true;
+    ++num_conversions_;
   }
 }
 
 void IFChannelBuffer::RefreshI() const {
   if (!ivalid_) {
     assert(fvalid_);
-    int16_t* const* int_channels = ibuf_.channels();
+    AllocateI();
+    int16_t* const* int_channels = ibuf_->channels();
     const float* const* float_channels = fbuf_.channels();
-    for (int i = 0; i < ibuf_.num_channels(); ++i) {
+    for (int i = 0; i < fbuf_.num_channels(); ++i) {
       FloatS16ToS16(float_channels[i],
-                    ibuf_.num_frames(),
+                    fbuf_.num_frames(),
                     int_channels[i]);
     }
     ivalid_ = true;
+    ++num_conversions_;
   }
 }
 
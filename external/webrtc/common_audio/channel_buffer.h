@@ -140,28 +140,47 @@ class ChannelBuffer {
 // therefore safe to use the return value of ibuf_const() and fbuf_const()
 // until the next call to ibuf() or fbuf(), and the return value of ibuf() and
 // fbuf() until the next call to any of the other functions.
+//
+// The int16_t ChannelBuffer is only allocated the first time it is requested,
+// so that no memory nor conversions are spent on it when the data is only
+// ever accessed as float.
 class IFChannelBuffer {
  public:
   IFChannelBuffer(size_t num_frames, int num_channels, size_t num_bands = 1);
+  ~IFChannelBuffer();
 
   ChannelBuffer<int16_t>* ibuf();
   ChannelBuffer<float>* fbuf();
   const ChannelBuffer<int16_t>* ibuf_const() const;
   const ChannelBuffer<float>* fbuf_const() const;
-
-  size_t num_frames() const { return ibuf_.num_frames(); }
-  size_t num_frames_per_band() const { return ibuf_.num_frames_per_band(); }
-  int num_channels() const { return ibuf_.num_channels(); }
-  size_t num_bands() const { return ibuf_.num_bands(); }
+  // Like ibuf() and fbuf(), for callers which overwrite every sample: the
+  // returned ChannelBuffer is not brought up to date first.
+  ChannelBuffer<int16_t>* ibuf_for_overwrite();
+  ChannelBuffer<float>* fbuf_for_overwrite();
+
+  // Whether the int16_t or the float ChannelBuffer is up to date, i.e. can be
+  // read without a conversion.
+  bool ivalid() const { return ivalid_; }
+  bool fvalid() const { return fvalid_; }
+  // The number of times the outdated ChannelBuffer has been brought up to
+  // date, each time converting all of its samples.
+  size_t num_conversions() const { return num_conversions_; }
+
+  size_t num_frames() const { return fbuf_.num_frames(); }
+  size_t num_frames_per_band() const { return fbuf_.num_frames_per_band(); }
+  int num_channels() const { return fbuf_.num_channels(); }
+  size_t num_bands() const { return fbuf_.num_bands(); }
 
  private:
+  void AllocateI() const;
   void RefreshF() const;
   void RefreshI() const;
 
   mutable bool ivalid_;
-  mutable ChannelBuffer<int16_t> ibuf_;
+  mutable rtc::scoped_ptr<ChannelBuffer<int16_t> > ibuf_;
   mutable bool fvalid_;
   mutable ChannelBuffer<float> fbuf_;
+  mutable size_t num_conversions_;
 };
 
 }  // namespace webrtc
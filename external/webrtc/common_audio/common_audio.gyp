@@ -135,7 +135,10 @@
           ],
         }],
         ['target_arch=="ia32" or target_arch=="x64"', {
-          'dependencies': ['common_audio_sse2',],
+          'dependencies': [
+            'common_audio_sse2',
+            'common_audio_avx2',
+          ],
         }],
         ['build_with_neon==1', {
           'dependencies': ['common_audio_neon',],
@@ -210,6 +213,21 @@
             }],
           ],
         },
+        {
+          'target_name': 'common_audio_avx2',
+          'type': 'static_library',
+          'sources': [
+            'resampler/sinc_resampler_avx2.cc',
+          ],
+          'conditions': [
+            ['os_posix==1', {
+              'cflags': [ '-mavx2', '-mfma', ],
+              'xcode_settings': {
+                'OTHER_CFLAGS': [ '-mavx2', '-mfma', ],
+              },
+            }],
+          ],
+        },
       ],  # targets
     }],
     ['build_with_neon==1', {
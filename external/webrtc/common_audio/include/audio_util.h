@@ -171,6 +171,42 @@ void DownmixInterleavedToMonoImpl(const T* interleaved,
   }
 }
 
+// The following functions fuse the interleaving, downmixing and the S16 <->
+// FloatS16 conversion done at the API boundary into a single pass over the
+// data. They produce the same results as the separate steps on int16_t data
+// followed (or preceded) by the conversion, and have fast paths for the
+// common mono and stereo layouts.
+
+// Deinterleaves |interleaved| and converts it to FloatS16. There must be
+// sufficient space allocated in the |deinterleaved| buffers (|num_channels|
+// buffers with |samples_per_channel| per buffer).
+void DeinterleaveS16ToFloatS16(const int16_t* interleaved,
+                               size_t samples_per_channel,
+                               int num_channels,
+                               float* const* deinterleaved);
+
+// Converts the channels pointed to by |deinterleaved| to S16 and interleaves
+// them to |interleaved|, which must hold |samples_per_channel| *
+// |num_channels| samples.
+void InterleaveFloatS16ToS16(const float* const* deinterleaved,
+                             size_t samples_per_channel,
+                             int num_channels,
+                             int16_t* interleaved);
+
+// Converts |mono| to S16 and copies it to each channel of |interleaved|,
+// which must hold |num_frames| * |num_channels| samples.
+void UpmixMonoFloatS16ToInterleavedS16(const float* mono,
+                                       size_t num_frames,
+                                       int num_channels,
+                                       int16_t* interleaved);
+
+// Downmixes |interleaved| to |mono| in FloatS16, averaging the channels with
+// the same integer arithmetic as DownmixInterleavedToMono<int16_t>().
+void DownmixInterleavedS16ToMonoFloatS16(const int16_t* interleaved,
+                                         size_t num_frames,
+                                         int num_channels,
+                                         float* mono);
+
 template <typename T>
 void DownmixInterleavedToMono(const T* interleaved,
                               size_t num_frames,
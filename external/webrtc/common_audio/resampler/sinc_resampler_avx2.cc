@@ -0,0 +1,46 @@
+/*
+ *  Copyright (c) 2016 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "webrtc/common_audio/resampler/sinc_resampler.h"
+
+#include <immintrin.h>
+
+namespace webrtc {
+
+float SincResampler::Convolve_AVX2(const float* input_ptr, const float* k1,
+                                   const float* k2,
+                                   double kernel_interpolation_factor) {
+  __m256 m_input;
+  __m256 m_sums1 = _mm256_setzero_ps();
+  __m256 m_sums2 = _mm256_setzero_ps();
+
+  // Unaligned loads are as fast as aligned ones on aligned data on all AVX2
+  // capable CPUs, so unlike Convolve_SSE() there is no need to branch on the
+  // alignment of |input_ptr|. The kernels are always 32-byte aligned.
+  for (size_t i = 0; i < kKernelSize; i += 8) {
+    m_input = _mm256_loadu_ps(input_ptr + i);
+    m_sums1 = _mm256_fmadd_ps(m_input, _mm256_load_ps(k1 + i), m_sums1);
+    m_sums2 = _mm256_fmadd_ps(m_input, _mm256_load_ps(k2 + i), m_sums2);
+  }
+
+  // Linearly interpolate the two "convolutions".
+  m_sums1 = _mm256_mul_ps(m_sums1, _mm256_set1_ps(
+      static_cast<float>(1.0 - kernel_interpolation_factor)));
+  m_sums1 = _mm256_fmadd_ps(m_sums2, _mm256_set1_ps(
+      static_cast<float>(kernel_interpolation_factor)), m_sums1);
+
+  // Sum components together.
+  __m128 m_sum = _mm_add_ps(_mm256_castps256_ps128(m_sums1),
+                            _mm256_extractf128_ps(m_sums1, 1));
+  m_sum = _mm_add_ps(_mm_movehl_ps(m_sum, m_sum), m_sum);
+  return _mm_cvtss_f32(_mm_add_ss(m_sum, _mm_shuffle_ps(m_sum, m_sum, 1)));
+}
+
+}  // namespace webrtc
@@ -15,6 +15,7 @@
 #define _USE_MATH_DEFINES
 
 #include <math.h>
+#include <stdio.h>
 
 #include "testing/gmock/include/gmock/gmock.h"
 #include "testing/gtest/include/gtest/gtest.h"
@@ -162,6 +163,42 @@ TEST(SincResamplerTest, Convolve) {
 }
 #endif
 
+#if defined(WEBRTC_ARCH_X86_FAMILY)
+// Ensure Convolve_AVX2() returns the same value as Convolve_C(). It uses fused
+// multiply-adds, so it differs from the other optimized methods in the last
+// bits.
+TEST(SincResamplerTest, ConvolveAvx2) {
+  if (!WebRtc_GetCPUInfo(kAVX2) || !WebRtc_GetCPUInfo(kFMA3)) {
+    printf("Skipping test: the CPU does not support AVX2 and FMA3.\n");
+    return;
+  }
+
+  // Initialize a dummy resampler.
+  MockSource mock_source;
+  SincResampler resampler(kSampleRateRatio, SincResampler::kDefaultRequestSize,
+                          &mock_source);
+
+  static const double kEpsilon = 0.0000001;
+
+  // Test Convolve_AVX2() w/ aligned and unaligned input pointers and with
+  // kernels from all of the offsets.
+  const float* kernel = resampler.kernel_storage_.get();
+  for (size_t offset = 0; offset < SincResampler::kKernelOffsetCount;
+       ++offset) {
+    const float* k1 = kernel + offset * SincResampler::kKernelSize;
+    const float* k2 = k1 + SincResampler::kKernelSize;
+    for (size_t input_offset = 0; input_offset < 8; ++input_offset) {
+      const float* input = kernel + input_offset;
+      const double result = resampler.Convolve_C(input, k1, k2,
+                                                 kKernelInterpolationFactor);
+      const double result2 = resampler.Convolve_AVX2(
+          input, k1, k2, kKernelInterpolationFactor);
+      EXPECT_NEAR(result2, result, kEpsilon);
+    }
+  }
+}
+#endif
+
 // Benchmark for the various Convolve() methods.  Make sure to build with
 // branding=Chrome so that RTC_DCHECKs are compiled out when benchmarking.
 // Original benchmarks were run with --convolve-iterations=50000000.
@@ -348,7 +385,7 @@ INSTANTIATE_TEST_CASE_P(
         std::tr1::make_tuple(16000, 44100, kResamplingRMSError, -62.54),
         std::tr1::make_tuple(22050, 44100, kResamplingRMSError, -73.53),
         std::tr1::make_tuple(32000, 44100, kResamplingRMSError, -63.32),
-        std::tr1::make_tuple(44100, 44100, kResamplingRMSError, -73.53),
+        std::tr1::make_tuple(44100, 44100, kResamplingRMSError, -73.52),
         std::tr1::make_tuple(48000, 44100, -15.01, -64.04),
         std::tr1::make_tuple(96000, 44100, -18.49, -25.51),
         std::tr1::make_tuple(192000, 44100, -20.50, -13.31),
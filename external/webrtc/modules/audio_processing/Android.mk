@@ -33,9 +33,11 @@ LOCAL_SRC_FILES := \
     agc/utility.cc\
     audio_buffer.cc\
     audio_processing_impl.cc\
+    batch_audio_processing.cc\
     beamformer/array_util.cc\
     beamformer/covariance_matrix_generator.cc\
     beamformer/nonlinear_beamformer.cc\
+    duplex/duplex_engine.cc\
     echo_cancellation_impl.cc\
     echo_control_mobile_impl.cc\
     gain_control_impl.cc\
@@ -45,6 +47,8 @@ LOCAL_SRC_FILES := \
     logging/aec_logging_file_handling.cc\
     noise_suppression_impl.cc\
     processing_component.cc\
+    processing_profiler.cc\
+    render_queue.cc\
     rms_level.cc\
     splitting_filter.cc\
     three_band_filter_bank.cc\
@@ -1539,6 +1539,9 @@ AecCore* WebRtcAec_CreateAec() {
   if (WebRtc_GetCPUInfo(kSSE2)) {
     WebRtcAec_InitAec_SSE2();
   }
+  if (WebRtc_GetCPUInfo(kAVX2) && WebRtc_GetCPUInfo(kFMA3)) {
+    WebRtcAec_InitAec_AVX2();
+  }
 #endif
 
 #if defined(MIPS_FPU_LE)
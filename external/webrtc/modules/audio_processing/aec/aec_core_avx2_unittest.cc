@@ -0,0 +1,176 @@
+/*
+ *  Copyright (c) 2016 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+
+#include "testing/gtest/include/gtest/gtest.h"
+extern "C" {
+#include "webrtc/modules/audio_processing/aec/aec_core.h"
+#include "webrtc/modules/audio_processing/aec/aec_core_internal.h"
+#include "webrtc/modules/audio_processing/aec/aec_rdft.h"
+}
+#include "webrtc/system_wrappers/include/cpu_features_wrapper.h"
+
+namespace webrtc {
+namespace {
+
+// The AVX2 kernels use fused multiply-adds and are therefore not bit-exact
+// with the SSE2 ones; they must agree to within float rounding.
+const float kRelativeTolerance = 1e-5f;
+
+void FillRandom(float* data, size_t length, float scale) {
+  for (size_t i = 0; i < length; ++i) {
+    data[i] = scale * (static_cast<float>(rand()) / RAND_MAX - 0.5f);
+  }
+}
+
+void ExpectNear(const float* expected, const float* actual, size_t length) {
+  for (size_t i = 0; i < length; ++i) {
+    const float tolerance =
+        kRelativeTolerance * std::max(1.f, fabsf(expected[i]));
+    ASSERT_NEAR(expected[i], actual[i], tolerance) << "at index " << i;
+  }
+}
+
+class AecAvx2Test : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    srand(42);
+    FillRandom(x_fft_buf_[0], kBufferLength, 2.f);
+    FillRandom(x_fft_buf_[1], kBufferLength, 2.f);
+    FillRandom(h_fft_buf_[0], kBufferLength, 0.5f);
+    FillRandom(h_fft_buf_[1], kBufferLength, 0.5f);
+    FillRandom(fft_[0], PART_LEN1, 1.f);
+    FillRandom(fft_[1], PART_LEN1, 1.f);
+    for (int i = 0; i < PART_LEN1; ++i) {
+      x_pow_[i] = 0.01f + static_cast<float>(rand()) / RAND_MAX;
+    }
+  }
+
+  void TearDown() override {
+    // Restore the function pointers selected for this CPU.
+    WebRtcAec_FreeAec(WebRtcAec_CreateAec());
+  }
+
+  // The tests pass without running anything on CPUs without the AVX2
+  // kernels, so say so.
+  static bool HasAvx2() {
+    if (WebRtc_GetCPUInfo(kSSE2) && WebRtc_GetCPUInfo(kAVX2) &&
+        WebRtc_GetCPUInfo(kFMA3)) {
+      return true;
+    }
+    printf("Skipping test: the CPU does not support AVX2 and FMA3.\n");
+    return false;
+  }
+
+  static const size_t kBufferLength = kExtendedNumPartitions * PART_LEN1;
+  float x_fft_buf_[2][kBufferLength];
+  float h_fft_buf_[2][kBufferLength];
+  float fft_[2][PART_LEN1];
+  float x_pow_[PART_LEN1];
+};
+
+TEST_F(AecAvx2Test, RdftMatchesSse2) {
+  if (!HasAvx2())
+    return;
+  float input[PART_LEN2];
+  float sse2[PART_LEN2];
+  float avx2[PART_LEN2];
+  FillRandom(input, PART_LEN2, 2.f);
+
+  aec_rdft_init();
+  aec_rdft_init_sse2();
+  memcpy(sse2, input, sizeof(input));
+  aec_rdft_forward_128(sse2);
+  aec_rdft_init_avx2();
+  memcpy(avx2, input, sizeof(input));
+  aec_rdft_forward_128(avx2);
+  ExpectNear(sse2, avx2, PART_LEN2);
+
+  aec_rdft_init_sse2();
+  aec_rdft_inverse_128(sse2);
+  aec_rdft_init_avx2();
+  aec_rdft_inverse_128(avx2);
+  ExpectNear(sse2, avx2, PART_LEN2);
+
+  // The round trip restores the input up to a factor of PART_LEN.
+  for (int i = 0; i < PART_LEN2; ++i) {
+    avx2[i] *= 2.f / PART_LEN2;
+  }
+  ExpectNear(input, avx2, PART_LEN2);
+}
+
+TEST_F(AecAvx2Test, FilterFarMatchesSse2) {
+  if (!HasAvx2())
+    return;
+  float sse2[2][PART_LEN1];
+  float avx2[2][PART_LEN1];
+  for (int num_partitions = kNormalNumPartitions;
+       num_partitions <= kExtendedNumPartitions;
+       num_partitions += kExtendedNumPartitions - kNormalNumPartitions) {
+    for (int block_pos = 0; block_pos < num_partitions; block_pos += 5) {
+      memcpy(sse2, fft_, sizeof(fft_));
+      memcpy(avx2, fft_, sizeof(fft_));
+      WebRtcAec_InitAec_SSE2();
+      WebRtcAec_FilterFar(num_partitions, block_pos, x_fft_buf_, h_fft_buf_,
+                          sse2);
+      WebRtcAec_InitAec_AVX2();
+      WebRtcAec_FilterFar(num_partitions, block_pos, x_fft_buf_, h_fft_buf_,
+                          avx2);
+      ExpectNear(sse2[0], avx2[0], PART_LEN1);
+      ExpectNear(sse2[1], avx2[1], PART_LEN1);
+    }
+  }
+}
+
+TEST_F(AecAvx2Test, ScaleErrorSignalMatchesSse2) {
+  if (!HasAvx2())
+    return;
+  float sse2[2][PART_LEN1];
+  float avx2[2][PART_LEN1];
+  for (int extended = 0; extended <= 1; ++extended) {
+    memcpy(sse2, fft_, sizeof(fft_));
+    memcpy(avx2, fft_, sizeof(fft_));
+    WebRtcAec_InitAec_SSE2();
+    WebRtcAec_ScaleErrorSignal(extended, 0.5f, 10.f, x_pow_, sse2);
+    WebRtcAec_InitAec_AVX2();
+    WebRtcAec_ScaleErrorSignal(extended, 0.5f, 10.f, x_pow_, avx2);
+    ExpectNear(sse2[0], avx2[0], PART_LEN1);
+    ExpectNear(sse2[1], avx2[1], PART_LEN1);
+  }
+}
+
+TEST_F(AecAvx2Test, FilterAdaptationMatchesSse2) {
+  if (!HasAvx2())
+    return;
+  static float sse2[2][kBufferLength];
+  static float avx2[2][kBufferLength];
+  aec_rdft_init();
+  for (int num_partitions = kNormalNumPartitions;
+       num_partitions <= kExtendedNumPartitions;
+       num_partitions += kExtendedNumPartitions - kNormalNumPartitions) {
+    memcpy(sse2, h_fft_buf_, sizeof(h_fft_buf_));
+    memcpy(avx2, h_fft_buf_, sizeof(h_fft_buf_));
+    WebRtcAec_InitAec_SSE2();
+    WebRtcAec_FilterAdaptation(num_partitions, 3, x_fft_buf_, fft_, sse2);
+    WebRtcAec_InitAec_AVX2();
+    WebRtcAec_FilterAdaptation(num_partitions, 3, x_fft_buf_, fft_, avx2);
+    ExpectNear(sse2[0], avx2[0], kBufferLength);
+    ExpectNear(sse2[1], avx2[1], kBufferLength);
+  }
+}
+
+}  // namespace
+}  // namespace webrtc
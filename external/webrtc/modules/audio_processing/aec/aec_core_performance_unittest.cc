@@ -0,0 +1,143 @@
+/*
+ *  Copyright (c) 2016 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <string>
+
+#include "testing/gtest/include/gtest/gtest.h"
+#include "webrtc/base/timeutils.h"
+extern "C" {
+#include "webrtc/modules/audio_processing/aec/aec_core.h"
+#include "webrtc/modules/audio_processing/aec/aec_core_internal.h"
+#include "webrtc/modules/audio_processing/aec/aec_rdft.h"
+}
+#include "webrtc/system_wrappers/include/cpu_features_wrapper.h"
+#include "webrtc/test/testsupport/perf_test.h"
+
+// Microbenchmark of the SIMD paths of the AEC filter kernels and the rdft.
+// Each kernel is run with the extended filter length, which is the worst case
+// for FilterFar and FilterAdaptation.
+namespace webrtc {
+namespace {
+
+const int kNumIterations = 20000;
+const size_t kBufferLength = kExtendedNumPartitions * PART_LEN1;
+
+enum SimdPath { kSse2Path, kAvx2Path };
+
+void SelectPath(SimdPath path) {
+  aec_rdft_init();
+  aec_rdft_init_sse2();
+  WebRtcAec_InitAec_SSE2();
+  if (path == kAvx2Path) {
+    aec_rdft_init_avx2();
+    WebRtcAec_InitAec_AVX2();
+  }
+}
+
+std::string PathName(SimdPath path) {
+  return path == kSse2Path ? "sse2" : "avx2";
+}
+
+void FillRandom(float* data, size_t length) {
+  for (size_t i = 0; i < length; ++i) {
+    data[i] = static_cast<float>(rand()) / RAND_MAX - 0.5f;
+  }
+}
+
+// Times each kernel and prints the average duration of one call.
+void RunKernels(SimdPath path) {
+  static float x_fft_buf[2][kBufferLength];
+  static float h_fft_buf[2][kBufferLength];
+  float y_fft[2][PART_LEN1];
+  float e_fft[2][PART_LEN1];
+  float x_pow[PART_LEN1];
+  float input[PART_LEN2];
+  float fft[PART_LEN2];
+  srand(17);
+  FillRandom(x_fft_buf[0], kBufferLength);
+  FillRandom(x_fft_buf[1], kBufferLength);
+  FillRandom(h_fft_buf[0], kBufferLength);
+  FillRandom(h_fft_buf[1], kBufferLength);
+  FillRandom(y_fft[0], PART_LEN1);
+  FillRandom(y_fft[1], PART_LEN1);
+  FillRandom(input, PART_LEN2);
+  for (int i = 0; i < PART_LEN1; ++i) {
+    x_pow[i] = 1.f + static_cast<float>(i);
+  }
+
+  SelectPath(path);
+
+  uint64_t start = rtc::TimeNanos();
+  for (int i = 0; i < kNumIterations; ++i) {
+    WebRtcAec_FilterFar(kExtendedNumPartitions, i % kExtendedNumPartitions,
+                        x_fft_buf, h_fft_buf, y_fft);
+  }
+  uint64_t filter_far_ns = rtc::TimeNanos() - start;
+
+  start = rtc::TimeNanos();
+  for (int i = 0; i < kNumIterations; ++i) {
+    memcpy(e_fft, y_fft, sizeof(e_fft));
+    WebRtcAec_ScaleErrorSignal(1, 0.5f, 2e-6f, x_pow, e_fft);
+  }
+  uint64_t scale_error_ns = rtc::TimeNanos() - start;
+
+  start = rtc::TimeNanos();
+  for (int i = 0; i < kNumIterations; ++i) {
+    WebRtcAec_FilterAdaptation(kExtendedNumPartitions,
+                               i % kExtendedNumPartitions, x_fft_buf, e_fft,
+                               h_fft_buf);
+  }
+  uint64_t filter_adaptation_ns = rtc::TimeNanos() - start;
+
+  start = rtc::TimeNanos();
+  for (int i = 0; i < kNumIterations; ++i) {
+    memcpy(fft, input, sizeof(fft));
+    aec_rdft_forward_128(fft);
+    aec_rdft_inverse_128(fft);
+  }
+  uint64_t rdft_ns = rtc::TimeNanos() - start;
+
+  const std::string trace = PathName(path);
+  test::PrintResult("aec_filter_far", "", trace,
+                    static_cast<size_t>(filter_far_ns / kNumIterations), "ns",
+                    true);
+  test::PrintResult("aec_scale_error_signal", "", trace,
+                    static_cast<size_t>(scale_error_ns / kNumIterations), "ns",
+                    true);
+  test::PrintResult("aec_filter_adaptation", "", trace,
+                    static_cast<size_t>(filter_adaptation_ns / kNumIterations),
+                    "ns", true);
+  test::PrintResult("aec_rdft_128_round_trip", "", trace,
+                    static_cast<size_t>(rdft_ns / kNumIterations), "ns", true);
+
+  // Restore the function pointers selected for this CPU.
+  WebRtcAec_FreeAec(WebRtcAec_CreateAec());
+}
+
+}  // namespace
+
+TEST(AecCorePerformanceTest, Sse2) {
+  if (!WebRtc_GetCPUInfo(kSSE2))
+    return;
+  RunKernels(kSse2Path);
+}
+
+TEST(AecCorePerformanceTest, Avx2) {
+  if (!WebRtc_GetCPUInfo(kSSE2) || !WebRtc_GetCPUInfo(kAVX2) ||
+      !WebRtc_GetCPUInfo(kFMA3)) {
+    return;
+  }
+  RunKernels(kAvx2Path);
+}
+
+}  // namespace webrtc
@@ -21,12 +21,12 @@ static __inline __m128 _mm_castsi128_ps(__m128i a) { return *(__m128*)&a; }
 static __inline __m128i _mm_castps_si128(__m128 a) { return *(__m128i*)&a; }
 #endif
 
-// Constants shared by all paths (C, SSE2, NEON).
+// Constants shared by all paths (C, SSE2, AVX2, NEON).
 extern const float rdft_w[64];
 // Constants used by the C path.
 extern const float rdft_wk3ri_first[16];
 extern const float rdft_wk3ri_second[16];
-// Constants used by SSE2 and NEON but initialized in the C path.
+// Constants used by SSE2, AVX2 and NEON but initialized in the C path.
 extern ALIGN16_BEG const float ALIGN16_END rdft_wk1r[32];
 extern ALIGN16_BEG const float ALIGN16_END rdft_wk2r[32];
 extern ALIGN16_BEG const float ALIGN16_END rdft_wk3r[32];
@@ -48,6 +48,7 @@ extern RftSub128 bitrv2_128;
 // entry points
 void aec_rdft_init(void);
 void aec_rdft_init_sse2(void);
+void aec_rdft_init_avx2(void);
 void aec_rdft_forward_128(float* a);
 void aec_rdft_inverse_128(float* a);
 
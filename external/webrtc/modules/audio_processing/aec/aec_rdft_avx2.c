@@ -0,0 +1,293 @@
+/*
+ *  Copyright (c) 2016 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "webrtc/modules/audio_processing/aec/aec_rdft.h"
+
+#include <immintrin.h>
+
+// The AVX2 versions run two consecutive iterations of the SSE2 loops at once,
+// one in each 128-bit lane. All shuffles then stay within the lanes, exactly
+// as in the SSE2 code. cftmdl_128 keeps its SSE2 version since its stride
+// pattern does not pair up.
+
+static const ALIGN16_BEG float ALIGN16_END
+    k_swap_sign[4] = {-1.f, 1.f, -1.f, 1.f};
+
+// Loads four floats from |lo| into the low lane and four from |hi| into the
+// high lane.
+static __inline __m256 LoadLanes(const float* lo, const float* hi) {
+  return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(lo)),
+                              _mm_loadu_ps(hi), 1);
+}
+
+static __inline void StoreLanes(float* lo, float* hi, __m256 v) {
+  _mm_storeu_ps(lo, _mm256_castps256_ps128(v));
+  _mm_storeu_ps(hi, _mm256_extractf128_ps(v, 1));
+}
+
+static void cft1st_128_AVX2(float* a) {
+  const __m256 mm_swap_sign =
+      _mm256_broadcast_ps((const __m128*)k_swap_sign);
+  int j, k2;
+
+  for (k2 = 0, j = 0; j < 128; j += 32, k2 += 8) {
+    __m256 a00v = LoadLanes(&a[j + 0], &a[j + 16]);
+    __m256 a04v = LoadLanes(&a[j + 4], &a[j + 20]);
+    __m256 a08v = LoadLanes(&a[j + 8], &a[j + 24]);
+    __m256 a12v = LoadLanes(&a[j + 12], &a[j + 28]);
+    __m256 a01v = _mm256_shuffle_ps(a00v, a08v, _MM_SHUFFLE(1, 0, 1, 0));
+    __m256 a23v = _mm256_shuffle_ps(a00v, a08v, _MM_SHUFFLE(3, 2, 3, 2));
+    __m256 a45v = _mm256_shuffle_ps(a04v, a12v, _MM_SHUFFLE(1, 0, 1, 0));
+    __m256 a67v = _mm256_shuffle_ps(a04v, a12v, _MM_SHUFFLE(3, 2, 3, 2));
+
+    const __m256 wk1rv = _mm256_loadu_ps(&rdft_wk1r[k2]);
+    const __m256 wk1iv = _mm256_loadu_ps(&rdft_wk1i[k2]);
+    const __m256 wk2rv = _mm256_loadu_ps(&rdft_wk2r[k2]);
+    const __m256 wk2iv = _mm256_loadu_ps(&rdft_wk2i[k2]);
+    const __m256 wk3rv = _mm256_loadu_ps(&rdft_wk3r[k2]);
+    const __m256 wk3iv = _mm256_loadu_ps(&rdft_wk3i[k2]);
+    __m256 x0v = _mm256_add_ps(a01v, a23v);
+    const __m256 x1v = _mm256_sub_ps(a01v, a23v);
+    const __m256 x2v = _mm256_add_ps(a45v, a67v);
+    const __m256 x3v = _mm256_sub_ps(a45v, a67v);
+    __m256 x0w;
+    a01v = _mm256_add_ps(x0v, x2v);
+    x0v = _mm256_sub_ps(x0v, x2v);
+    x0w = _mm256_shuffle_ps(x0v, x0v, _MM_SHUFFLE(2, 3, 0, 1));
+    {
+      const __m256 a45_0v = _mm256_mul_ps(wk2rv, x0v);
+      const __m256 a45_1v = _mm256_mul_ps(wk2iv, x0w);
+      a45v = _mm256_add_ps(a45_0v, a45_1v);
+    }
+    {
+      __m256 a23_0v, a23_1v;
+      const __m256 x3w = _mm256_shuffle_ps(x3v, x3v, _MM_SHUFFLE(2, 3, 0, 1));
+      const __m256 x3s = _mm256_mul_ps(mm_swap_sign, x3w);
+      x0v = _mm256_add_ps(x1v, x3s);
+      x0w = _mm256_shuffle_ps(x0v, x0v, _MM_SHUFFLE(2, 3, 0, 1));
+      a23_0v = _mm256_mul_ps(wk1rv, x0v);
+      a23_1v = _mm256_mul_ps(wk1iv, x0w);
+      a23v = _mm256_add_ps(a23_0v, a23_1v);
+
+      x0v = _mm256_sub_ps(x1v, x3s);
+      x0w = _mm256_shuffle_ps(x0v, x0v, _MM_SHUFFLE(2, 3, 0, 1));
+    }
+    {
+      const __m256 a67_0v = _mm256_mul_ps(wk3rv, x0v);
+      const __m256 a67_1v = _mm256_mul_ps(wk3iv, x0w);
+      a67v = _mm256_add_ps(a67_0v, a67_1v);
+    }
+
+    a00v = _mm256_shuffle_ps(a01v, a23v, _MM_SHUFFLE(1, 0, 1, 0));
+    a04v = _mm256_shuffle_ps(a45v, a67v, _MM_SHUFFLE(1, 0, 1, 0));
+    a08v = _mm256_shuffle_ps(a01v, a23v, _MM_SHUFFLE(3, 2, 3, 2));
+    a12v = _mm256_shuffle_ps(a45v, a67v, _MM_SHUFFLE(3, 2, 3, 2));
+    StoreLanes(&a[j + 0], &a[j + 16], a00v);
+    StoreLanes(&a[j + 4], &a[j + 20], a04v);
+    StoreLanes(&a[j + 8], &a[j + 24], a08v);
+    StoreLanes(&a[j + 12], &a[j + 28], a12v);
+  }
+}
+
+static void rftfsub_128_AVX2(float* a) {
+  const float* c = rdft_w + 32;
+  int j1, j2, k1, k2;
+  float wkr, wki, xr, xi, yr, yi;
+
+  const __m256 mm_half = _mm256_set1_ps(0.5f);
+
+  // Vectorized code (eight at once).
+  //    Note: commented number are indexes for the first iteration of the loop
+  //    in the low lane; the high lane holds the next SSE2 iteration (+8).
+  for (j1 = 1, j2 = 2; j2 + 15 < 64; j1 += 8, j2 += 16) {
+    // Load 'wk'.
+    const __m256 c_j1 = _mm256_loadu_ps(&c[j1]);  //  1,  2,  3,  4,
+    const __m256 c_k1 = LoadLanes(&c[29 - j1], &c[25 - j1]);
+                                                   // 28, 29, 30, 31,
+    const __m256 wkrt = _mm256_sub_ps(mm_half, c_k1);  // 28, 29, 30, 31,
+    const __m256 wkr_ = _mm256_shuffle_ps(
+        wkrt, wkrt, _MM_SHUFFLE(0, 1, 2, 3));  // 31, 30, 29, 28,
+    const __m256 wki_ = c_j1;                  //  1,  2,  3,  4,
+    // Load and shuffle 'a'.
+    const __m256 a_j2_0 = LoadLanes(&a[0 + j2], &a[8 + j2]);
+                                                 //   2,   3,   4,   5,
+    const __m256 a_j2_4 = LoadLanes(&a[4 + j2], &a[12 + j2]);
+                                                 //   6,   7,   8,   9,
+    const __m256 a_k2_0 = LoadLanes(&a[122 - j2], &a[114 - j2]);
+                                                 // 120, 121, 122, 123,
+    const __m256 a_k2_4 = LoadLanes(&a[126 - j2], &a[118 - j2]);
+                                                 // 124, 125, 126, 127,
+    const __m256 a_j2_p0 = _mm256_shuffle_ps(
+        a_j2_0, a_j2_4, _MM_SHUFFLE(2, 0, 2, 0));  //   2,   4,   6,   8,
+    const __m256 a_j2_p1 = _mm256_shuffle_ps(
+        a_j2_0, a_j2_4, _MM_SHUFFLE(3, 1, 3, 1));  //   3,   5,   7,   9,
+    const __m256 a_k2_p0 = _mm256_shuffle_ps(
+        a_k2_4, a_k2_0, _MM_SHUFFLE(0, 2, 0, 2));  // 126, 124, 122, 120,
+    const __m256 a_k2_p1 = _mm256_shuffle_ps(
+        a_k2_4, a_k2_0, _MM_SHUFFLE(1, 3, 1, 3));  // 127, 125, 123, 121,
+    // Calculate 'x'.
+    const __m256 xr_ = _mm256_sub_ps(a_j2_p0, a_k2_p0);
+    // 2-126, 4-124, 6-122, 8-120,
+    const __m256 xi_ = _mm256_add_ps(a_j2_p1, a_k2_p1);
+    // 3-127, 5-125, 7-123, 9-121,
+    // Calculate product into 'y'.
+    //    yr = wkr * xr - wki * xi;
+    //    yi = wkr * xi + wki * xr;
+    const __m256 a_ = _mm256_mul_ps(wkr_, xr_);
+    const __m256 b_ = _mm256_mul_ps(wki_, xi_);
+    const __m256 c_ = _mm256_mul_ps(wkr_, xi_);
+    const __m256 d_ = _mm256_mul_ps(wki_, xr_);
+    const __m256 yr_ = _mm256_sub_ps(a_, b_);  // 2-126, 4-124, 6-122, 8-120,
+    const __m256 yi_ = _mm256_add_ps(c_, d_);  // 3-127, 5-125, 7-123, 9-121,
+    // Update 'a'.
+    //    a[j2 + 0] -= yr;
+    //    a[j2 + 1] -= yi;
+    //    a[k2 + 0] += yr;
+    //    a[k2 + 1] -= yi;
+    const __m256 a_j2_p0n = _mm256_sub_ps(a_j2_p0, yr_);  //   2,   4,   6,   8,
+    const __m256 a_j2_p1n = _mm256_sub_ps(a_j2_p1, yi_);  //   3,   5,   7,   9,
+    const __m256 a_k2_p0n = _mm256_add_ps(a_k2_p0, yr_);  // 126, 124, 122, 120,
+    const __m256 a_k2_p1n = _mm256_sub_ps(a_k2_p1, yi_);  // 127, 125, 123, 121,
+    // Shuffle in right order and store.
+    const __m256 a_j2_0n = _mm256_unpacklo_ps(a_j2_p0n, a_j2_p1n);
+    //   2,   3,   4,   5,
+    const __m256 a_j2_4n = _mm256_unpackhi_ps(a_j2_p0n, a_j2_p1n);
+    //   6,   7,   8,   9,
+    const __m256 a_k2_0nt = _mm256_unpackhi_ps(a_k2_p0n, a_k2_p1n);
+    // 122, 123, 120, 121,
+    const __m256 a_k2_4nt = _mm256_unpacklo_ps(a_k2_p0n, a_k2_p1n);
+    // 126, 127, 124, 125,
+    const __m256 a_k2_0n = _mm256_shuffle_ps(
+        a_k2_0nt, a_k2_0nt, _MM_SHUFFLE(1, 0, 3, 2));  // 120, 121, 122, 123,
+    const __m256 a_k2_4n = _mm256_shuffle_ps(
+        a_k2_4nt, a_k2_4nt, _MM_SHUFFLE(1, 0, 3, 2));  // 124, 125, 126, 127,
+    StoreLanes(&a[0 + j2], &a[8 + j2], a_j2_0n);
+    StoreLanes(&a[4 + j2], &a[12 + j2], a_j2_4n);
+    StoreLanes(&a[122 - j2], &a[114 - j2], a_k2_0n);
+    StoreLanes(&a[126 - j2], &a[118 - j2], a_k2_4n);
+  }
+  // Scalar code for the remaining items.
+  for (; j2 < 64; j1 += 1, j2 += 2) {
+    k2 = 128 - j2;
+    k1 = 32 - j1;
+    wkr = 0.5f - c[k1];
+    wki = c[j1];
+    xr = a[j2 + 0] - a[k2 + 0];
+    xi = a[j2 + 1] + a[k2 + 1];
+    yr = wkr * xr - wki * xi;
+    yi = wkr * xi + wki * xr;
+    a[j2 + 0] -= yr;
+    a[j2 + 1] -= yi;
+    a[k2 + 0] += yr;
+    a[k2 + 1] -= yi;
+  }
+}
+
+static void rftbsub_128_AVX2(float* a) {
+  const float* c = rdft_w + 32;
+  int j1, j2, k1, k2;
+  float wkr, wki, xr, xi, yr, yi;
+
+  const __m256 mm_half = _mm256_set1_ps(0.5f);
+
+  a[1] = -a[1];
+  // Vectorized code (eight at once).
+  //    Note: commented number are indexes for the first iteration of the loop
+  //    in the low lane; the high lane holds the next SSE2 iteration (+8).
+  for (j1 = 1, j2 = 2; j2 + 15 < 64; j1 += 8, j2 += 16) {
+    // Load 'wk'.
+    const __m256 c_j1 = _mm256_loadu_ps(&c[j1]);  //  1,  2,  3,  4,
+    const __m256 c_k1 = LoadLanes(&c[29 - j1], &c[25 - j1]);
+                                                   // 28, 29, 30, 31,
+    const __m256 wkrt = _mm256_sub_ps(mm_half, c_k1);  // 28, 29, 30, 31,
+    const __m256 wkr_ = _mm256_shuffle_ps(
+        wkrt, wkrt, _MM_SHUFFLE(0, 1, 2, 3));  // 31, 30, 29, 28,
+    const __m256 wki_ = c_j1;                  //  1,  2,  3,  4,
+    // Load and shuffle 'a'.
+    const __m256 a_j2_0 = LoadLanes(&a[0 + j2], &a[8 + j2]);
+                                                 //   2,   3,   4,   5,
+    const __m256 a_j2_4 = LoadLanes(&a[4 + j2], &a[12 + j2]);
+                                                 //   6,   7,   8,   9,
+    const __m256 a_k2_0 = LoadLanes(&a[122 - j2], &a[114 - j2]);
+                                                 // 120, 121, 122, 123,
+    const __m256 a_k2_4 = LoadLanes(&a[126 - j2], &a[118 - j2]);
+                                                 // 124, 125, 126, 127,
+    const __m256 a_j2_p0 = _mm256_shuffle_ps(
+        a_j2_0, a_j2_4, _MM_SHUFFLE(2, 0, 2, 0));  //   2,   4,   6,   8,
+    const __m256 a_j2_p1 = _mm256_shuffle_ps(
+        a_j2_0, a_j2_4, _MM_SHUFFLE(3, 1, 3, 1));  //   3,   5,   7,   9,
+    const __m256 a_k2_p0 = _mm256_shuffle_ps(
+        a_k2_4, a_k2_0, _MM_SHUFFLE(0, 2, 0, 2));  // 126, 124, 122, 120,
+    const __m256 a_k2_p1 = _mm256_shuffle_ps(
+        a_k2_4, a_k2_0, _MM_SHUFFLE(1, 3, 1, 3));  // 127, 125, 123, 121,
+    // Calculate 'x'.
+    const __m256 xr_ = _mm256_sub_ps(a_j2_p0, a_k2_p0);
+    // 2-126, 4-124, 6-122, 8-120,
+    const __m256 xi_ = _mm256_add_ps(a_j2_p1, a_k2_p1);
+    // 3-127, 5-125, 7-123, 9-121,
+    // Calculate product into 'y'.
+    //    yr = wkr * xr + wki * xi;
+    //    yi = wkr * xi - wki * xr;
+    const __m256 a_ = _mm256_mul_ps(wkr_, xr_);
+    const __m256 b_ = _mm256_mul_ps(wki_, xi_);
+    const __m256 c_ = _mm256_mul_ps(wkr_, xi_);
+    const __m256 d_ = _mm256_mul_ps(wki_, xr_);
+    const __m256 yr_ = _mm256_add_ps(a_, b_);  // 2-126, 4-124, 6-122, 8-120,
+    const __m256 yi_ = _mm256_sub_ps(c_, d_);  // 3-127, 5-125, 7-123, 9-121,
+    // Update 'a'.
+    //    a[j2 + 0] = a[j2 + 0] - yr;
+    //    a[j2 + 1] = yi - a[j2 + 1];
+    //    a[k2 + 0] = yr + a[k2 + 0];
+    //    a[k2 + 1] = yi - a[k2 + 1];
+    const __m256 a_j2_p0n = _mm256_sub_ps(a_j2_p0, yr_);  //   2,   4,   6,   8,
+    const __m256 a_j2_p1n = _mm256_sub_ps(yi_, a_j2_p1);  //   3,   5,   7,   9,
+    const __m256 a_k2_p0n = _mm256_add_ps(a_k2_p0, yr_);  // 126, 124, 122, 120,
+    const __m256 a_k2_p1n = _mm256_sub_ps(yi_, a_k2_p1);  // 127, 125, 123, 121,
+    // Shuffle in right order and store.
+    const __m256 a_j2_0n = _mm256_unpacklo_ps(a_j2_p0n, a_j2_p1n);
+    //   2,   3,   4,   5,
+    const __m256 a_j2_4n = _mm256_unpackhi_ps(a_j2_p0n, a_j2_p1n);
+    //   6,   7,   8,   9,
+    const __m256 a_k2_0nt = _mm256_unpackhi_ps(a_k2_p0n, a_k2_p1n);
+    // 122, 123, 120, 121,
+    const __m256 a_k2_4nt = _mm256_unpacklo_ps(a_k2_p0n, a_k2_p1n);
+    // 126, 127, 124, 125,
+    const __m256 a_k2_0n = _mm256_shuffle_ps(
+        a_k2_0nt, a_k2_0nt, _MM_SHUFFLE(1, 0, 3, 2));  // 120, 121, 122, 123,
+    const __m256 a_k2_4n = _mm256_shuffle_ps(
+        a_k2_4nt, a_k2_4nt, _MM_SHUFFLE(1, 0, 3, 2));  // 124, 125, 126, 127,
+    StoreLanes(&a[0 + j2], &a[8 + j2], a_j2_0n);
+    StoreLanes(&a[4 + j2], &a[12 + j2], a_j2_4n);
+    StoreLanes(&a[122 - j2], &a[114 - j2], a_k2_0n);
+    StoreLanes(&a[126 - j2], &a[118 - j2], a_k2_4n);
+  }
+  // Scalar code for the remaining items.
+  for (; j2 < 64; j1 += 1, j2 += 2) {
+    k2 = 128 - j2;
+    k1 = 32 - j1;
+    wkr = 0.5f - c[k1];
+    wki = c[j1];
+    xr = a[j2 + 0] - a[k2 + 0];
+    xi = a[j2 + 1] + a[k2 + 1];
+    yr = wkr * xr + wki * xi;
+    yi = wkr * xi - wki * xr;
+    a[j2 + 0] = a[j2 + 0] - yr;
+    a[j2 + 1] = yi - a[j2 + 1];
+    a[k2 + 0] = yr + a[k2 + 0];
+    a[k2 + 1] = yi - a[k2 + 1];
+  }
+  a[65] = -a[65];
+}
+
+void aec_rdft_init_avx2(void) {
+  cft1st_128 = cft1st_128_AVX2;
+  rftfsub_128 = rftfsub_128_AVX2;
+  rftbsub_128 = rftbsub_128_AVX2;
+}
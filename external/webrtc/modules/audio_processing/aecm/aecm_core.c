@@ -360,6 +360,23 @@ static void ResetAdaptiveChannelC(AecmCore* aecm) {
     aecm->channelAdapt32[i] = (int32_t)aecm->channelStored[i] << 16;
 }
 
+void WebRtcAecm_InitC(void)
+{
+  WebRtcAecm_CalcLinearEnergies = CalcLinearEnergiesC;
+  WebRtcAecm_StoreAdaptiveChannel = StoreAdaptiveChannelC;
+  WebRtcAecm_ResetAdaptiveChannel = ResetAdaptiveChannelC;
+}
+
+// Initialize function pointers for x86 platforms with SSE4.1.
+#if defined(WEBRTC_ARCH_X86_FAMILY)
+static void WebRtcAecm_InitSSE41(void)
+{
+  WebRtcAecm_StoreAdaptiveChannel = WebRtcAecm_StoreAdaptiveChannelSSE41;
+  WebRtcAecm_ResetAdaptiveChannel = WebRtcAecm_ResetAdaptiveChannelSSE41;
+  WebRtcAecm_CalcLinearEnergies = WebRtcAecm_CalcLinearEnergiesSSE41;
+}
+#endif
+
 // Initialize function pointers for ARM Neon platform.
 #if (defined WEBRTC_DETECT_NEON || defined WEBRTC_HAS_NEON)
 static void WebRtcAecm_InitNeon(void)
@@ -504,9 +521,14 @@ int WebRtcAecm_InitCore(AecmCore* const aecm, int samplingFreq) {
     COMPILE_ASSERT(PART_LEN % 16 == 0);
 
     // Initialize function pointers.
-    WebRtcAecm_CalcLinearEnergies = CalcLinearEnergiesC;
-    WebRtcAecm_StoreAdaptiveChannel = StoreAdaptiveChannelC;
-    WebRtcAecm_ResetAdaptiveChannel = ResetAdaptiveChannelC;
+    WebRtcAecm_InitC();
+
+#if defined(WEBRTC_ARCH_X86_FAMILY)
+    if (WebRtc_GetCPUInfo(kSSE4_1))
+    {
+      WebRtcAecm_InitSSE41();
+    }
+#endif
 
 #ifdef WEBRTC_DETECT_NEON
     uint64_t features = WebRtc_GetCPUFeaturesARM();
@@ -397,6 +397,11 @@ extern StoreAdaptiveChannel WebRtcAecm_StoreAdaptiveChannel;
 typedef void (*ResetAdaptiveChannel)(AecmCore* aecm);
 extern ResetAdaptiveChannel WebRtcAecm_ResetAdaptiveChannel;
 
+// Points the function pointers above to the generic C versions.
+// WebRtcAecm_InitCore() does this before it selects the platform specific
+// versions, and tests use it to get the reference implementation.
+void WebRtcAecm_InitC(void);
+
 // For the above function pointers, functions for generic platforms are declared
 // and defined as static in file aecm_core.c, while those for ARM Neon platforms
 // are declared below and defined in file aecm_core_neon.c.
@@ -415,6 +420,22 @@ void WebRtcAecm_StoreAdaptiveChannelNeon(AecmCore* aecm,
 void WebRtcAecm_ResetAdaptiveChannelNeon(AecmCore* aecm);
 #endif
 
+// Functions for x86 platforms with SSE4.1, defined in file aecm_core_sse41.c.
+#if defined(WEBRTC_ARCH_X86_FAMILY)
+void WebRtcAecm_CalcLinearEnergiesSSE41(AecmCore* aecm,
+                                        const uint16_t* far_spectrum,
+                                        int32_t* echo_est,
+                                        uint32_t* far_energy,
+                                        uint32_t* echo_energy_adapt,
+                                        uint32_t* echo_energy_stored);
+
+void WebRtcAecm_StoreAdaptiveChannelSSE41(AecmCore* aecm,
+                                          const uint16_t* far_spectrum,
+                                          int32_t* echo_est);
+
+void WebRtcAecm_ResetAdaptiveChannelSSE41(AecmCore* aecm);
+#endif
+
 #if defined(MIPS32_LE)
 void WebRtcAecm_CalcLinearEnergies_mips(AecmCore* aecm,
                                         const uint16_t* far_spectrum,
@@ -0,0 +1,130 @@
+/*
+ *  Copyright (c) 2016 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+// The functions in this file are bit-exact with the generic C versions in
+// aecm_core.c.
+
+#include "webrtc/modules/audio_processing/aecm/aecm_core.h"
+
+#include <smmintrin.h>
+#include <string.h>
+
+// WEBRTC_SPL_MUL_16_U16() of the low (|high| == 0) or high four values of
+// |a| and |b|.
+static __inline __m128i Mul16U16(__m128i a, __m128i b, int high) {
+  if (high) {
+    a = _mm_srli_si128(a, 8);
+    b = _mm_srli_si128(b, 8);
+  }
+  return _mm_mullo_epi32(_mm_cvtepi16_epi32(a), _mm_cvtepu16_epi32(b));
+}
+
+static __inline uint32_t AddLanes(__m128i v) {
+  v = _mm_add_epi32(v, _mm_srli_si128(v, 8));
+  v = _mm_add_epi32(v, _mm_srli_si128(v, 4));
+  return (uint32_t)_mm_cvtsi128_si32(v);
+}
+
+void WebRtcAecm_CalcLinearEnergiesSSE41(AecmCore* aecm,
+                                        const uint16_t* far_spectrum,
+                                        int32_t* echo_est,
+                                        uint32_t* far_energy,
+                                        uint32_t* echo_energy_adapt,
+                                        uint32_t* echo_energy_stored) {
+  __m128i far_energy_v = _mm_setzero_si128();
+  __m128i echo_adapt_v = _mm_setzero_si128();
+  __m128i echo_stored_v = _mm_setzero_si128();
+  int i;
+
+  // Get energy for the delayed far end signal and estimated
+  // echo using both stored and adapted channels.
+  // The C code:
+  //  for (i = 0; i < PART_LEN1; i++) {
+  //      echo_est[i] = WEBRTC_SPL_MUL_16_U16(aecm->channelStored[i],
+  //                                         far_spectrum[i]);
+  //      (*far_energy) += (uint32_t)(far_spectrum[i]);
+  //      *echo_energy_adapt += aecm->channelAdapt16[i] * far_spectrum[i];
+  //      (*echo_energy_stored) += (uint32_t)echo_est[i];
+  //  }
+  for (i = 0; i < PART_LEN; i += 8) {
+    const __m128i spectrum =
+        _mm_loadu_si128((const __m128i*)&far_spectrum[i]);
+    const __m128i stored =
+        _mm_loadu_si128((const __m128i*)&aecm->channelStored[i]);
+    const __m128i adapt =
+        _mm_loadu_si128((const __m128i*)&aecm->channelAdapt16[i]);
+    const __m128i echo_est_low = Mul16U16(stored, spectrum, 0);
+    const __m128i echo_est_high = Mul16U16(stored, spectrum, 1);
+
+    _mm_storeu_si128((__m128i*)&echo_est[i], echo_est_low);
+    _mm_storeu_si128((__m128i*)&echo_est[i + 4], echo_est_high);
+
+    far_energy_v = _mm_add_epi32(far_energy_v, _mm_cvtepu16_epi32(spectrum));
+    far_energy_v = _mm_add_epi32(
+        far_energy_v, _mm_cvtepu16_epi32(_mm_srli_si128(spectrum, 8)));
+    echo_stored_v = _mm_add_epi32(echo_stored_v, echo_est_low);
+    echo_stored_v = _mm_add_epi32(echo_stored_v, echo_est_high);
+    echo_adapt_v = _mm_add_epi32(echo_adapt_v, Mul16U16(adapt, spectrum, 0));
+    echo_adapt_v = _mm_add_epi32(echo_adapt_v, Mul16U16(adapt, spectrum, 1));
+  }
+
+  *far_energy += AddLanes(far_energy_v);
+  *echo_energy_stored += AddLanes(echo_stored_v);
+  *echo_energy_adapt += AddLanes(echo_adapt_v);
+
+  echo_est[PART_LEN] = WEBRTC_SPL_MUL_16_U16(aecm->channelStored[PART_LEN],
+                                             far_spectrum[PART_LEN]);
+  *echo_energy_stored += (uint32_t)echo_est[PART_LEN];
+  *far_energy += (uint32_t)far_spectrum[PART_LEN];
+  *echo_energy_adapt += aecm->channelAdapt16[PART_LEN] * far_spectrum[PART_LEN];
+}
+
+void WebRtcAecm_StoreAdaptiveChannelSSE41(AecmCore* aecm,
+                                          const uint16_t* far_spectrum,
+                                          int32_t* echo_est) {
+  int i;
+
+  // During startup we store the channel every block, and recalculate the
+  // echo estimate.
+  for (i = 0; i < PART_LEN; i += 8) {
+    const __m128i spectrum =
+        _mm_loadu_si128((const __m128i*)&far_spectrum[i]);
+    const __m128i adapt =
+        _mm_loadu_si128((const __m128i*)&aecm->channelAdapt16[i]);
+    _mm_storeu_si128((__m128i*)&aecm->channelStored[i], adapt);
+    _mm_storeu_si128((__m128i*)&echo_est[i], Mul16U16(adapt, spectrum, 0));
+    _mm_storeu_si128((__m128i*)&echo_est[i + 4],
+                     Mul16U16(adapt, spectrum, 1));
+  }
+  aecm->channelStored[PART_LEN] = aecm->channelAdapt16[PART_LEN];
+  echo_est[PART_LEN] = WEBRTC_SPL_MUL_16_U16(aecm->channelStored[PART_LEN],
+                                             far_spectrum[PART_LEN]);
+}
+
+void WebRtcAecm_ResetAdaptiveChannelSSE41(AecmCore* aecm) {
+  const __m128i zero = _mm_setzero_si128();
+  int i;
+
+  // The stored channel has a significantly lower MSE than the adaptive one for
+  // two consecutive calculations. Reset the adaptive channel, and restore the
+  // W32 channel.
+  for (i = 0; i < PART_LEN; i += 8) {
+    const __m128i stored =
+        _mm_loadu_si128((const __m128i*)&aecm->channelStored[i]);
+    _mm_storeu_si128((__m128i*)&aecm->channelAdapt16[i], stored);
+    // Interleaving with zeros below gives stored << 16.
+    _mm_storeu_si128((__m128i*)&aecm->channelAdapt32[i],
+                     _mm_unpacklo_epi16(zero, stored));
+    _mm_storeu_si128((__m128i*)&aecm->channelAdapt32[i + 4],
+                     _mm_unpackhi_epi16(zero, stored));
+  }
+  aecm->channelAdapt16[PART_LEN] = aecm->channelStored[PART_LEN];
+  aecm->channelAdapt32[PART_LEN] = (int32_t)aecm->channelStored[PART_LEN] << 16;
+}
@@ -0,0 +1,133 @@
+/*
+ *  Copyright (c) 2016 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "testing/gtest/include/gtest/gtest.h"
+extern "C" {
+#include "webrtc/modules/audio_processing/aecm/aecm_core.h"
+}
+#include "webrtc/system_wrappers/include/cpu_features_wrapper.h"
+
+namespace webrtc {
+namespace {
+
+const int kNumTrials = 100;
+
+// The tests pass without running anything on CPUs without SSE4.1, so say so.
+bool HasSse41() {
+  if (WebRtc_GetCPUInfo(kSSE4_1))
+    return true;
+  printf("Skipping test: the CPU does not support SSE4.1.\n");
+  return false;
+}
+
+int16_t RandomInt16() {
+  return static_cast<int16_t>(rand() & 0xFFFF);
+}
+
+// Full range channels and spectra, so that both the signed by unsigned
+// products and the 32-bit energy sums wrap around.
+class AecmSse41Test : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    srand(42);
+    c_ = WebRtcAecm_CreateCore();
+    sse41_ = WebRtcAecm_CreateCore();
+    ASSERT_TRUE(c_ != NULL);
+    ASSERT_TRUE(sse41_ != NULL);
+    ASSERT_EQ(0, WebRtcAecm_InitCore(c_, 16000));
+    ASSERT_EQ(0, WebRtcAecm_InitCore(sse41_, 16000));
+    WebRtcAecm_InitC();
+  }
+
+  void TearDown() override {
+    WebRtcAecm_FreeCore(c_);
+    WebRtcAecm_FreeCore(sse41_);
+  }
+
+  void Randomize() {
+    for (int i = 0; i < PART_LEN1; ++i) {
+      far_spectrum_[i] = static_cast<uint16_t>(RandomInt16());
+      c_->channelStored[i] = sse41_->channelStored[i] = RandomInt16();
+      c_->channelAdapt16[i] = sse41_->channelAdapt16[i] = RandomInt16();
+      c_->channelAdapt32[i] = sse41_->channelAdapt32[i] = rand();
+    }
+  }
+
+  void ExpectChannelsEqual() {
+    for (int i = 0; i < PART_LEN1; ++i) {
+      ASSERT_EQ(c_->channelStored[i], sse41_->channelStored[i]);
+      ASSERT_EQ(c_->channelAdapt16[i], sse41_->channelAdapt16[i]);
+      ASSERT_EQ(c_->channelAdapt32[i], sse41_->channelAdapt32[i]);
+    }
+  }
+
+  static void ExpectEchoEqual(const int32_t* expected, const int32_t* actual) {
+    for (int i = 0; i < PART_LEN1; ++i) {
+      ASSERT_EQ(expected[i], actual[i]) << "at index " << i;
+    }
+  }
+
+  AecmCore* c_;
+  AecmCore* sse41_;
+  uint16_t far_spectrum_[PART_LEN1];
+  int32_t c_echo_[PART_LEN1];
+  int32_t sse41_echo_[PART_LEN1];
+};
+
+TEST_F(AecmSse41Test, CalcLinearEnergiesIsBitExact) {
+  if (!HasSse41())
+    return;
+  for (int trial = 0; trial < kNumTrials; ++trial) {
+    Randomize();
+    // The energies are accumulated onto the passed in values.
+    uint32_t c_energies[3] = {static_cast<uint32_t>(rand()), 0, 7};
+    uint32_t sse41_energies[3];
+    memcpy(sse41_energies, c_energies, sizeof(c_energies));
+    WebRtcAecm_CalcLinearEnergies(c_, far_spectrum_, c_echo_, &c_energies[0],
+                                  &c_energies[1], &c_energies[2]);
+    WebRtcAecm_CalcLinearEnergiesSSE41(sse41_, far_spectrum_, sse41_echo_,
+                                       &sse41_energies[0], &sse41_energies[1],
+                                       &sse41_energies[2]);
+    ASSERT_NO_FATAL_FAILURE(ExpectEchoEqual(c_echo_, sse41_echo_));
+    EXPECT_EQ(c_energies[0], sse41_energies[0]);
+    EXPECT_EQ(c_energies[1], sse41_energies[1]);
+    EXPECT_EQ(c_energies[2], sse41_energies[2]);
+  }
+}
+
+TEST_F(AecmSse41Test, StoreAdaptiveChannelIsBitExact) {
+  if (!HasSse41())
+    return;
+  for (int trial = 0; trial < kNumTrials; ++trial) {
+    Randomize();
+    WebRtcAecm_StoreAdaptiveChannel(c_, far_spectrum_, c_echo_);
+    WebRtcAecm_StoreAdaptiveChannelSSE41(sse41_, far_spectrum_, sse41_echo_);
+    ASSERT_NO_FATAL_FAILURE(ExpectEchoEqual(c_echo_, sse41_echo_));
+    ASSERT_NO_FATAL_FAILURE(ExpectChannelsEqual());
+  }
+}
+
+TEST_F(AecmSse41Test, ResetAdaptiveChannelIsBitExact) {
+  if (!HasSse41())
+    return;
+  for (int trial = 0; trial < kNumTrials; ++trial) {
+    Randomize();
+    WebRtcAecm_ResetAdaptiveChannel(c_);
+    WebRtcAecm_ResetAdaptiveChannelSSE41(sse41_);
+    ASSERT_NO_FATAL_FAILURE(ExpectChannelsEqual());
+  }
+}
+
+}  // namespace
+}  // namespace webrtc
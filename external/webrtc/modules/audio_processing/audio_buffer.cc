@@ -113,7 +113,7 @@ void AudioBuffer::CopyFrom(const float* const* data,
       num_input_channels_ > 1 && num_proc_channels_ == 1;
   if (need_to_downmix && !input_buffer_) {
     input_buffer_.reset(
-        new IFChannelBuffer(input_num_frames_, num_proc_channels_));
+        new ChannelBuffer<float>(input_num_frames_, num_proc_channels_));
   }
 
   if (stream_config.has_keyboard()) {
@@ -124,8 +124,8 @@ void AudioBuffer::CopyFrom(const float* const* data,
   const float* const* data_ptr = data;
   if (need_to_downmix) {
     DownmixToMono<float, float>(data, input_num_frames_, num_input_channels_,
-                                input_buffer_->fbuf()->channels()[0]);
-    data_ptr = input_buffer_->fbuf_const()->channels();
+                                input_buffer_->channels()[0]);
+    data_ptr = input_buffer_->channels();
   }
 
   // Resample.
@@ -143,7 +143,7 @@ void AudioBuffer::CopyFrom(const float* const* data,
   for (int i = 0; i < num_proc_channels_; ++i) {
     FloatToFloatS16(data_ptr[i],
                     proc_num_frames_,
-                    data_->fbuf()->channels()[i]);
+                    data_->fbuf_for_overwrite()->channels()[i]);
   }
 }
 
@@ -159,7 +159,7 @@ void AudioBuffer::CopyTo(const StreamConfig& stream_config,
     data_ptr = process_buffer_->channels();
   }
   for (int i = 0; i < num_channels_; ++i) {
-    FloatS16ToFloat(data_->fbuf()->channels()[i],
+    FloatS16ToFloat(data_->fbuf_const()->channels()[i],
                     proc_num_frames_,
                     data_ptr[i]);
   }
@@ -361,6 +361,11 @@ size_t AudioBuffer::num_bands() const {
   return num_bands_;
 }
 
+size_t AudioBuffer::num_format_conversions() const {
+  return data_->num_conversions() +
+         (split_data_.get() ? split_data_->num_conversions() : 0);
+}
+
 // The resampler is only for supporting 48kHz to 16kHz in the reverse stream.
 void AudioBuffer::DeinterleaveFrom(AudioFrame* frame) {
   assert(frame->num_channels_ == num_input_channels_);
@@ -369,34 +374,37 @@ void AudioBuffer::DeinterleaveFrom(AudioFrame* frame) {
   // Initialized lazily because there's a different condition in CopyFrom.
   if ((input_num_frames_ != proc_num_frames_) && !input_buffer_) {
     input_buffer_.reset(
-        new IFChannelBuffer(input_num_frames_, num_proc_channels_));
+        new ChannelBuffer<float>(input_num_frames_, num_proc_channels_));
   }
   activity_ = frame->vad_activity_;
 
-  int16_t* const* deinterleaved;
+  // Deinterleave, downmix and convert to float in a single pass, straight into
+  // the processing buffer when no resampling is needed. The int16 view of the
+  // data is then only computed if a component asks for it.
+  float* const* deinterleaved;
   if (input_num_frames_ == proc_num_frames_) {
-    deinterleaved = data_->ibuf()->channels();
+    deinterleaved = data_->fbuf_for_overwrite()->channels();
   } else {
-    deinterleaved = input_buffer_->ibuf()->channels();
+    deinterleaved = input_buffer_->channels();
   }
   if (num_proc_channels_ == 1) {
-    // Downmix and deinterleave simultaneously.
-    DownmixInterleavedToMono(frame->data_, input_num_frames_,
-                             num_input_channels_, deinterleaved[0]);
+    DownmixInterleavedS16ToMonoFloatS16(frame->data_, input_num_frames_,
+                                        num_input_channels_, deinterleaved[0]);
   } else {
     assert(num_proc_channels_ == num_input_channels_);
-    Deinterleave(frame->data_,
-                 input_num_frames_,
-                 num_proc_channels_,
-                 deinterleaved);
+    DeinterleaveS16ToFloatS16(frame->data_,
+                              input_num_frames_,
+                              num_proc_channels_,
+                              deinterleaved);
   }
 
   // Resample.
   if (input_num_frames_ != proc_num_frames_) {
+    float* const* resampled = data_->fbuf_for_overwrite()->channels();
     for (int i = 0; i < num_proc_channels_; ++i) {
-      input_resamplers_[i]->Resample(input_buffer_->fbuf_const()->channels()[i],
+      input_resamplers_[i]->Resample(input_buffer_->channels()[i],
                                      input_num_frames_,
-                                     data_->fbuf()->channels()[i],
+                                     resampled[i],
                                      proc_num_frames_);
     }
   }
@@ -411,27 +419,41 @@ void AudioBuffer::InterleaveTo(AudioFrame* frame, bool data_changed) {
   assert(frame->num_channels_ == num_channels_ || num_channels_ == 1);
   assert(frame->samples_per_channel_ == output_num_frames_);
 
+  // If the last component to write the data did so in int16, interleave that
+  // directly rather than going through float.
+  if (proc_num_frames_ == output_num_frames_ && data_->ivalid()) {
+    const int16_t* const* channels = data_->ibuf_const()->channels();
+    if (frame->num_channels_ == num_channels_) {
+      Interleave(channels, output_num_frames_, num_channels_, frame->data_);
+    } else {
+      UpmixMonoToInterleaved(channels[0], output_num_frames_,
+                             frame->num_channels_, frame->data_);
+    }
+    return;
+  }
+
   // Resample if necessary.
-  IFChannelBuffer* data_ptr = data_.get();
+  const float* const* data_ptr = data_->fbuf_const()->channels();
   if (proc_num_frames_ != output_num_frames_) {
     if (!output_buffer_) {
       output_buffer_.reset(
-          new IFChannelBuffer(output_num_frames_, num_channels_));
+          new ChannelBuffer<float>(output_num_frames_, num_proc_channels_));
     }
     for (int i = 0; i < num_channels_; ++i) {
       output_resamplers_[i]->Resample(
-          data_->fbuf()->channels()[i], proc_num_frames_,
-          output_buffer_->fbuf()->channels()[i], output_num_frames_);
+          data_ptr[i], proc_num_frames_,
+          output_buffer_->channels()[i], output_num_frames_);
     }
-    data_ptr = output_buffer_.get();
+    data_ptr = output_buffer_->channels();
   }
 
+  // Convert to int16 and interleave in a single pass.
   if (frame->num_channels_ == num_channels_) {
-    Interleave(data_ptr->ibuf()->channels(), proc_num_frames_, num_channels_,
-               frame->data_);
+    InterleaveFloatS16ToS16(data_ptr, output_num_frames_, num_channels_,
+                            frame->data_);
   } else {
-    UpmixMonoToInterleaved(data_ptr->ibuf()->channels()[0], proc_num_frames_,
-                           frame->num_channels_, frame->data_);
+    UpmixMonoFloatS16ToInterleavedS16(data_ptr[0], output_num_frames_,
+                                      frame->num_channels_, frame->data_);
   }
 }
 
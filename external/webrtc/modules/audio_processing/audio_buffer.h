@@ -46,6 +46,10 @@ class AudioBuffer {
   size_t num_frames_per_band() const;
   size_t num_keyboard_frames() const;
   size_t num_bands() const;
+  // The number of int16 <-> float conversions of the full-band or the split
+  // data since construction, done when a component accesses the data in the
+  // format which was not written last.
+  size_t num_format_conversions() const;
 
   // Returns a pointer array to the full-band channels.
   // Usage:
@@ -151,8 +155,8 @@ class AudioBuffer {
   rtc::scoped_ptr<SplittingFilter> splitting_filter_;
   rtc::scoped_ptr<ChannelBuffer<int16_t> > mixed_low_pass_channels_;
   rtc::scoped_ptr<ChannelBuffer<int16_t> > low_pass_reference_channels_;
-  rtc::scoped_ptr<IFChannelBuffer> input_buffer_;
-  rtc::scoped_ptr<IFChannelBuffer> output_buffer_;
+  rtc::scoped_ptr<ChannelBuffer<float> > input_buffer_;
+  rtc::scoped_ptr<ChannelBuffer<float> > output_buffer_;
   rtc::scoped_ptr<ChannelBuffer<float> > process_buffer_;
   ScopedVector<PushSincResampler> input_resamplers_;
   ScopedVector<PushSincResampler> output_resamplers_;
@@ -186,6 +186,12 @@ const size_t AudioProcessing::kNumNativeSampleRates =
 const int AudioProcessing::kMaxNativeSampleRateHz = AudioProcessing::
     kNativeSampleRatesHz[AudioProcessing::kNumNativeSampleRates - 1];
 const int AudioProcessing::kMaxAECMSampleRateHz = kSampleRate16kHz;
+const size_t AudioProcessingImpl::kProfileIntervalFrames;
+
+AudioProcessingImpl::ApmRenderState::ApmRenderState()
+    : profiler(ProcessingProfiler::kRender) {}
+
+AudioProcessingImpl::ApmRenderState::~ApmRenderState() {}
 
 AudioProcessing* AudioProcessing::Create() {
   Config config;
@@ -217,6 +223,7 @@ AudioProcessingImpl::AudioProcessingImpl(const Config& config,
       constants_(config.Get<ExperimentalAgc>().startup_min_volume,
                  config.Get<Beamforming>().array_geometry,
                  config.Get<Beamforming>().target_direction,
+                 config.Get<Beamforming>().fft_size,
 #if defined(WEBRTC_ANDROID) || defined(WEBRTC_IOS)
                  false,
 #else
@@ -349,6 +356,12 @@ int AudioProcessingImpl::MaybeInitialize(
 }
 
 int AudioProcessingImpl::InitializeLocked() {
+  // An injected beamformer does not use the configured FFT size.
+  if (constants_.beamformer_enabled && !private_submodules_->beamformer &&
+      !NonlinearBeamformer::IsValidFftSize(constants_.beamformer_fft_size)) {
+    return kBadParameterError;
+  }
+
   const int fwd_audio_buffer_channels =
       constants_.beamformer_enabled
           ? formats_.api_format.input_stream().num_channels()
@@ -384,6 +397,8 @@ int AudioProcessingImpl::InitializeLocked() {
                       fwd_audio_buffer_channels,
                       formats_.api_format.output_stream().num_frames()));
 
+  render_queue_.Allocate(formats_.rev_proc_format.num_channels());
+
   // Initialize all components.
   for (auto item : private_submodules_->component_list) {
     int err = item->Initialize();
@@ -579,9 +594,7 @@ int AudioProcessingImpl::ProcessStream(const float* const* src,
     // that retrieves the render side data. This function accesses apm
     // getters that need the capture lock held when being called.
     rtc::CritScope cs_capture(&crit_capture_);
-    public_submodules_->echo_cancellation->ReadQueuedRenderData();
-    public_submodules_->echo_control_mobile->ReadQueuedRenderData();
-    public_submodules_->gain_control->ReadQueuedRenderData();
+    ReadQueuedRenderData();
 
     if (!src || !dest) {
       return kNullPointerError;
@@ -615,9 +628,29 @@ int AudioProcessingImpl::ProcessStream(const float* const* src,
   }
 #endif
 
-  capture_.capture_audio->CopyFrom(src, formats_.api_format.input_stream());
-  RETURN_ON_ERR(ProcessStreamLocked());
-  capture_.capture_audio->CopyTo(formats_.api_format.output_stream(), dest);
+  {
+    ScopedFormatConversionCounter counter(&capture_.profiler,
+                                          capture_.capture_audio.get());
+    {
+      ScopedStageTimer timer(&capture_.profiler,
+                             ProcessingProfiler::kCaptureInputConversion);
+      capture_.profiler.CountConversion(
+          formats_.api_format.input_stream().num_frames(),
+          capture_nonlocked_.fwd_proc_format.num_frames());
+      capture_.capture_audio->CopyFrom(src,
+                                       formats_.api_format.input_stream());
+    }
+    RETURN_ON_ERR(ProcessStreamLocked());
+    {
+      ScopedStageTimer timer(&capture_.profiler,
+                             ProcessingProfiler::kCaptureOutputConversion);
+      capture_.profiler.CountConversion(
+          capture_nonlocked_.fwd_proc_format.num_frames(),
+          formats_.api_format.output_stream().num_frames());
+      capture_.capture_audio->CopyTo(formats_.api_format.output_stream(),
+                                     dest);
+    }
+  }
 
 #ifdef WEBRTC_AUDIOPROC_DEBUG_DUMP
   if (debug_dump_.debug_file->Open()) {
@@ -628,6 +661,8 @@ int AudioProcessingImpl::ProcessStream(const float* const* src,
       msg->add_output_channel(dest[i], channel_size);
     RETURN_ON_ERR(WriteMessageToDebugFile(debug_dump_.debug_file.get(),
                                           &crit_debug_, &debug_dump_.capture));
+    RETURN_ON_ERR(
+        MaybeWriteProfileMessage(capture_.profiler, &debug_dump_.capture));
   }
 #endif
 
@@ -643,9 +678,7 @@ int AudioProcessingImpl::ProcessStream(AudioFrame* frame) {
     // public_submodules_->echo_control_mobile->is_enabled() aquires this lock
     // as well.
     rtc::CritScope cs_capture(&crit_capture_);
-    public_submodules_->echo_cancellation->ReadQueuedRenderData();
-    public_submodules_->echo_control_mobile->ReadQueuedRenderData();
-    public_submodules_->gain_control->ReadQueuedRenderData();
+    ReadQueuedRenderData();
   }
 
   if (!frame) {
@@ -701,10 +734,30 @@ int AudioProcessingImpl::ProcessStream(AudioFrame* frame) {
   }
 #endif
 
-  capture_.capture_audio->DeinterleaveFrom(frame);
-  RETURN_ON_ERR(ProcessStreamLocked());
-  capture_.capture_audio->InterleaveTo(frame,
-                                       output_copy_needed(is_data_processed()));
+  {
+    ScopedFormatConversionCounter counter(&capture_.profiler,
+                                          capture_.capture_audio.get());
+    {
+      ScopedStageTimer timer(&capture_.profiler,
+                             ProcessingProfiler::kCaptureInputConversion);
+      capture_.profiler.CountConversion(
+          frame->samples_per_channel_,
+          capture_nonlocked_.fwd_proc_format.num_frames());
+      capture_.capture_audio->DeinterleaveFrom(frame);
+    }
+    RETURN_ON_ERR(ProcessStreamLocked());
+    {
+      ScopedStageTimer timer(&capture_.profiler,
+                             ProcessingProfiler::kCaptureOutputConversion);
+      const bool data_changed = output_copy_needed(is_data_processed());
+      if (data_changed) {
+        capture_.profiler.CountConversion(
+            capture_nonlocked_.fwd_proc_format.num_frames(),
+            frame->samples_per_channel_);
+      }
+      capture_.capture_audio->InterleaveTo(frame, data_changed);
+    }
+  }
 
 #ifdef WEBRTC_AUDIOPROC_DEBUG_DUMP
   if (debug_dump_.debug_file->Open()) {
@@ -714,6 +767,8 @@ int AudioProcessingImpl::ProcessStream(AudioFrame* frame) {
     msg->set_output_data(frame->data_, data_size);
     RETURN_ON_ERR(WriteMessageToDebugFile(debug_dump_.debug_file.get(),
                                           &crit_debug_, &debug_dump_.capture));
+    RETURN_ON_ERR(
+        MaybeWriteProfileMessage(capture_.profiler, &debug_dump_.capture));
   }
 #endif
 
@@ -721,6 +776,10 @@ int AudioProcessingImpl::ProcessStream(AudioFrame* frame) {
 }
 
 int AudioProcessingImpl::ProcessStreamLocked() {
+  ScopedStageTimer processing_timer(&capture_.profiler,
+                                    ProcessingProfiler::kCaptureProcessing);
+  ProcessingProfiler* profiler = &capture_.profiler;  // For brevity.
+
 #ifdef WEBRTC_AUDIOPROC_DEBUG_DUMP
   if (debug_dump_.debug_file->Open()) {
     audioproc::Stream* msg = debug_dump_.capture.event_msg->mutable_stream();
@@ -738,6 +797,8 @@ int AudioProcessingImpl::ProcessStreamLocked() {
 
   if (constants_.use_new_agc &&
       public_submodules_->gain_control->is_enabled()) {
+    ScopedStageTimer timer(profiler,
+                           ProcessingProfiler::kCaptureAgcManagerAnalysis);
     private_submodules_->agc_manager->AnalyzePreProcess(
         ca->channels()[0], ca->num_channels(),
         capture_nonlocked_.fwd_proc_format.num_frames());
@@ -745,52 +806,91 @@ int AudioProcessingImpl::ProcessStreamLocked() {
 
   bool data_processed = is_data_processed();
   if (analysis_needed(data_processed)) {
+    ScopedStageTimer timer(profiler, ProcessingProfiler::kCaptureSplit);
     ca->SplitIntoFrequencyBands();
   }
 
   if (constants_.intelligibility_enabled) {
+    ScopedStageTimer timer(profiler,
+                           ProcessingProfiler::kCaptureIntelligibility);
     public_submodules_->intelligibility_enhancer->AnalyzeCaptureAudio(
         ca->split_channels_f(kBand0To8kHz), capture_nonlocked_.split_rate,
         ca->num_channels());
   }
 
   if (constants_.beamformer_enabled) {
+    ScopedStageTimer timer(profiler, ProcessingProfiler::kCaptureBeamformer);
     private_submodules_->beamformer->ProcessChunk(*ca->split_data_f(),
                                                   ca->split_data_f());
     ca->set_num_channels(1);
   }
 
-  public_submodules_->high_pass_filter->ProcessCaptureAudio(ca);
-  RETURN_ON_ERR(public_submodules_->gain_control->AnalyzeCaptureAudio(ca));
-  public_submodules_->noise_suppression->AnalyzeCaptureAudio(ca);
-  RETURN_ON_ERR(public_submodules_->echo_cancellation->ProcessCaptureAudio(ca));
+  {
+    ScopedStageTimer timer(profiler,
+                           ProcessingProfiler::kCaptureHighPassFilter);
+    public_submodules_->high_pass_filter->ProcessCaptureAudio(ca);
+  }
+  {
+    ScopedStageTimer timer(profiler,
+                           ProcessingProfiler::kCaptureGainControlAnalysis);
+    RETURN_ON_ERR(public_submodules_->gain_control->AnalyzeCaptureAudio(ca));
+  }
+  {
+    ScopedStageTimer timer(
+        profiler, ProcessingProfiler::kCaptureNoiseSuppressionAnalysis);
+    public_submodules_->noise_suppression->AnalyzeCaptureAudio(ca);
+  }
+  {
+    ScopedStageTimer timer(profiler,
+                           ProcessingProfiler::kCaptureEchoCancellation);
+    RETURN_ON_ERR(
+        public_submodules_->echo_cancellation->ProcessCaptureAudio(ca));
+  }
 
   if (public_submodules_->echo_control_mobile->is_enabled() &&
       public_submodules_->noise_suppression->is_enabled()) {
     ca->CopyLowPassToReference();
   }
-  public_submodules_->noise_suppression->ProcessCaptureAudio(ca);
-  RETURN_ON_ERR(
-      public_submodules_->echo_control_mobile->ProcessCaptureAudio(ca));
-  RETURN_ON_ERR(public_submodules_->voice_detection->ProcessCaptureAudio(ca));
+  {
+    ScopedStageTimer timer(profiler,
+                           ProcessingProfiler::kCaptureNoiseSuppression);
+    public_submodules_->noise_suppression->ProcessCaptureAudio(ca);
+  }
+  {
+    ScopedStageTimer timer(profiler,
+                           ProcessingProfiler::kCaptureEchoControlMobile);
+    RETURN_ON_ERR(
+        public_submodules_->echo_control_mobile->ProcessCaptureAudio(ca));
+  }
+  {
+    ScopedStageTimer timer(profiler,
+                           ProcessingProfiler::kCaptureVoiceDetection);
+    RETURN_ON_ERR(public_submodules_->voice_detection->ProcessCaptureAudio(ca));
+  }
 
-  if (constants_.use_new_agc &&
-      public_submodules_->gain_control->is_enabled() &&
-      (!constants_.beamformer_enabled ||
-       private_submodules_->beamformer->is_target_present())) {
-    private_submodules_->agc_manager->Process(
-        ca->split_bands_const(0)[kBand0To8kHz], ca->num_frames_per_band(),
-        capture_nonlocked_.split_rate);
+  {
+    ScopedStageTimer timer(profiler, ProcessingProfiler::kCaptureGainControl);
+    if (constants_.use_new_agc &&
+        public_submodules_->gain_control->is_enabled() &&
+        (!constants_.beamformer_enabled ||
+         private_submodules_->beamformer->is_target_present())) {
+      private_submodules_->agc_manager->Process(
+          ca->split_bands_const(0)[kBand0To8kHz], ca->num_frames_per_band(),
+          capture_nonlocked_.split_rate);
+    }
+    RETURN_ON_ERR(public_submodules_->gain_control->ProcessCaptureAudio(ca));
   }
-  RETURN_ON_ERR(public_submodules_->gain_control->ProcessCaptureAudio(ca));
 
   if (synthesis_needed(data_processed)) {
+    ScopedStageTimer timer(profiler, ProcessingProfiler::kCaptureMerge);
     ca->MergeFrequencyBands();
   }
 
   // TODO(aluebs): Investigate if the transient suppression placement should be
   // before or after the AGC.
   if (capture_.transient_suppressor_enabled) {
+    ScopedStageTimer timer(profiler,
+                           ProcessingProfiler::kCaptureTransientSuppression);
     float voice_probability =
         private_submodules_->agc_manager.get()
             ? private_submodules_->agc_manager->voice_probability()
@@ -804,7 +904,11 @@ int AudioProcessingImpl::ProcessStreamLocked() {
   }
 
   // The level estimator operates on the recombined data.
-  RETURN_ON_ERR(public_submodules_->level_estimator->ProcessStream(ca));
+  {
+    ScopedStageTimer timer(profiler,
+                           ProcessingProfiler::kCaptureLevelEstimator);
+    RETURN_ON_ERR(public_submodules_->level_estimator->ProcessStream(ca));
+  }
 
   capture_.was_stream_delay_set = false;
   return kNoError;
@@ -833,9 +937,20 @@ int AudioProcessingImpl::ProcessReverseStream(
   RETURN_ON_ERR(AnalyzeReverseStreamLocked(src, reverse_input_config,
                                            reverse_output_config));
   if (is_rev_processed()) {
+    ScopedStageTimer timer(&render_.profiler,
+                           ProcessingProfiler::kRenderOutputConversion);
+    ScopedFormatConversionCounter counter(&render_.profiler,
+                                          render_.render_audio.get());
+    render_.profiler.CountConversion(
+        formats_.rev_proc_format.num_frames(),
+        formats_.api_format.reverse_output_stream().num_frames());
     render_.render_audio->CopyTo(formats_.api_format.reverse_output_stream(),
                                  dest);
   } else if (render_check_rev_conversion_needed()) {
+    ScopedStageTimer timer(&render_.profiler,
+                           ProcessingProfiler::kRenderOutputConversion);
+    render_.profiler.CountConversion(reverse_input_config.num_frames(),
+                                     reverse_output_config.num_frames());
     render_.render_converter->Convert(src, reverse_input_config.num_samples(),
                                       dest,
                                       reverse_output_config.num_samples());
@@ -879,11 +994,22 @@ int AudioProcessingImpl::AnalyzeReverseStreamLocked(
       msg->add_channel(src[i], channel_size);
     RETURN_ON_ERR(WriteMessageToDebugFile(debug_dump_.debug_file.get(),
                                           &crit_debug_, &debug_dump_.render));
+    RETURN_ON_ERR(
+        MaybeWriteProfileMessage(render_.profiler, &debug_dump_.render));
   }
 #endif
 
-  render_.render_audio->CopyFrom(src,
-                                 formats_.api_format.reverse_input_stream());
+  ScopedFormatConversionCounter counter(&render_.profiler,
+                                        render_.render_audio.get());
+  {
+    ScopedStageTimer timer(&render_.profiler,
+                           ProcessingProfiler::kRenderInputConversion);
+    render_.profiler.CountConversion(
+        formats_.api_format.reverse_input_stream().num_frames(),
+        formats_.rev_proc_format.num_frames());
+    render_.render_audio->CopyFrom(src,
+                                   formats_.api_format.reverse_input_stream());
+  }
   return ProcessReverseStreamLocked();
 }
 
@@ -891,6 +1017,12 @@ int AudioProcessingImpl::ProcessReverseStream(AudioFrame* frame) {
   RETURN_ON_ERR(AnalyzeReverseStream(frame));
   rtc::CritScope cs(&crit_render_);
   if (is_rev_processed()) {
+    ScopedStageTimer timer(&render_.profiler,
+                           ProcessingProfiler::kRenderOutputConversion);
+    ScopedFormatConversionCounter counter(&render_.profiler,
+                                          render_.render_audio.get());
+    render_.profiler.CountConversion(formats_.rev_proc_format.num_frames(),
+                                     frame->samples_per_channel_);
     render_.render_audio->InterleaveTo(frame, true);
   }
 
@@ -945,19 +1077,35 @@ int AudioProcessingImpl::AnalyzeReverseStream(AudioFrame* frame) {
     msg->set_data(frame->data_, data_size);
     RETURN_ON_ERR(WriteMessageToDebugFile(debug_dump_.debug_file.get(),
                                           &crit_debug_, &debug_dump_.render));
+    RETURN_ON_ERR(
+        MaybeWriteProfileMessage(render_.profiler, &debug_dump_.render));
   }
 #endif
-  render_.render_audio->DeinterleaveFrom(frame);
+  ScopedFormatConversionCounter counter(&render_.profiler,
+                                        render_.render_audio.get());
+  {
+    ScopedStageTimer timer(&render_.profiler,
+                           ProcessingProfiler::kRenderInputConversion);
+    render_.profiler.CountConversion(frame->samples_per_channel_,
+                                     formats_.rev_proc_format.num_frames());
+    render_.render_audio->DeinterleaveFrom(frame);
+  }
   return ProcessReverseStreamLocked();
 }
 
 int AudioProcessingImpl::ProcessReverseStreamLocked() {
+  ScopedStageTimer processing_timer(&render_.profiler,
+                                    ProcessingProfiler::kRenderProcessing);
+  ProcessingProfiler* profiler = &render_.profiler;  // For brevity.
   AudioBuffer* ra = render_.render_audio.get();  // For brevity.
   if (formats_.rev_proc_format.sample_rate_hz() == kSampleRate32kHz) {
+    ScopedStageTimer timer(profiler, ProcessingProfiler::kRenderSplit);
     ra->SplitIntoFrequencyBands();
   }
 
   if (constants_.intelligibility_enabled) {
+    ScopedStageTimer timer(profiler,
+                           ProcessingProfiler::kRenderIntelligibility);
     // Currently run in single-threaded mode when the intelligibility
     // enhancer is activated.
     // TODO(peah): Fix to be properly multi-threaded.
@@ -967,15 +1115,34 @@ int AudioProcessingImpl::ProcessReverseStreamLocked() {
         ra->num_channels());
   }
 
-  RETURN_ON_ERR(public_submodules_->echo_cancellation->ProcessRenderAudio(ra));
-  RETURN_ON_ERR(
-      public_submodules_->echo_control_mobile->ProcessRenderAudio(ra));
+  // The components copy the render data they need straight into the queue.
+  // When the queue is full the frame is dropped rather than waiting for the
+  // capture side.
+  RenderQueueItem* item = render_queue_.BeginWrite(ra->num_frames_per_band());
+  {
+    ScopedStageTimer timer(profiler,
+                           ProcessingProfiler::kRenderEchoCancellation);
+    RETURN_ON_ERR(
+        public_submodules_->echo_cancellation->ProcessRenderAudio(ra, item));
+  }
+  {
+    ScopedStageTimer timer(profiler,
+                           ProcessingProfiler::kRenderEchoControlMobile);
+    RETURN_ON_ERR(
+        public_submodules_->echo_control_mobile->ProcessRenderAudio(ra, item));
+  }
   if (!constants_.use_new_agc) {
-    RETURN_ON_ERR(public_submodules_->gain_control->ProcessRenderAudio(ra));
+    ScopedStageTimer timer(profiler, ProcessingProfiler::kRenderGainControl);
+    RETURN_ON_ERR(
+        public_submodules_->gain_control->ProcessRenderAudio(ra, item));
+  }
+  if (item) {
+    render_queue_.EndWrite();
   }
 
   if (formats_.rev_proc_format.sample_rate_hz() == kSampleRate32kHz &&
       is_rev_processed()) {
+    ScopedStageTimer timer(profiler, ProcessingProfiler::kRenderMerge);
     ra->MergeFrequencyBands();
   }
 
@@ -1161,6 +1328,39 @@ VoiceDetection* AudioProcessingImpl::voice_detection() const {
   return public_submodules_->voice_detection;
 }
 
+RenderQueue::Statistics AudioProcessingImpl::render_queue_statistics() const {
+  return render_queue_.GetStatistics();
+}
+
+void AudioProcessingImpl::set_profiling_enabled(bool enabled) {
+  rtc::CritScope cs_render(&crit_render_);
+  rtc::CritScope cs_capture(&crit_capture_);
+  render_.profiler.set_enabled(enabled);
+  capture_.profiler.set_enabled(enabled);
+}
+
+bool AudioProcessingImpl::profiling_enabled() const {
+  rtc::CritScope cs(&crit_capture_);
+  return capture_.profiler.enabled();
+}
+
+void AudioProcessingImpl::ResetProfiling() {
+  rtc::CritScope cs_render(&crit_render_);
+  rtc::CritScope cs_capture(&crit_capture_);
+  render_.profiler.Reset();
+  capture_.profiler.Reset();
+}
+
+AudioProcessingImpl::ProfilingStatistics
+AudioProcessingImpl::profiling_statistics() const {
+  rtc::CritScope cs_render(&crit_render_);
+  rtc::CritScope cs_capture(&crit_capture_);
+  ProfilingStatistics stats;
+  stats.capture = capture_.profiler.statistics();
+  stats.render = render_.profiler.statistics();
+  return stats;
+}
+
 bool AudioProcessingImpl::is_data_processed() const {
   if (constants_.beamformer_enabled) {
     return true;
@@ -1274,7 +1474,8 @@ void AudioProcessingImpl::InitializeBeamformer() {
   if (constants_.beamformer_enabled) {
     if (!private_submodules_->beamformer) {
       private_submodules_->beamformer.reset(new NonlinearBeamformer(
-          constants_.array_geometry, constants_.target_direction));
+          constants_.array_geometry, constants_.target_direction,
+          constants_.beamformer_fft_size));
     }
     private_submodules_->beamformer->Initialize(kChunkSizeMs,
                                                 capture_nonlocked_.split_rate);
@@ -1302,6 +1503,16 @@ void AudioProcessingImpl::InitializeNoiseSuppression() {
                                                     proc_sample_rate_hz());
 }
 
+void AudioProcessingImpl::ReadQueuedRenderData() {
+  while (const RenderQueueItem* item = render_queue_.BeginRead()) {
+    public_submodules_->echo_cancellation->BufferRenderData(*item);
+    public_submodules_->echo_control_mobile->BufferRenderData(*item);
+    public_submodules_->gain_control->BufferRenderData(*item);
+    render_queue_.EndRead();
+  }
+  render_queue_.CheckUnderflow();
+}
+
 void AudioProcessingImpl::MaybeUpdateHistograms() {
   static const int kMinDiffDelayMs = 60;
 
@@ -1409,6 +1620,47 @@ int AudioProcessingImpl::WriteMessageToDebugFile(
   return kNoError;
 }
 
+int AudioProcessingImpl::MaybeWriteProfileMessage(
+    const ProcessingProfiler& profiler,
+    ApmDebugDumpThreadState* debug_state) {
+  if (!profiler.enabled()) {
+    return kNoError;
+  }
+  const ProcessingProfiler::Statistics& stats = profiler.statistics();
+  const size_t frames = stats.stages[0].calls;
+  if (frames < debug_state->last_profile_frames) {
+    // The profiler has been reset.
+    debug_state->last_profile_frames = 0;
+  }
+  if (frames < debug_state->last_profile_frames + kProfileIntervalFrames) {
+    return kNoError;
+  }
+  debug_state->last_profile_frames = frames;
+
+  debug_state->event_msg->set_type(audioproc::Event::PROFILE);
+  audioproc::Profile* msg = debug_state->event_msg->mutable_profile();
+  msg->set_render(profiler.direction() == ProcessingProfiler::kRender);
+  msg->set_conversions(stats.conversions);
+  msg->set_resamplings(stats.resamplings);
+  msg->set_format_conversions(stats.format_conversions);
+  for (size_t i = 0; i < stats.stages.size(); ++i) {
+    const ProcessingProfiler::StageStatistics& stage_stats = stats.stages[i];
+    if (stage_stats.calls == 0) {
+      continue;
+    }
+    audioproc::Profile::Stage* stage = msg->add_stage();
+    stage->set_name(ProcessingProfiler::StageName(profiler.direction(), i));
+    stage->set_calls(stage_stats.calls);
+    stage->set_total_ns(stage_stats.total_ns);
+    stage->set_max_ns(stage_stats.max_ns);
+    for (size_t j = 0; j < ProcessingProfiler::kNumHistogramBins; ++j) {
+      stage->add_histogram(stage_stats.histogram[j]);
+    }
+  }
+  return WriteMessageToDebugFile(debug_dump_.debug_file.get(), &crit_debug_,
+                                 debug_state);
+}
+
 int AudioProcessingImpl::WriteInitMessage() {
   debug_dump_.capture.event_msg->set_type(audioproc::Event::INIT);
   audioproc::Init* msg = debug_dump_.capture.event_msg->mutable_init();
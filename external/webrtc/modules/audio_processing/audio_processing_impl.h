@@ -20,6 +20,8 @@
 #include "webrtc/base/thread_annotations.h"
 #include "webrtc/modules/audio_processing/audio_buffer.h"
 #include "webrtc/modules/audio_processing/include/audio_processing.h"
+#include "webrtc/modules/audio_processing/processing_profiler.h"
+#include "webrtc/modules/audio_processing/render_queue.h"
 #include "webrtc/system_wrappers/include/file_wrapper.h"
 
 #ifdef WEBRTC_AUDIOPROC_DEBUG_DUMP
@@ -120,6 +122,26 @@ class AudioProcessingImpl : public AudioProcessing {
   NoiseSuppression* noise_suppression() const override;
   VoiceDetection* voice_detection() const override;
 
+  // Overflow and underflow counts of the render to capture handoff. May be
+  // called from any thread.
+  RenderQueue::Statistics render_queue_statistics() const;
+
+  struct ProfilingStatistics {
+    ProcessingProfiler::Statistics capture;
+    ProcessingProfiler::Statistics render;
+  };
+
+  // Per stage timing of the capture and render processing. Profiling is off
+  // by default and may be toggled at any time. While it is on and a debug
+  // recording is running, a Profile message of each direction is added to the
+  // recording every kProfileIntervalFrames frames.
+  void set_profiling_enabled(bool enabled);
+  bool profiling_enabled() const;
+  void ResetProfiling();
+  ProfilingStatistics profiling_statistics() const;
+
+  static const size_t kProfileIntervalFrames = 100;
+
  protected:
   // Overridden in a mock.
   virtual int InitializeLocked()
@@ -132,10 +154,14 @@ class AudioProcessingImpl : public AudioProcessing {
 #ifdef WEBRTC_AUDIOPROC_DEBUG_DUMP
   // State for the debug dump.
   struct ApmDebugDumpThreadState {
-    ApmDebugDumpThreadState() : event_msg(new audioproc::Event()) {}
+    ApmDebugDumpThreadState()
+        : event_msg(new audioproc::Event()), last_profile_frames(0) {}
     rtc::scoped_ptr<audioproc::Event> event_msg;  // Protobuf message.
     std::string event_str;  // Memory for protobuf serialization.
 
+    // Processed frames at the time of the last saved Profile message.
+    size_t last_profile_frames;
+
     // Serialized string of last saved APM configuration.
     std::string last_serialized_config;
   };
@@ -199,6 +225,8 @@ class AudioProcessingImpl : public AudioProcessing {
   bool analysis_needed(bool is_data_processed) const
       EXCLUSIVE_LOCKS_REQUIRED(crit_capture_);
   void MaybeUpdateHistograms() EXCLUSIVE_LOCKS_REQUIRED(crit_capture_);
+  // Fans the render frames queued since the last call out to the components.
+  void ReadQueuedRenderData() EXCLUSIVE_LOCKS_REQUIRED(crit_capture_);
 
   // Render-side exclusive methods possibly running APM in a multi-threaded
   // manner that are called with the render lock already acquired.
@@ -226,6 +254,12 @@ class AudioProcessingImpl : public AudioProcessing {
   int WriteConfigMessage(bool forced) EXCLUSIVE_LOCKS_REQUIRED(crit_capture_)
       EXCLUSIVE_LOCKS_REQUIRED(crit_capture_);
 
+  // Writes a Profile message of |profiler| if profiling is enabled and
+  // kProfileIntervalFrames frames were processed since the last one. Called
+  // with the lock of the direction of |profiler| held.
+  int MaybeWriteProfileMessage(const ProcessingProfiler& profiler,
+                               ApmDebugDumpThreadState* debug_state);
+
   // Critical section.
   mutable rtc::CriticalSection crit_debug_;
 
@@ -242,6 +276,10 @@ class AudioProcessingImpl : public AudioProcessing {
   rtc::scoped_ptr<ApmPrivateSubmodules> private_submodules_
       GUARDED_BY(crit_capture_);
 
+  // Render frames on their way to the capture side components. Filled by the
+  // render side and emptied by the capture side; lock protection not needed.
+  RenderQueue render_queue_;
+
   // State that is written to while holding both the render and capture locks
   // but can be read without any lock being held.
   // As this is only accessed internally of APM, and all internal methods in APM
@@ -264,6 +302,7 @@ class AudioProcessingImpl : public AudioProcessing {
     ApmConstants(int agc_startup_min_volume,
                  const std::vector<Point> array_geometry,
                  SphericalPointf target_direction,
+                 size_t beamformer_fft_size,
                  bool use_new_agc,
                  bool intelligibility_enabled,
                  bool beamformer_enabled)
@@ -271,12 +310,14 @@ class AudioProcessingImpl : public AudioProcessing {
           agc_startup_min_volume(agc_startup_min_volume),
           array_geometry(array_geometry),
           target_direction(target_direction),
+          beamformer_fft_size(beamformer_fft_size),
           use_new_agc(use_new_agc),
           intelligibility_enabled(intelligibility_enabled),
           beamformer_enabled(beamformer_enabled) {}
     int agc_startup_min_volume;
     std::vector<Point> array_geometry;
     SphericalPointf target_direction;
+    size_t beamformer_fft_size;
     bool use_new_agc;
     bool intelligibility_enabled;
     bool beamformer_enabled;
@@ -294,7 +335,8 @@ class AudioProcessingImpl : public AudioProcessing {
           key_pressed(false),
           transient_suppressor_enabled(transient_suppressor_enabled),
           fwd_proc_format(kSampleRate16kHz),
-          split_rate(kSampleRate16kHz) {}
+          split_rate(kSampleRate16kHz),
+          profiler(ProcessingProfiler::kCapture) {}
     int aec_system_delay_jumps;
     int delay_offset_ms;
     bool was_stream_delay_set;
@@ -310,6 +352,7 @@ class AudioProcessingImpl : public AudioProcessing {
     // capture_audio_.
     StreamConfig fwd_proc_format;
     int split_rate;
+    ProcessingProfiler profiler;
   } capture_ GUARDED_BY(crit_capture_);
 
   struct ApmCaptureNonLockedState {
@@ -326,8 +369,11 @@ class AudioProcessingImpl : public AudioProcessing {
   } capture_nonlocked_;
 
   struct ApmRenderState {
+    ApmRenderState();
+    ~ApmRenderState();
     rtc::scoped_ptr<AudioConverter> render_converter;
     rtc::scoped_ptr<AudioBuffer> render_audio;
+    ProcessingProfiler profiler;
   } render_ GUARDED_BY(crit_render_);
 };
 
@@ -10,8 +10,13 @@
 
 #include "webrtc/modules/audio_processing/audio_processing_impl.h"
 
+#include <math.h>
+
+#include <vector>
+
 #include "testing/gmock/include/gmock/gmock.h"
 #include "testing/gtest/include/gtest/gtest.h"
+#include "webrtc/base/scoped_ptr.h"
 #include "webrtc/config.h"
 #include "webrtc/modules/audio_processing/test/test_utils.h"
 #include "webrtc/modules/include/module_common_types.h"
@@ -73,4 +78,126 @@ TEST(AudioProcessingImplTest, AudioParameterChangeTriggersInit) {
   EXPECT_EQ(mock.kBadSampleRateError, mock.AnalyzeReverseStream(&frame));
 }
 
+TEST(AudioProcessingImplTest, ProfilesEnabledComponents) {
+  Config config;
+  AudioProcessingImpl apm(config);
+  EXPECT_NOERR(apm.echo_cancellation()->Enable(true));
+  EXPECT_NOERR(apm.noise_suppression()->Enable(true));
+
+  AudioFrame frame;
+  frame.num_channels_ = 1;
+  SetFrameSampleRate(&frame, 32000);
+  EXPECT_NOERR(apm.set_stream_delay_ms(0));
+  EXPECT_NOERR(apm.ProcessStream(&frame));
+  EXPECT_NOERR(apm.ProcessReverseStream(&frame));
+  EXPECT_FALSE(apm.profiling_enabled());
+  EXPECT_EQ(0u, apm.profiling_statistics()
+                    .capture.stages[ProcessingProfiler::kCaptureProcessing]
+                    .calls);
+
+  apm.set_profiling_enabled(true);
+  const size_t kNumFrames = 10;
+  for (size_t i = 0; i < kNumFrames; ++i) {
+    EXPECT_NOERR(apm.ProcessReverseStream(&frame));
+    EXPECT_NOERR(apm.set_stream_delay_ms(0));
+    EXPECT_NOERR(apm.ProcessStream(&frame));
+  }
+
+  AudioProcessingImpl::ProfilingStatistics stats = apm.profiling_statistics();
+  const std::vector<ProcessingProfiler::StageStatistics>& capture =
+      stats.capture.stages;
+  EXPECT_EQ(kNumFrames, capture[ProcessingProfiler::kCaptureProcessing].calls);
+  EXPECT_EQ(kNumFrames, capture[ProcessingProfiler::kCaptureSplit].calls);
+  EXPECT_EQ(kNumFrames,
+            capture[ProcessingProfiler::kCaptureEchoCancellation].calls);
+  EXPECT_EQ(kNumFrames, capture[ProcessingProfiler::kCaptureMerge].calls);
+  EXPECT_EQ(0u, capture[ProcessingProfiler::kCaptureBeamformer].calls);
+  EXPECT_LE(capture[ProcessingProfiler::kCaptureEchoCancellation].total_ns,
+            capture[ProcessingProfiler::kCaptureProcessing].total_ns);
+  EXPECT_EQ(2 * kNumFrames, stats.capture.conversions);
+  EXPECT_EQ(0u, stats.capture.resamplings);
+
+  const std::vector<ProcessingProfiler::StageStatistics>& render =
+      stats.render.stages;
+  EXPECT_EQ(kNumFrames, render[ProcessingProfiler::kRenderProcessing].calls);
+  EXPECT_EQ(kNumFrames,
+            render[ProcessingProfiler::kRenderEchoCancellation].calls);
+
+  apm.ResetProfiling();
+  EXPECT_TRUE(apm.profiling_enabled());
+  EXPECT_EQ(0u, apm.profiling_statistics()
+                    .render.stages[ProcessingProfiler::kRenderProcessing]
+                    .calls);
+}
+
+TEST(AudioProcessingImplTest, ProfilesFormatConversions) {
+  Config config;
+  AudioProcessingImpl apm(config);
+  EXPECT_NOERR(apm.gain_control()->set_mode(GainControl::kAdaptiveDigital));
+  EXPECT_NOERR(apm.gain_control()->Enable(true));
+  apm.set_profiling_enabled(true);
+
+  AudioFrame frame;
+  frame.num_channels_ = 1;
+  SetFrameSampleRate(&frame, 32000);
+  // The first frames also allocate the int16 buffers.
+  EXPECT_NOERR(apm.ProcessStream(&frame));
+  EXPECT_NOERR(apm.ProcessReverseStream(&frame));
+  apm.ResetProfiling();
+  const size_t kNumFrames = 10;
+  for (size_t i = 0; i < kNumFrames; ++i) {
+    EXPECT_NOERR(apm.ProcessStream(&frame));
+    EXPECT_NOERR(apm.ProcessReverseStream(&frame));
+  }
+
+  AudioProcessingImpl::ProfilingStatistics stats = apm.profiling_statistics();
+  // The 32 kHz band split works in int16, so the float input of both
+  // directions is converted for it. Everything else stays in int16.
+  EXPECT_EQ(kNumFrames, stats.capture.format_conversions);
+  EXPECT_EQ(kNumFrames, stats.render.format_conversions);
+  EXPECT_EQ(2 * kNumFrames, stats.capture.conversions);
+}
+
+TEST(AudioProcessingImplTest, ProfilesFormatConversionsOnErrors) {
+  Config config;
+  AudioProcessingImpl apm(config);
+  EXPECT_NOERR(apm.echo_cancellation()->Enable(true));
+  apm.set_profiling_enabled(true);
+
+  AudioFrame frame;
+  frame.num_channels_ = 1;
+  SetFrameSampleRate(&frame, 32000);
+  EXPECT_NOERR(apm.set_stream_delay_ms(0));
+  EXPECT_NOERR(apm.ProcessStream(&frame));
+  apm.ResetProfiling();
+  const size_t kNumFrames = 10;
+  for (size_t i = 0; i < kNumFrames; ++i) {
+    // The AEC fails without a stream delay, after the band split.
+    EXPECT_EQ(AudioProcessing::kStreamParameterNotSetError,
+              apm.ProcessStream(&frame));
+  }
+
+  EXPECT_EQ(kNumFrames,
+            apm.profiling_statistics().capture.format_conversions);
+}
+
+TEST(AudioProcessingImplTest, RejectsUnsupportedBeamformerFftSize) {
+  std::vector<Point> array_geometry;
+  array_geometry.push_back(Point(0.f, 0.f, 0.f));
+  array_geometry.push_back(Point(0.05f, 0.f, 0.f));
+  const SphericalPointf target_direction(static_cast<float>(M_PI) / 2.f, 0.f,
+                                         1.f);
+
+  Config config;
+  config.Set<Beamforming>(
+      new Beamforming(true, array_geometry, target_direction, 100));
+  rtc::scoped_ptr<AudioProcessing> apm(AudioProcessing::Create(config));
+  EXPECT_TRUE(apm.get() == nullptr);
+
+  config.Set<Beamforming>(
+      new Beamforming(true, array_geometry, target_direction, 512));
+  apm.reset(AudioProcessing::Create(config));
+  EXPECT_TRUE(apm.get() != nullptr);
+}
+
 }  // namespace webrtc
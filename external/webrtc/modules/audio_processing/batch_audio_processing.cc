@@ -0,0 +1,268 @@
+/*
+ *  Copyright (c) 2016 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "webrtc/modules/audio_processing/batch_audio_processing.h"
+
+#include <algorithm>
+
+#include "webrtc/base/checks.h"
+
+namespace webrtc {
+
+// A thread processing one contiguous shard of sessions per sweep. The
+// sweeping thread releases the worker through |start_event_| and waits for
+// it on |done_event_|.
+class BatchAudioProcessing::Worker {
+ public:
+  explicit Worker(BatchAudioProcessing* parent)
+      : parent_(parent),
+        thread_(&Worker::Run, this, "BatchApmWorker"),
+        start_event_(false, false),
+        done_event_(false, false),
+        begin_(0),
+        end_(0),
+        quit_(false) {
+    thread_.Start();
+  }
+
+  ~Worker() {
+    quit_ = true;
+    start_event_.Set();
+    thread_.Stop();
+  }
+
+  void set_shard(size_t begin, size_t end) {
+    begin_ = begin;
+    end_ = end;
+  }
+
+  void Start() { start_event_.Set(); }
+  void Wait() { done_event_.Wait(rtc::Event::kForever); }
+
+ private:
+  static bool Run(void* obj) {
+    return static_cast<Worker*>(obj)->Process();
+  }
+
+  bool Process() {
+    start_event_.Wait(rtc::Event::kForever);
+    if (quit_)
+      return false;
+    parent_->ProcessShard(begin_, end_);
+    done_event_.Set();
+    return true;
+  }
+
+  BatchAudioProcessing* const parent_;
+  rtc::PlatformThread thread_;
+  rtc::Event start_event_;
+  rtc::Event done_event_;
+  // Only modified by the sweeping thread while the worker is idle; the
+  // events provide the required memory ordering.
+  size_t begin_;
+  size_t end_;
+  bool quit_;
+};
+
+BatchAudioProcessing* BatchAudioProcessing::Create(size_t num_sessions,
+                                                   const Config& config,
+                                                   size_t num_workers) {
+  RTC_CHECK_GT(num_sessions, 0u);
+  ScopedVector<AudioProcessing> sessions;
+  for (size_t i = 0; i < num_sessions; ++i) {
+    AudioProcessing* apm = AudioProcessing::Create(config);
+    if (!apm)
+      return nullptr;
+    sessions.push_back(apm);
+  }
+  return new BatchAudioProcessing(&sessions, num_workers);
+}
+
+BatchAudioProcessing::BatchAudioProcessing(
+    ScopedVector<AudioProcessing>* sessions,
+    size_t num_workers)
+    : session_states_(sessions->size()),
+      capture_num_channels_(0),
+      render_num_channels_(0),
+      sweep_type_(kCaptureSweep) {
+  sessions_.swap(*sessions);
+  const size_t num_sessions = sessions_.size();
+  // There is no point in having more threads than sessions; the sweeping
+  // thread always processes one shard itself.
+  num_workers = std::min(num_workers, num_sessions - 1);
+  for (size_t i = 0; i < num_workers; ++i) {
+    workers_.push_back(new Worker(this));
+  }
+
+  // Shard the sessions evenly over the sweeping thread and the workers.
+  const size_t num_shards = num_workers + 1;
+  for (size_t i = 0; i < num_workers; ++i) {
+    workers_[i]->set_shard((i + 1) * num_sessions / num_shards,
+                           (i + 2) * num_sessions / num_shards);
+  }
+}
+
+BatchAudioProcessing::~BatchAudioProcessing() {
+  // Stop the workers before the sessions they refer to are destroyed.
+  workers_.clear();
+}
+
+int BatchAudioProcessing::Initialize(
+    const ProcessingConfig& processing_config) {
+  processing_config_ = processing_config;
+  int first_error = AudioProcessing::kNoError;
+  for (size_t i = 0; i < sessions_.size(); ++i) {
+    int err = sessions_[i]->Initialize(processing_config);
+    session_states_[i].error = err;
+    if (first_error == AudioProcessing::kNoError)
+      first_error = err;
+  }
+  AllocateAudio();
+  return first_error;
+}
+
+AudioProcessing* BatchAudioProcessing::session(size_t session_index) {
+  RTC_DCHECK_LT(session_index, sessions_.size());
+  return sessions_[session_index];
+}
+
+float* const* BatchAudioProcessing::capture_channels(size_t session_index) {
+  RTC_DCHECK_LT(session_index, sessions_.size());
+  return &capture_channels_[session_index * capture_num_channels_];
+}
+
+float* const* BatchAudioProcessing::render_channels(size_t session_index) {
+  RTC_DCHECK_LT(session_index, sessions_.size());
+  return &render_channels_[session_index * render_num_channels_];
+}
+
+void BatchAudioProcessing::set_stream_delay_ms(size_t session_index,
+                                               int delay_ms) {
+  RTC_DCHECK_LT(session_index, sessions_.size());
+  session_states_[session_index].stream_delay_ms = delay_ms;
+}
+
+void BatchAudioProcessing::set_stream_analog_level(size_t session_index,
+                                                   int level) {
+  RTC_DCHECK_LT(session_index, sessions_.size());
+  session_states_[session_index].analog_level = level;
+}
+
+int BatchAudioProcessing::stream_analog_level(size_t session_index) const {
+  RTC_DCHECK_LT(session_index, sessions_.size());
+  return session_states_[session_index].analog_level;
+}
+
+int BatchAudioProcessing::session_error(size_t session_index) const {
+  RTC_DCHECK_LT(session_index, sessions_.size());
+  return session_states_[session_index].error;
+}
+
+int BatchAudioProcessing::ProcessRenderSweep() {
+  return RunSweep(kRenderSweep);
+}
+
+int BatchAudioProcessing::ProcessCaptureSweep() {
+  return RunSweep(kCaptureSweep);
+}
+
+int BatchAudioProcessing::RunSweep(SweepType type) {
+  sweep_type_ = type;
+  for (size_t i = 0; i < workers_.size(); ++i) {
+    workers_[i]->Start();
+  }
+  ProcessShard(0, sessions_.size() / (workers_.size() + 1));
+  for (size_t i = 0; i < workers_.size(); ++i) {
+    workers_[i]->Wait();
+  }
+
+  for (size_t i = 0; i < session_states_.size(); ++i) {
+    if (session_states_[i].error != AudioProcessing::kNoError)
+      return session_states_[i].error;
+  }
+  return AudioProcessing::kNoError;
+}
+
+void BatchAudioProcessing::ProcessShard(size_t begin, size_t end) {
+  for (size_t i = begin; i < end; ++i) {
+    ProcessSession(i);
+  }
+}
+
+void BatchAudioProcessing::ProcessSession(size_t session_index) {
+  AudioProcessing* apm = sessions_[session_index];
+  SessionState* state = &session_states_[session_index];
+
+  if (sweep_type_ == kRenderSweep) {
+    float* const* channels = render_channels(session_index);
+    state->error = apm->ProcessReverseStream(
+        channels, processing_config_.reverse_input_stream(),
+        processing_config_.reverse_output_stream(), channels);
+    return;
+  }
+
+  GainControl* gain_control = apm->gain_control();
+  const bool analog_agc = gain_control->is_enabled() &&
+                          gain_control->mode() == GainControl::kAdaptiveAnalog;
+  if (analog_agc) {
+    state->error = gain_control->set_stream_analog_level(state->analog_level);
+    if (state->error != AudioProcessing::kNoError)
+      return;
+  }
+  state->error = apm->set_stream_delay_ms(state->stream_delay_ms);
+  // A clamped delay is reported as a warning and processing proceeds, just
+  // as for a standalone instance.
+  if (state->error != AudioProcessing::kNoError &&
+      state->error != AudioProcessing::kBadStreamParameterWarning) {
+    return;
+  }
+
+  float* const* channels = capture_channels(session_index);
+  state->error = apm->ProcessStream(channels, processing_config_.input_stream(),
+                                    processing_config_.output_stream(),
+                                    channels);
+  if (analog_agc)
+    state->analog_level = gain_control->stream_analog_level();
+}
+
+void BatchAudioProcessing::AllocateAudio() {
+  const StreamConfig& input = processing_config_.input_stream();
+  const StreamConfig& output = processing_config_.output_stream();
+  const StreamConfig& rev_input = processing_config_.reverse_input_stream();
+  const StreamConfig& rev_output = processing_config_.reverse_output_stream();
+
+  // The blocks are processed in place, so each session needs room for the
+  // larger of its input and output formats.
+  const size_t capture_frames = std::max(input.num_frames(),
+                                         output.num_frames());
+  capture_num_channels_ = static_cast<size_t>(std::max(
+      input.num_channels() + (input.has_keyboard() ? 1 : 0),
+      output.num_channels() + (output.has_keyboard() ? 1 : 0)));
+  const size_t render_frames = std::max(rev_input.num_frames(),
+                                        rev_output.num_frames());
+  render_num_channels_ = static_cast<size_t>(
+      std::max(rev_input.num_channels(), rev_output.num_channels()));
+
+  const size_t num_sessions = sessions_.size();
+  capture_audio_.assign(num_sessions * capture_num_channels_ * capture_frames,
+                        0.f);
+  render_audio_.assign(num_sessions * render_num_channels_ * render_frames,
+                       0.f);
+  capture_channels_.resize(num_sessions * capture_num_channels_);
+  render_channels_.resize(num_sessions * render_num_channels_);
+  for (size_t i = 0; i < capture_channels_.size(); ++i) {
+    capture_channels_[i] = &capture_audio_[i * capture_frames];
+  }
+  for (size_t i = 0; i < render_channels_.size(); ++i) {
+    render_channels_[i] = &render_audio_[i * render_frames];
+  }
+}
+
+}  // namespace webrtc
@@ -0,0 +1,131 @@
+/*
+ *  Copyright (c) 2016 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef WEBRTC_MODULES_AUDIO_PROCESSING_BATCH_AUDIO_PROCESSING_H_
+#define WEBRTC_MODULES_AUDIO_PROCESSING_BATCH_AUDIO_PROCESSING_H_
+
+#include <vector>
+
+#include "webrtc/base/constructormagic.h"
+#include "webrtc/base/event.h"
+#include "webrtc/base/platform_thread.h"
+#include "webrtc/base/scoped_ptr.h"
+#include "webrtc/common.h"
+#include "webrtc/modules/audio_processing/include/audio_processing.h"
+#include "webrtc/system_wrappers/include/scoped_vector.h"
+
+namespace webrtc {
+
+// Runs many independent APM sessions (e.g. one per call on a media server)
+// in lock-step sweeps of 10 ms frames.
+//
+// The audio of all sessions lives in two contiguous, session-major float
+// blocks (one for capture, one for render), laid out as
+// [session][channel][frame]. A sweep processes every session once; the
+// sessions are sharded into contiguous ranges, one per worker thread, so that
+// each core walks a dense region of the audio blocks and a stable set of
+// component states.
+//
+// Each session is a regular AudioProcessing instance, so the output of every
+// session is bit-exact with a standalone AudioProcessingImpl fed the same
+// data and configured the same way. Sessions are configured through
+// session(), after Initialize() and before the first sweep.
+//
+// The sweep methods must all be called from the same thread.
+class BatchAudioProcessing {
+ public:
+  // Creates |num_sessions| sessions using |config|. |num_workers| is the
+  // number of additional threads used to process the sweeps; with zero
+  // workers all sessions are processed on the calling thread. Returns null if
+  // the sessions cannot be created, e.g. for an unsupported beamformer
+  // configuration.
+  static BatchAudioProcessing* Create(size_t num_sessions,
+                                      const Config& config,
+                                      size_t num_workers);
+  ~BatchAudioProcessing();
+
+  // Initializes all sessions to |processing_config| and (re)allocates the
+  // audio blocks. Returns the first error reported by any session.
+  int Initialize(const ProcessingConfig& processing_config);
+
+  size_t num_sessions() const { return sessions_.size(); }
+  size_t num_workers() const { return workers_.size(); }
+  AudioProcessing* session(size_t session_index);
+
+  // Per-session channel pointers into the capture and render audio blocks.
+  // The capture channels are read as input and overwritten with the
+  // processed output by ProcessCaptureSweep(); the render channels are read
+  // by ProcessRenderSweep() and, when the reverse stream is processed,
+  // overwritten with its output.
+  float* const* capture_channels(size_t session_index);
+  float* const* render_channels(size_t session_index);
+
+  // Per-session stream parameters which must be set before every capture
+  // sweep, as with the corresponding AudioProcessing setters.
+  void set_stream_delay_ms(size_t session_index, int delay_ms);
+  void set_stream_analog_level(size_t session_index, int level);
+  int stream_analog_level(size_t session_index) const;
+
+  // Runs ProcessReverseStream() on every session.
+  int ProcessRenderSweep();
+
+  // Runs ProcessStream() on every session.
+  int ProcessCaptureSweep();
+
+  // Error code returned by |session_index| during the last sweep.
+  int session_error(size_t session_index) const;
+
+ private:
+  enum SweepType { kRenderSweep, kCaptureSweep };
+
+  struct SessionState {
+    SessionState() : stream_delay_ms(0), analog_level(0), error(0) {}
+    int stream_delay_ms;
+    int analog_level;
+    int error;
+  };
+
+  class Worker;
+
+  // Takes ownership of the contents of |sessions|.
+  BatchAudioProcessing(ScopedVector<AudioProcessing>* sessions,
+                       size_t num_workers);
+
+  // Processes the sessions in [begin, end) for the current sweep.
+  void ProcessShard(size_t begin, size_t end);
+  void ProcessSession(size_t session_index);
+  int RunSweep(SweepType type);
+  void AllocateAudio();
+
+  ScopedVector<AudioProcessing> sessions_;
+  std::vector<SessionState> session_states_;
+  ScopedVector<Worker> workers_;
+
+  ProcessingConfig processing_config_;
+
+  // Contiguous audio blocks and the per-session channel pointer tables into
+  // them, each table holding |num_channels| entries per session.
+  std::vector<float> capture_audio_;
+  std::vector<float> render_audio_;
+  std::vector<float*> capture_channels_;
+  std::vector<float*> render_channels_;
+  size_t capture_num_channels_;
+  size_t render_num_channels_;
+
+  // Written by the sweeping thread before the workers are released and read
+  // by the workers only while a sweep is in progress.
+  SweepType sweep_type_;
+
+  RTC_DISALLOW_COPY_AND_ASSIGN(BatchAudioProcessing);
+};
+
+}  // namespace webrtc
+
+#endif  // WEBRTC_MODULES_AUDIO_PROCESSING_BATCH_AUDIO_PROCESSING_H_
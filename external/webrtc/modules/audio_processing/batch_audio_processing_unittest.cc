@@ -0,0 +1,176 @@
+/*
+ *  Copyright (c) 2016 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "webrtc/modules/audio_processing/batch_audio_processing.h"
+
+#include <math.h>
+
+#include <vector>
+
+#include "testing/gtest/include/gtest/gtest.h"
+#include "webrtc/base/scoped_ptr.h"
+#include "webrtc/common_audio/channel_buffer.h"
+#include "webrtc/config.h"
+
+namespace webrtc {
+namespace {
+
+const int kSampleRateHz = 16000;
+const size_t kNumFrames = 160;
+const size_t kNumSessions = 5;
+const int kNumSweeps = 50;
+
+void ConfigureSession(AudioProcessing* apm) {
+  ASSERT_EQ(AudioProcessing::kNoError, apm->high_pass_filter()->Enable(true));
+  ASSERT_EQ(AudioProcessing::kNoError, apm->echo_cancellation()->Enable(true));
+  ASSERT_EQ(AudioProcessing::kNoError,
+            apm->noise_suppression()->set_level(NoiseSuppression::kHigh));
+  ASSERT_EQ(AudioProcessing::kNoError, apm->noise_suppression()->Enable(true));
+  ASSERT_EQ(AudioProcessing::kNoError,
+            apm->gain_control()->set_mode(GainControl::kAdaptiveAnalog));
+  ASSERT_EQ(AudioProcessing::kNoError,
+            apm->gain_control()->set_analog_level_limits(0, 255));
+  ASSERT_EQ(AudioProcessing::kNoError, apm->gain_control()->Enable(true));
+}
+
+// Deterministic, session dependent test signal.
+void GenerateFrame(size_t session, int sweep, bool render, float* audio) {
+  const float frequency = 200.f + 100.f * session + (render ? 50.f : 0.f);
+  for (size_t i = 0; i < kNumFrames; ++i) {
+    const float t = static_cast<float>(sweep * kNumFrames + i) / kSampleRateHz;
+    audio[i] = 8000.f * sinf(2.f * static_cast<float>(M_PI) * frequency * t) /
+               32768.f;
+  }
+}
+
+void RunBitExactnessTest(size_t num_workers) {
+  ProcessingConfig processing_config = {{{kSampleRateHz, 1},
+                                         {kSampleRateHz, 1},
+                                         {kSampleRateHz, 1},
+                                         {kSampleRateHz, 1}}};
+  Config config;
+  rtc::scoped_ptr<BatchAudioProcessing> batch(
+      BatchAudioProcessing::Create(kNumSessions, config, num_workers));
+  ASSERT_TRUE(batch.get() != nullptr);
+  ASSERT_EQ(AudioProcessing::kNoError, batch->Initialize(processing_config));
+
+  rtc::scoped_ptr<AudioProcessing> reference[kNumSessions];
+  for (size_t i = 0; i < kNumSessions; ++i) {
+    ConfigureSession(batch->session(i));
+    reference[i].reset(AudioProcessing::Create(config));
+    ASSERT_EQ(AudioProcessing::kNoError,
+              reference[i]->Initialize(processing_config));
+    ConfigureSession(reference[i].get());
+  }
+
+  ChannelBuffer<float> reference_audio(kNumFrames, 1);
+  int reference_level[kNumSessions] = {0};
+  for (size_t i = 0; i < kNumSessions; ++i) {
+    reference_level[i] = 100;
+    batch->set_stream_analog_level(i, 100);
+  }
+
+  for (int sweep = 0; sweep < kNumSweeps; ++sweep) {
+    for (size_t i = 0; i < kNumSessions; ++i) {
+      GenerateFrame(i, sweep, true, batch->render_channels(i)[0]);
+    }
+    ASSERT_EQ(AudioProcessing::kNoError, batch->ProcessRenderSweep());
+
+    for (size_t i = 0; i < kNumSessions; ++i) {
+      GenerateFrame(i, sweep, false, batch->capture_channels(i)[0]);
+      batch->set_stream_delay_ms(i, 20);
+    }
+    ASSERT_EQ(AudioProcessing::kNoError, batch->ProcessCaptureSweep());
+
+    for (size_t i = 0; i < kNumSessions; ++i) {
+      AudioProcessing* apm = reference[i].get();
+      GenerateFrame(i, sweep, true, reference_audio.channels()[0]);
+      ASSERT_EQ(AudioProcessing::kNoError,
+                apm->ProcessReverseStream(
+                    reference_audio.channels(),
+                    processing_config.reverse_input_stream(),
+                    processing_config.reverse_output_stream(),
+                    reference_audio.channels()));
+
+      GenerateFrame(i, sweep, false, reference_audio.channels()[0]);
+      ASSERT_EQ(AudioProcessing::kNoError,
+                apm->gain_control()->set_stream_analog_level(
+                    reference_level[i]));
+      ASSERT_EQ(AudioProcessing::kNoError, apm->set_stream_delay_ms(20));
+      ASSERT_EQ(AudioProcessing::kNoError,
+                apm->ProcessStream(reference_audio.channels(),
+                                   processing_config.input_stream(),
+                                   processing_config.output_stream(),
+                                   reference_audio.channels()));
+      reference_level[i] = apm->gain_control()->stream_analog_level();
+
+      EXPECT_EQ(reference_level[i], batch->stream_analog_level(i));
+      for (size_t j = 0; j < kNumFrames; ++j) {
+        ASSERT_EQ(reference_audio.channels()[0][j],
+                  batch->capture_channels(i)[0][j]);
+      }
+    }
+  }
+}
+
+}  // namespace
+
+TEST(BatchAudioProcessingTest, BitExactWithStandaloneSessions) {
+  RunBitExactnessTest(0);
+}
+
+TEST(BatchAudioProcessingTest, BitExactWithStandaloneSessionsUsingWorkers) {
+  RunBitExactnessTest(2);
+}
+
+TEST(BatchAudioProcessingTest, WorkersAreCappedBySessions) {
+  Config config;
+  rtc::scoped_ptr<BatchAudioProcessing> batch(
+      BatchAudioProcessing::Create(3, config, 8));
+  ASSERT_TRUE(batch.get() != nullptr);
+  EXPECT_EQ(2u, batch->num_workers());
+}
+
+TEST(BatchAudioProcessingTest, ReportsSessionErrors) {
+  ProcessingConfig processing_config = {{{kSampleRateHz, 1},
+                                         {kSampleRateHz, 1},
+                                         {kSampleRateHz, 1},
+                                         {kSampleRateHz, 1}}};
+  // The legacy analog AGC validates the level against its limits.
+  Config config;
+  config.Set<ExperimentalAgc>(new ExperimentalAgc(false));
+  rtc::scoped_ptr<BatchAudioProcessing> batch(
+      BatchAudioProcessing::Create(2, config, 1));
+  ASSERT_TRUE(batch.get() != nullptr);
+  ASSERT_EQ(AudioProcessing::kNoError, batch->Initialize(processing_config));
+  ConfigureSession(batch->session(1));
+
+  // An analog level outside of the configured limits fails only the session
+  // it was given to.
+  batch->set_stream_analog_level(1, 300);
+  EXPECT_EQ(AudioProcessing::kBadParameterError, batch->ProcessCaptureSweep());
+  EXPECT_EQ(AudioProcessing::kNoError, batch->session_error(0));
+  EXPECT_EQ(AudioProcessing::kBadParameterError, batch->session_error(1));
+}
+
+TEST(BatchAudioProcessingTest, FailsForUnsupportedBeamformerFftSize) {
+  std::vector<Point> array_geometry;
+  array_geometry.push_back(Point(0.f, 0.f, 0.f));
+  array_geometry.push_back(Point(0.05f, 0.f, 0.f));
+  Config config;
+  config.Set<Beamforming>(new Beamforming(
+      true, array_geometry,
+      SphericalPointf(static_cast<float>(M_PI) / 2.f, 0.f, 1.f), 100));
+  rtc::scoped_ptr<BatchAudioProcessing> batch(
+      BatchAudioProcessing::Create(2, config, 1));
+  EXPECT_TRUE(batch.get() == nullptr);
+}
+
+}  // namespace webrtc
@@ -11,6 +11,8 @@
 #ifndef WEBRTC_MODULES_AUDIO_PROCESSING_BEAMFORMER_ARRAY_UTIL_H_
 #define WEBRTC_MODULES_AUDIO_PROCESSING_BEAMFORMER_ARRAY_UTIL_H_
 
+#include <stddef.h>
+
 #include <cmath>
 #include <vector>
 
@@ -101,6 +103,9 @@ struct SphericalPoint {
 
 using SphericalPointf = SphericalPoint<float>;
 
+// The FFT size the beamformer uses unless configured otherwise.
+const size_t kDefaultBeamformerFftSize = 256;
+
 // Helper functions to transform degrees to radians and the inverse.
 template <typename T>
 T DegreesToRadians(T angle_degrees) {
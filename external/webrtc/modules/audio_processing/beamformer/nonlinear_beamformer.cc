@@ -74,30 +74,11 @@ const float kHoldTargetSeconds = 0.25f;
 // recording from broadside.
 const float kCompensationGain = 2.f;
 
-// Does conjugate(|norm_mat|) * |mat| * transpose(|norm_mat|). No extra space is
-// used; to accomplish this, we compute both multiplications in the same loop.
-// The returned norm is clamped to be non-negative.
-float Norm(const ComplexMatrix<float>& mat,
-           const ComplexMatrix<float>& norm_mat) {
-  RTC_CHECK_EQ(norm_mat.num_rows(), 1);
-  RTC_CHECK_EQ(norm_mat.num_columns(), mat.num_rows());
-  RTC_CHECK_EQ(norm_mat.num_columns(), mat.num_columns());
-
-  complex<float> first_product = complex<float>(0.f, 0.f);
-  complex<float> second_product = complex<float>(0.f, 0.f);
+// The number of interferer scenarios, one on each side of the target.
+const size_t kNumInterfScenarios = 2;
 
-  const complex<float>* const* mat_els = mat.elements();
-  const complex<float>* const* norm_mat_els = norm_mat.elements();
-
-  for (int i = 0; i < norm_mat.num_columns(); ++i) {
-    for (int j = 0; j < norm_mat.num_columns(); ++j) {
-      first_product += conj(norm_mat_els[0][j]) * mat_els[j][i];
-    }
-    second_product += first_product * norm_mat_els[0][i];
-    first_product = 0.f;
-  }
-  return std::max(second_product.real(), 0.f);
-}
+// The alignment of the planes of NonlinearBeamformer::BinPlanes in bytes.
+const size_t kPlaneAlignment = 64;
 
 // Does conjugate(|lhs|) * |rhs| for row vectors |lhs| and |rhs|.
 complex<float> ConjugateDotProduct(const ComplexMatrix<float>& lhs,
@@ -134,19 +115,6 @@ float SumAbs(const ComplexMatrix<float>& mat) {
   return sum_abs;
 }
 
-// Calculates the sum of squares of a complex matrix.
-float SumSquares(const ComplexMatrix<float>& mat) {
-  float sum_squares = 0.f;
-  const complex<float>* const* mat_els = mat.elements();
-  for (int i = 0; i < mat.num_rows(); ++i) {
-    for (int j = 0; j < mat.num_columns(); ++j) {
-      float abs_value = std::abs(mat_els[i][j]);
-      sum_squares += abs_value * abs_value;
-    }
-  }
-  return sum_squares;
-}
-
 // Does |out| = |in|.' * conj(|in|) for row vector |in|.
 void TransposedConjugatedProduct(const ComplexMatrix<float>& in,
                                  ComplexMatrix<float>* out) {
@@ -162,6 +130,70 @@ void TransposedConjugatedProduct(const ComplexMatrix<float>& in,
   }
 }
 
+// The kernels below operate on |length| consecutive frequency bins, with the
+// real and the imaginary parts in separate arrays.
+
+// Does |power| += |x|^2 and splits |x| into |re| and |im|.
+void SplitAndAccumulatePower(const complex<float>* x,
+                             size_t length,
+                             float* re,
+                             float* im,
+                             float* power) {
+  for (size_t i = 0; i < length; ++i) {
+    re[i] = x[i].real();
+    im[i] = x[i].imag();
+    power[i] += re[i] * re[i] + im[i] * im[i];
+  }
+}
+
+// Does |re| + i * |im| *= |scale|.
+void ScaleSplit(const float* scale, size_t length, float* re, float* im) {
+  for (size_t i = 0; i < length; ++i) {
+    re[i] *= scale[i];
+    im[i] *= scale[i];
+  }
+}
+
+// Does |out| = conj(|lhs|) * |rhs|.
+void ConjugateProduct(const float* lhs_re,
+                      const float* lhs_im,
+                      const float* rhs_re,
+                      const float* rhs_im,
+                      size_t length,
+                      float* out_re,
+                      float* out_im) {
+  for (size_t i = 0; i < length; ++i) {
+    out_re[i] = lhs_re[i] * rhs_re[i] + lhs_im[i] * rhs_im[i];
+    out_im[i] = lhs_re[i] * rhs_im[i] - lhs_im[i] * rhs_re[i];
+  }
+}
+
+// Does |acc_re| + i * |acc_im| += conj(|lhs|) * |rhs|.
+void AccumulateConjugateProduct(const float* lhs_re,
+                                const float* lhs_im,
+                                const float* rhs_re,
+                                const float* rhs_im,
+                                size_t length,
+                                float* acc_re,
+                                float* acc_im) {
+  for (size_t i = 0; i < length; ++i) {
+    acc_re[i] += lhs_re[i] * rhs_re[i] + lhs_im[i] * rhs_im[i];
+    acc_im[i] += lhs_re[i] * rhs_im[i] - lhs_im[i] * rhs_re[i];
+  }
+}
+
+// Does |acc| += real(|a| * |b|).
+void AccumulateRealProduct(const float* a_re,
+                           const float* a_im,
+                           const float* b_re,
+                           const float* b_im,
+                           size_t length,
+                           float* acc) {
+  for (size_t i = 0; i < length; ++i) {
+    acc[i] += a_re[i] * b_re[i] - a_im[i] * b_im[i];
+  }
+}
+
 std::vector<Point> GetCenteredArray(std::vector<Point> array_geometry) {
   for (int dim = 0; dim < 3; ++dim) {
     float center = 0.f;
@@ -181,21 +213,87 @@ std::vector<Point> GetCenteredArray(std::vector<Point> array_geometry) {
 const float NonlinearBeamformer::kHalfBeamWidthRadians = DegreesToRadians(20.f);
 
 // static
-const size_t NonlinearBeamformer::kNumFreqBins;
+const size_t NonlinearBeamformer::kDefaultFftSize;
+const size_t NonlinearBeamformer::kMinFftSize;
+const size_t NonlinearBeamformer::kMaxFftSize;
+
+// static
+bool NonlinearBeamformer::IsValidFftSize(size_t fft_size) {
+  return fft_size >= kMinFftSize && fft_size <= kMaxFftSize &&
+         (fft_size & (fft_size - 1)) == 0;
+}
+
+NonlinearBeamformer::BinPlanes::BinPlanes(size_t num_values,
+                                          size_t num_freq_bins)
+    : num_values_(num_values),
+      stride_((num_freq_bins + kPlaneAlignment / sizeof(float) - 1) /
+              (kPlaneAlignment / sizeof(float)) *
+              (kPlaneAlignment / sizeof(float))),
+      data_(static_cast<float*>(AlignedMalloc(
+          2 * num_values_ * stride_ * sizeof(float), kPlaneAlignment))) {
+  std::fill(data_.get(), data_.get() + 2 * num_values_ * stride_, 0.f);
+}
+
+void NonlinearBeamformer::BinPlanes::SetBin(size_t bin_ix,
+                                            size_t first_value,
+                                            const ComplexMatrixF& mat) {
+  RTC_DCHECK_LE(first_value + mat.num_rows() * mat.num_columns(),
+                num_values_);
+  const complex_f* const* mat_els = mat.elements();
+  size_t value = first_value;
+  for (int i = 0; i < mat.num_rows(); ++i) {
+    for (int j = 0; j < mat.num_columns(); ++j) {
+      re(value)[bin_ix] = mat_els[i][j].real();
+      im(value)[bin_ix] = mat_els[i][j].imag();
+      ++value;
+    }
+  }
+}
 
 NonlinearBeamformer::NonlinearBeamformer(
     const std::vector<Point>& array_geometry,
-    SphericalPointf target_direction)
-    : num_input_channels_(array_geometry.size()),
+    SphericalPointf target_direction,
+    size_t fft_size)
+    : fft_size_(fft_size),
+      num_freq_bins_(fft_size / 2 + 1),
+      window_(fft_size),
+      num_input_channels_(array_geometry.size()),
       array_geometry_(GetCenteredArray(array_geometry)),
       array_normal_(GetArrayNormalIfExists(array_geometry)),
       min_mic_spacing_(GetMinimumSpacing(array_geometry)),
+      new_mask_(num_freq_bins_),
+      time_smooth_mask_(num_freq_bins_),
+      final_mask_(num_freq_bins_),
       target_angle_radians_(target_direction.azimuth()),
       away_radians_(std::min(
           static_cast<float>(M_PI),
           std::max(kMinAwayRadians,
-                   kAwaySlope * static_cast<float>(M_PI) / min_mic_spacing_))) {
-  WindowGenerator::KaiserBesselDerived(kKbdAlpha, kFftSize, window_);
+                   kAwaySlope * static_cast<float>(M_PI) / min_mic_spacing_))),
+      delay_sum_masks_(num_input_channels_, num_freq_bins_),
+      normalized_delay_sum_masks_(num_input_channels_, num_freq_bins_),
+      target_cov_mats_(num_input_channels_ * num_input_channels_,
+                       num_freq_bins_),
+      uniform_cov_mats_(num_input_channels_ * num_input_channels_,
+                        num_freq_bins_),
+      interf_cov_mats_(
+          kNumInterfScenarios * num_input_channels_ * num_input_channels_,
+          num_freq_bins_),
+      wave_numbers_(num_freq_bins_),
+      rxiws_(num_freq_bins_),
+      rpsiws_(kNumInterfScenarios * num_freq_bins_),
+      input_(num_input_channels_, num_freq_bins_),
+      input_scales_(num_freq_bins_),
+      delay_sum_re_(num_freq_bins_),
+      delay_sum_im_(num_freq_bins_),
+      target_norms_(num_freq_bins_),
+      interf_norms_(kNumInterfScenarios * num_freq_bins_),
+      outer_re_(num_freq_bins_),
+      outer_im_(num_freq_bins_),
+      output_re_(num_freq_bins_),
+      output_im_(num_freq_bins_) {
+  RTC_CHECK(IsValidFftSize(fft_size_)) << "Unsupported FFT size "
+                                        << fft_size_;
+  WindowGenerator::KaiserBesselDerived(kKbdAlpha, fft_size_, &window_[0]);
 }
 
 void NonlinearBeamformer::Initialize(int chunk_size_ms, int sample_rate_hz) {
@@ -205,20 +303,20 @@ void NonlinearBeamformer::Initialize(int chunk_size_ms, int sample_rate_hz) {
 
   high_pass_postfilter_mask_ = 1.f;
   is_target_present_ = false;
-  hold_target_blocks_ = kHoldTargetSeconds * 2 * sample_rate_hz / kFftSize;
+  hold_target_blocks_ = kHoldTargetSeconds * 2 * sample_rate_hz / fft_size_;
   interference_blocks_count_ = hold_target_blocks_;
 
   lapped_transform_.reset(new LappedTransform(num_input_channels_,
                                               1,
                                               chunk_length_,
-                                              window_,
-                                              kFftSize,
-                                              kFftSize / 2,
+                                              &window_[0],
+                                              fft_size_,
+                                              fft_size_ / 2,
                                               this));
-  for (size_t i = 0; i < kNumFreqBins; ++i) {
+  for (size_t i = 0; i < num_freq_bins_; ++i) {
     time_smooth_mask_[i] = 1.f;
     final_mask_[i] = 1.f;
-    float freq_hz = (static_cast<float>(i) / kFftSize) * sample_rate_hz_;
+    float freq_hz = (static_cast<float>(i) / fft_size_) * sample_rate_hz_;
     wave_numbers_[i] = 2 * M_PI * freq_hz / kSpeedOfSoundMeterSeconds;
   }
 
@@ -238,8 +336,8 @@ void NonlinearBeamformer::Initialize(int chunk_size_ms, int sample_rate_hz) {
 //             low_mean_end_bin_       high_mean_end_bin_
 //
 void NonlinearBeamformer::InitLowFrequencyCorrectionRanges() {
-  low_mean_start_bin_ = Round(kLowMeanStartHz * kFftSize / sample_rate_hz_);
-  low_mean_end_bin_ = Round(kLowMeanEndHz * kFftSize / sample_rate_hz_);
+  low_mean_start_bin_ = Round(kLowMeanStartHz * fft_size_ / sample_rate_hz_);
+  low_mean_end_bin_ = Round(kLowMeanEndHz * fft_size_ / sample_rate_hz_);
 
   RTC_DCHECK_GT(low_mean_start_bin_, 0U);
   RTC_DCHECK_LT(low_mean_start_bin_, low_mean_end_bin_);
@@ -253,12 +351,12 @@ void NonlinearBeamformer::InitHighFrequencyCorrectionRanges() {
                                           sample_rate_hz_ / 2.f);
   const float kHighMeanEndHz = std::min(0.75f *  kAliasingFreqHz,
                                         sample_rate_hz_ / 2.f);
-  high_mean_start_bin_ = Round(kHighMeanStartHz * kFftSize / sample_rate_hz_);
-  high_mean_end_bin_ = Round(kHighMeanEndHz * kFftSize / sample_rate_hz_);
+  high_mean_start_bin_ = Round(kHighMeanStartHz * fft_size_ / sample_rate_hz_);
+  high_mean_end_bin_ = Round(kHighMeanEndHz * fft_size_ / sample_rate_hz_);
 
   RTC_DCHECK_LT(low_mean_end_bin_, high_mean_end_bin_);
   RTC_DCHECK_LT(high_mean_start_bin_, high_mean_end_bin_);
-  RTC_DCHECK_LT(high_mean_end_bin_, kNumFreqBins - 1);
+  RTC_DCHECK_LT(high_mean_end_bin_, num_freq_bins_ - 1);
 }
 
 void NonlinearBeamformer::InitInterfAngles() {
@@ -297,52 +395,59 @@ void NonlinearBeamformer::InitInterfAngles() {
 }
 
 void NonlinearBeamformer::InitDelaySumMasks() {
-  for (size_t f_ix = 0; f_ix < kNumFreqBins; ++f_ix) {
-    delay_sum_masks_[f_ix].Resize(1, num_input_channels_);
+  ComplexMatrixF delay_sum_mask(1, num_input_channels_);
+  for (size_t f_ix = 0; f_ix < num_freq_bins_; ++f_ix) {
     CovarianceMatrixGenerator::PhaseAlignmentMasks(
-        f_ix, kFftSize, sample_rate_hz_, kSpeedOfSoundMeterSeconds,
-        array_geometry_, target_angle_radians_, &delay_sum_masks_[f_ix]);
-
-    complex_f norm_factor = sqrt(
-        ConjugateDotProduct(delay_sum_masks_[f_ix], delay_sum_masks_[f_ix]));
-    delay_sum_masks_[f_ix].Scale(1.f / norm_factor);
-    normalized_delay_sum_masks_[f_ix].CopyFrom(delay_sum_masks_[f_ix]);
-    normalized_delay_sum_masks_[f_ix].Scale(1.f / SumAbs(
-        normalized_delay_sum_masks_[f_ix]));
+        f_ix, fft_size_, sample_rate_hz_, kSpeedOfSoundMeterSeconds,
+        array_geometry_, target_angle_radians_, &delay_sum_mask);
+
+    complex_f norm_factor =
+        sqrt(ConjugateDotProduct(delay_sum_mask, delay_sum_mask));
+    delay_sum_mask.Scale(1.f / norm_factor);
+    delay_sum_masks_.SetBin(f_ix, 0, delay_sum_mask);
+    delay_sum_mask.Scale(1.f / SumAbs(delay_sum_mask));
+    normalized_delay_sum_masks_.SetBin(f_ix, 0, delay_sum_mask);
   }
 }
 
 void NonlinearBeamformer::InitTargetCovMats() {
-  for (size_t i = 0; i < kNumFreqBins; ++i) {
-    target_cov_mats_[i].Resize(num_input_channels_, num_input_channels_);
-    TransposedConjugatedProduct(delay_sum_masks_[i], &target_cov_mats_[i]);
+  ComplexMatrixF delay_sum_mask(1, num_input_channels_);
+  ComplexMatrixF target_cov_mat(num_input_channels_, num_input_channels_);
+  complex_f* const delay_sum_mask_els = delay_sum_mask.elements()[0];
+  for (size_t i = 0; i < num_freq_bins_; ++i) {
+    for (int c_ix = 0; c_ix < num_input_channels_; ++c_ix) {
+      delay_sum_mask_els[c_ix] = complex_f(delay_sum_masks_.re(c_ix)[i],
+                                           delay_sum_masks_.im(c_ix)[i]);
+    }
+    TransposedConjugatedProduct(delay_sum_mask, &target_cov_mat);
+    target_cov_mats_.SetBin(i, 0, target_cov_mat);
   }
 }
 
 void NonlinearBeamformer::InitDiffuseCovMats() {
-  for (size_t i = 0; i < kNumFreqBins; ++i) {
-    uniform_cov_mat_[i].Resize(num_input_channels_, num_input_channels_);
+  ComplexMatrixF uniform_cov_mat(num_input_channels_, num_input_channels_);
+  for (size_t i = 0; i < num_freq_bins_; ++i) {
     CovarianceMatrixGenerator::UniformCovarianceMatrix(
-        wave_numbers_[i], array_geometry_, &uniform_cov_mat_[i]);
-    complex_f normalization_factor = uniform_cov_mat_[i].elements()[0][0];
-    uniform_cov_mat_[i].Scale(1.f / normalization_factor);
-    uniform_cov_mat_[i].Scale(1 - kBalance);
+        wave_numbers_[i], array_geometry_, &uniform_cov_mat);
+    complex_f normalization_factor = uniform_cov_mat.elements()[0][0];
+    uniform_cov_mat.Scale(1.f / normalization_factor);
+    uniform_cov_mat.Scale(1 - kBalance);
+    uniform_cov_mats_.SetBin(i, 0, uniform_cov_mat);
   }
 }
 
 void NonlinearBeamformer::InitInterfCovMats() {
-  for (size_t i = 0; i < kNumFreqBins; ++i) {
-    interf_cov_mats_[i].clear();
+  RTC_DCHECK_EQ(interf_angles_radians_.size(), kNumInterfScenarios);
+  const size_t num_elements = num_input_channels_ * num_input_channels_;
+  ComplexMatrixF angled_cov_mat(num_input_channels_, num_input_channels_);
+  for (size_t i = 0; i < num_freq_bins_; ++i) {
     for (size_t j = 0; j < interf_angles_radians_.size(); ++j) {
-      interf_cov_mats_[i].push_back(new ComplexMatrixF(num_input_channels_,
-                                                       num_input_channels_));
-      ComplexMatrixF angled_cov_mat(num_input_channels_, num_input_channels_);
       CovarianceMatrixGenerator::AngledCovarianceMatrix(
           kSpeedOfSoundMeterSeconds,
           interf_angles_radians_[j],
           i,
-          kFftSize,
-          kNumFreqBins,
+          fft_size_,
+          num_freq_bins_,
           sample_rate_hz_,
           array_geometry_,
           &angled_cov_mat);
@@ -351,17 +456,66 @@ void NonlinearBeamformer::InitInterfCovMats() {
       angled_cov_mat.Scale(1.f / normalization_factor);
       // Weighted average of matrices.
       angled_cov_mat.Scale(kBalance);
-      interf_cov_mats_[i][j]->Add(uniform_cov_mat_[i], angled_cov_mat);
+      interf_cov_mats_.SetBin(i, j * num_elements, angled_cov_mat);
+    }
+  }
+  for (size_t j = 0; j < interf_angles_radians_.size(); ++j) {
+    for (size_t e = 0; e < num_elements; ++e) {
+      const size_t value = j * num_elements + e;
+      for (size_t i = 0; i < num_freq_bins_; ++i) {
+        interf_cov_mats_.re(value)[i] += uniform_cov_mats_.re(e)[i];
+        interf_cov_mats_.im(value)[i] += uniform_cov_mats_.im(e)[i];
+      }
     }
   }
 }
 
 void NonlinearBeamformer::NormalizeCovMats() {
-  for (size_t i = 0; i < kNumFreqBins; ++i) {
-    rxiws_[i] = Norm(target_cov_mats_[i], delay_sum_masks_[i]);
-    rpsiws_[i].clear();
-    for (size_t j = 0; j < interf_angles_radians_.size(); ++j) {
-      rpsiws_[i].push_back(Norm(*interf_cov_mats_[i][j], delay_sum_masks_[i]));
+  QuadraticForms(delay_sum_masks_, 0, num_freq_bins_);
+  for (size_t i = 0; i < num_freq_bins_; ++i) {
+    rxiws_[i] = std::max(target_norms_[i], 0.f);
+  }
+  for (size_t i = 0; i < rpsiws_.size(); ++i) {
+    rpsiws_[i] = std::max(interf_norms_[i], 0.f);
+  }
+}
+
+void NonlinearBeamformer::QuadraticForms(const BinPlanes& vectors,
+                                         size_t first_bin,
+                                         size_t last_bin) {
+  RTC_DCHECK_EQ(vectors.num_values(), static_cast<size_t>(num_input_channels_));
+  RTC_DCHECK_LT(first_bin, last_bin);
+  const size_t length = last_bin - first_bin;
+  const size_t num_elements = num_input_channels_ * num_input_channels_;
+  float* const target_norms = &target_norms_[first_bin];
+  float* const outer_re = &outer_re_[first_bin];
+  float* const outer_im = &outer_im_[first_bin];
+  std::fill(target_norms, target_norms + length, 0.f);
+  for (size_t j = 0; j < kNumInterfScenarios; ++j) {
+    float* const interf_norms = &interf_norms_[j * num_freq_bins_ + first_bin];
+    std::fill(interf_norms, interf_norms + length, 0.f);
+  }
+
+  // The conjugated outer product of the vectors is shared by all the
+  // matrices; element (r, c) of the matrix is weighted by
+  // conj(x[r]) * x[c].
+  for (int r = 0; r < num_input_channels_; ++r) {
+    for (int c = 0; c < num_input_channels_; ++c) {
+      ConjugateProduct(vectors.re(r) + first_bin, vectors.im(r) + first_bin,
+                       vectors.re(c) + first_bin, vectors.im(c) + first_bin,
+                       length, outer_re, outer_im);
+      const size_t e = r * num_input_channels_ + c;
+      AccumulateRealProduct(outer_re, outer_im,
+                            target_cov_mats_.re(e) + first_bin,
+                            target_cov_mats_.im(e) + first_bin, length,
+                            target_norms);
+      for (size_t j = 0; j < kNumInterfScenarios; ++j) {
+        const size_t value = j * num_elements + e;
+        AccumulateRealProduct(outer_re, outer_im,
+                              interf_cov_mats_.re(value) + first_bin,
+                              interf_cov_mats_.im(value) + first_bin, length,
+                              &interf_norms_[j * num_freq_bins_ + first_bin]);
+      }
     }
   }
 }
@@ -412,44 +566,11 @@ void NonlinearBeamformer::ProcessAudioBlock(const complex_f* const* input,
                                             size_t num_freq_bins,
                                             int num_output_channels,
                                             complex_f* const* output) {
-  RTC_CHECK_EQ(num_freq_bins, kNumFreqBins);
+  RTC_CHECK_EQ(num_freq_bins, num_freq_bins_);
   RTC_CHECK_EQ(num_input_channels, num_input_channels_);
   RTC_CHECK_EQ(num_output_channels, 1);
 
-  // Calculating the post-filter masks. Note that we need two for each
-  // frequency bin to account for the positive and negative interferer
-  // angle.
-  for (size_t i = low_mean_start_bin_; i <= high_mean_end_bin_; ++i) {
-    eig_m_.CopyFromColumn(input, i, num_input_channels_);
-    float eig_m_norm_factor = std::sqrt(SumSquares(eig_m_));
-    if (eig_m_norm_factor != 0.f) {
-      eig_m_.Scale(1.f / eig_m_norm_factor);
-    }
-
-    float rxim = Norm(target_cov_mats_[i], eig_m_);
-    float ratio_rxiw_rxim = 0.f;
-    if (rxim > 0.f) {
-      ratio_rxiw_rxim = rxiws_[i] / rxim;
-    }
-
-    complex_f rmw = abs(ConjugateDotProduct(delay_sum_masks_[i], eig_m_));
-    rmw *= rmw;
-    float rmw_r = rmw.real();
-
-    new_mask_[i] = CalculatePostfilterMask(*interf_cov_mats_[i][0],
-                                           rpsiws_[i][0],
-                                           ratio_rxiw_rxim,
-                                           rmw_r);
-    for (size_t j = 1; j < interf_angles_radians_.size(); ++j) {
-      float tmp_mask = CalculatePostfilterMask(*interf_cov_mats_[i][j],
-                                               rpsiws_[i][j],
-                                               ratio_rxiw_rxim,
-                                               rmw_r);
-      if (tmp_mask < new_mask_[i]) {
-        new_mask_[i] = tmp_mask;
-      }
-    }
-  }
+  CalculatePostfilterMasks(input);
 
   ApplyMaskTimeSmoothing();
   EstimateTargetPresence();
@@ -459,35 +580,96 @@ void NonlinearBeamformer::ProcessAudioBlock(const complex_f* const* input,
   ApplyMasks(input, output);
 }
 
-float NonlinearBeamformer::CalculatePostfilterMask(
-    const ComplexMatrixF& interf_cov_mat,
-    float rpsiw,
-    float ratio_rxiw_rxim,
-    float rmw_r) {
-  float rpsim = Norm(interf_cov_mat, eig_m_);
-
-  float ratio = 0.f;
-  if (rpsim > 0.f) {
-    ratio = rpsiw / rpsim;
+// Calculates the postfilter masks, two for each frequency bin to account for
+// the positive and negative interferer angle, and keeps the smaller one.
+void NonlinearBeamformer::CalculatePostfilterMasks(
+    const complex_f* const* input) {
+  const size_t first_bin = low_mean_start_bin_;
+  const size_t last_bin = high_mean_end_bin_ + 1;
+  const size_t length = last_bin - first_bin;
+
+  // Split the input of the bins which get a postfilter mask, normalize it to
+  // unit norm and correlate it with the delay-and-sum masks. Normalizing the
+  // input rather than the quadratic forms keeps them in range for tiny powers.
+  std::fill(&input_scales_[first_bin], &input_scales_[first_bin] + length,
+            0.f);
+  std::fill(&delay_sum_re_[first_bin], &delay_sum_re_[first_bin] + length,
+            0.f);
+  std::fill(&delay_sum_im_[first_bin], &delay_sum_im_[first_bin] + length,
+            0.f);
+  for (int c_ix = 0; c_ix < num_input_channels_; ++c_ix) {
+    SplitAndAccumulatePower(input[c_ix] + first_bin, length,
+                            input_.re(c_ix) + first_bin,
+                            input_.im(c_ix) + first_bin,
+                            &input_scales_[first_bin]);
+  }
+  for (size_t i = first_bin; i < last_bin; ++i) {
+    const float norm = std::sqrt(input_scales_[i]);
+    input_scales_[i] = norm != 0.f ? 1.f / norm : 1.f;
   }
+  for (int c_ix = 0; c_ix < num_input_channels_; ++c_ix) {
+    ScaleSplit(&input_scales_[first_bin], length, input_.re(c_ix) + first_bin,
+               input_.im(c_ix) + first_bin);
+    AccumulateConjugateProduct(delay_sum_masks_.re(c_ix) + first_bin,
+                               delay_sum_masks_.im(c_ix) + first_bin,
+                               input_.re(c_ix) + first_bin,
+                               input_.im(c_ix) + first_bin, length,
+                               &delay_sum_re_[first_bin],
+                               &delay_sum_im_[first_bin]);
+  }
+
+  QuadraticForms(input_, first_bin, last_bin);
+
+  for (size_t i = first_bin; i < last_bin; ++i) {
+    const float rxim = std::max(target_norms_[i], 0.f);
+    float ratio_rxiw_rxim = 0.f;
+    if (rxim > 0.f) {
+      ratio_rxiw_rxim = rxiws_[i] / rxim;
+    }
 
-  return (1.f - std::min(kCutOffConstant, ratio / rmw_r)) /
-         (1.f - std::min(kCutOffConstant, ratio / ratio_rxiw_rxim));
+    const float rmw_r = delay_sum_re_[i] * delay_sum_re_[i] +
+                        delay_sum_im_[i] * delay_sum_im_[i];
+
+    for (size_t j = 0; j < kNumInterfScenarios; ++j) {
+      const size_t ix = j * num_freq_bins_ + i;
+      const float rpsim = std::max(interf_norms_[ix], 0.f);
+      float ratio = 0.f;
+      if (rpsim > 0.f) {
+        ratio = rpsiws_[ix] / rpsim;
+      }
+      const float mask =
+          (1.f - std::min(kCutOffConstant, ratio / rmw_r)) /
+          (1.f - std::min(kCutOffConstant, ratio / ratio_rxiw_rxim));
+      if (j == 0 || mask < new_mask_[i]) {
+        new_mask_[i] = mask;
+      }
+    }
+  }
 }
 
 void NonlinearBeamformer::ApplyMasks(const complex_f* const* input,
                                      complex_f* const* output) {
-  complex_f* output_channel = output[0];
-  for (size_t f_ix = 0; f_ix < kNumFreqBins; ++f_ix) {
-    output_channel[f_ix] = complex_f(0.f, 0.f);
-
-    const complex_f* delay_sum_mask_els =
-        normalized_delay_sum_masks_[f_ix].elements()[0];
-    for (int c_ix = 0; c_ix < num_input_channels_; ++c_ix) {
-      output_channel[f_ix] += input[c_ix][f_ix] * delay_sum_mask_els[c_ix];
+  float* const output_re = &output_re_[0];
+  float* const output_im = &output_im_[0];
+  std::fill(output_re_.begin(), output_re_.end(), 0.f);
+  std::fill(output_im_.begin(), output_im_.end(), 0.f);
+  for (int c_ix = 0; c_ix < num_input_channels_; ++c_ix) {
+    const complex_f* input_channel = input[c_ix];
+    const float* mask_re = normalized_delay_sum_masks_.re(c_ix);
+    const float* mask_im = normalized_delay_sum_masks_.im(c_ix);
+    for (size_t f_ix = 0; f_ix < num_freq_bins_; ++f_ix) {
+      const float x_re = input_channel[f_ix].real();
+      const float x_im = input_channel[f_ix].imag();
+      output_re[f_ix] += x_re * mask_re[f_ix] - x_im * mask_im[f_ix];
+      output_im[f_ix] += x_re * mask_im[f_ix] + x_im * mask_re[f_ix];
     }
+  }
 
-    output_channel[f_ix] *= kCompensationGain * final_mask_[f_ix];
+  complex_f* output_channel = output[0];
+  for (size_t f_ix = 0; f_ix < num_freq_bins_; ++f_ix) {
+    const float gain = kCompensationGain * final_mask_[f_ix];
+    output_channel[f_ix] =
+        complex_f(gain * output_re[f_ix], gain * output_im[f_ix]);
   }
 }
 
@@ -517,8 +699,9 @@ void NonlinearBeamformer::ApplyMaskFrequencySmoothing() {
   //                    v
   // |------|------------|------|
   //  ^<------------------^
-  std::copy(time_smooth_mask_, time_smooth_mask_ + kNumFreqBins, final_mask_);
-  for (size_t i = low_mean_start_bin_; i < kNumFreqBins; ++i) {
+  std::copy(time_smooth_mask_.begin(), time_smooth_mask_.end(),
+            final_mask_.begin());
+  for (size_t i = low_mean_start_bin_; i < num_freq_bins_; ++i) {
     final_mask_[i] = kMaskFrequencySmoothAlpha * final_mask_[i] +
                      (1 - kMaskFrequencySmoothAlpha) * final_mask_[i - 1];
   }
@@ -532,7 +715,8 @@ void NonlinearBeamformer::ApplyMaskFrequencySmoothing() {
 void NonlinearBeamformer::ApplyLowFrequencyCorrection() {
   const float low_frequency_mask =
       MaskRangeMean(low_mean_start_bin_, low_mean_end_bin_ + 1);
-  std::fill(time_smooth_mask_, time_smooth_mask_ + low_mean_start_bin_,
+  std::fill(time_smooth_mask_.begin(),
+            time_smooth_mask_.begin() + low_mean_start_bin_,
             low_frequency_mask);
 }
 
@@ -541,15 +725,15 @@ void NonlinearBeamformer::ApplyLowFrequencyCorrection() {
 void NonlinearBeamformer::ApplyHighFrequencyCorrection() {
   high_pass_postfilter_mask_ =
       MaskRangeMean(high_mean_start_bin_, high_mean_end_bin_ + 1);
-  std::fill(time_smooth_mask_ + high_mean_end_bin_ + 1,
-            time_smooth_mask_ + kNumFreqBins, high_pass_postfilter_mask_);
+  std::fill(time_smooth_mask_.begin() + high_mean_end_bin_ + 1,
+            time_smooth_mask_.end(), high_pass_postfilter_mask_);
 }
 
 // Compute mean over the given range of time_smooth_mask_, [first, last).
 float NonlinearBeamformer::MaskRangeMean(size_t first, size_t last) {
   RTC_DCHECK_GT(last, first);
-  const float sum = std::accumulate(time_smooth_mask_ + first,
-                                    time_smooth_mask_ + last, 0.f);
+  const float sum = std::accumulate(time_smooth_mask_.begin() + first,
+                                    time_smooth_mask_.begin() + last, 0.f);
   return sum / (last - first);
 }
 
@@ -557,8 +741,9 @@ void NonlinearBeamformer::EstimateTargetPresence() {
   const size_t quantile = static_cast<size_t>(
       (high_mean_end_bin_ - low_mean_start_bin_) * kMaskQuantile +
       low_mean_start_bin_);
-  std::nth_element(new_mask_ + low_mean_start_bin_, new_mask_ + quantile,
-                   new_mask_ + high_mean_end_bin_ + 1);
+  std::nth_element(new_mask_.begin() + low_mean_start_bin_,
+                   new_mask_.begin() + quantile,
+                   new_mask_.begin() + high_mean_end_bin_ + 1);
   if (new_mask_[quantile] > kMaskTargetThreshold) {
     is_target_present_ = true;
     interference_blocks_count_ = 0;
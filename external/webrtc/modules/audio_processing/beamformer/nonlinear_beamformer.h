@@ -17,11 +17,12 @@
 #include <math.h>
 #include <vector>
 
+#include "webrtc/base/scoped_ptr.h"
 #include "webrtc/common_audio/lapped_transform.h"
 #include "webrtc/common_audio/channel_buffer.h"
 #include "webrtc/modules/audio_processing/beamformer/beamformer.h"
 #include "webrtc/modules/audio_processing/beamformer/complex_matrix.h"
-#include "webrtc/system_wrappers/include/scoped_vector.h"
+#include "webrtc/system_wrappers/include/aligned_malloc.h"
 
 namespace webrtc {
 
@@ -31,16 +32,30 @@ namespace webrtc {
 //
 // The implemented nonlinear postfilter algorithm taken from "A Robust Nonlinear
 // Beamforming Postprocessor" by Bastiaan Kleijn.
+//
+// The covariance matrices and masks of all frequency bins are stored bin-major
+// (see BinPlanes), so that the postfilter is computed by kernels which run over
+// all bins at once. Nothing is allocated after construction other than the
+// LappedTransform in Initialize().
 class NonlinearBeamformer
   : public Beamformer<float>,
     public LappedTransform::Callback {
  public:
   static const float kHalfBeamWidthRadians;
 
+  // The FFT size trades latency against frequency resolution. It has to be a
+  // power of two in [kMinFftSize, kMaxFftSize].
+  static const size_t kDefaultFftSize = kDefaultBeamformerFftSize;
+  static const size_t kMinFftSize = 128;
+  static const size_t kMaxFftSize = 1024;
+
+  static bool IsValidFftSize(size_t fft_size);
+
   explicit NonlinearBeamformer(
       const std::vector<Point>& array_geometry,
       SphericalPointf target_direction =
-          SphericalPointf(static_cast<float>(M_PI) / 2.f, 0.f, 1.f));
+          SphericalPointf(static_cast<float>(M_PI) / 2.f, 0.f, 1.f),
+      size_t fft_size = kDefaultFftSize);
 
   // Sample rate corresponds to the lower band.
   // Needs to be called before the NonlinearBeamformer can be used.
@@ -63,6 +78,8 @@ class NonlinearBeamformer
   // accordingly.
   bool is_target_present() override { return is_target_present_; }
 
+  size_t fft_size() const { return fft_size_; }
+
  protected:
   // Process one frequency-domain block of audio. This is where the fun
   // happens. Implements LappedTransform::Callback.
@@ -75,11 +92,40 @@ class NonlinearBeamformer
  private:
   FRIEND_TEST_ALL_PREFIXES(NonlinearBeamformerTest,
                            InterfAnglesTakeAmbiguityIntoAccount);
+  FRIEND_TEST_ALL_PREFIXES(NonlinearBeamformerTest,
+                           PostfilterMasksMatchPerBinCalculation);
 
   typedef Matrix<float> MatrixF;
   typedef ComplexMatrix<float> ComplexMatrixF;
   typedef complex<float> complex_f;
 
+  // Holds |num_values| complex values for each of |num_freq_bins| frequency
+  // bins in a single allocation. The real and the imaginary parts of value |i|
+  // are each stored as a plane of all bins, with every plane 64-byte aligned,
+  // so that the kernels access them with unit stride. For matrices, value
+  // |i| corresponds to the element at row |i / num_columns| and column
+  // |i % num_columns|.
+  class BinPlanes {
+   public:
+    BinPlanes(size_t num_values, size_t num_freq_bins);
+
+    size_t num_values() const { return num_values_; }
+
+    float* re(size_t i) { return data_.get() + 2 * i * stride_; }
+    float* im(size_t i) { return re(i) + stride_; }
+    const float* re(size_t i) const { return data_.get() + 2 * i * stride_; }
+    const float* im(size_t i) const { return re(i) + stride_; }
+
+    // Copies the elements of |mat| to the values of bin |bin_ix|, starting at
+    // value |first_value|.
+    void SetBin(size_t bin_ix, size_t first_value, const ComplexMatrixF& mat);
+
+   private:
+    const size_t num_values_;
+    const size_t stride_;
+    rtc::scoped_ptr<float, AlignedFreeDeleter> data_;
+  };
+
   void InitLowFrequencyCorrectionRanges();
   void InitHighFrequencyCorrectionRanges();
   void InitInterfAngles();
@@ -89,12 +135,19 @@ class NonlinearBeamformer
   void InitInterfCovMats();
   void NormalizeCovMats();
 
+  // Computes conj(x) * R * transpose(x) for the vectors |x| in |vectors| and
+  // the target and interferer covariance matrices R of the bins in
+  // [|first_bin|, |last_bin|), and stores them in |target_norms_| and
+  // |interf_norms_|. The results are not clamped.
+  void QuadraticForms(const BinPlanes& vectors,
+                      size_t first_bin,
+                      size_t last_bin);
+
   // Calculates postfilter masks that minimize the mean squared error of our
-  // estimation of the desired signal.
-  float CalculatePostfilterMask(const ComplexMatrixF& interf_cov_mat,
-                                float rpsiw,
-                                float ratio_rxiw_rxim,
-                                float rmxi_r);
+  // estimation of the desired signal, for the bins of |input| in
+  // [|low_mean_start_bin_|, |high_mean_end_bin_|], and stores them in
+  // |new_mask_|.
+  void CalculatePostfilterMasks(const complex_f* const* input);
 
   // Prevents the postfilter masks from degenerating too quickly (a cause of
   // musical noise).
@@ -120,13 +173,12 @@ class NonlinearBeamformer
 
   void EstimateTargetPresence();
 
-  static const size_t kFftSize = 256;
-  static const size_t kNumFreqBins = kFftSize / 2 + 1;
-
   // Deals with the fft transform and blocking.
+  const size_t fft_size_;
+  const size_t num_freq_bins_;
   size_t chunk_length_;
   rtc::scoped_ptr<LappedTransform> lapped_transform_;
-  float window_[kFftSize];
+  std::vector<float> window_;
 
   // Parameters exposed to the user.
   const int num_input_channels_;
@@ -145,12 +197,12 @@ class NonlinearBeamformer
   size_t high_mean_start_bin_;
   size_t high_mean_end_bin_;
 
-  // Quickly varying mask updated every block.
-  float new_mask_[kNumFreqBins];
-  // Time smoothed mask.
-  float time_smooth_mask_[kNumFreqBins];
-  // Time and frequency smoothed mask.
-  float final_mask_[kNumFreqBins];
+  // Quickly varying mask updated every block. Of length |num_freq_bins_|.
+  std::vector<float> new_mask_;
+  // Time smoothed mask. Of length |num_freq_bins_|.
+  std::vector<float> time_smooth_mask_;
+  // Time and frequency smoothed mask. Of length |num_freq_bins_|.
+  std::vector<float> final_mask_;
 
   float target_angle_radians_;
   // Angles of the interferer scenarios.
@@ -158,30 +210,46 @@ class NonlinearBeamformer
   // The angle between the target and the interferer scenarios.
   const float away_radians_;
 
-  // Array of length |kNumFreqBins|, Matrix of size |1| x |num_channels_|.
-  ComplexMatrixF delay_sum_masks_[kNumFreqBins];
-  ComplexMatrixF normalized_delay_sum_masks_[kNumFreqBins];
-
-  // Arrays of length |kNumFreqBins|, Matrix of size |num_input_channels_| x
-  // |num_input_channels_|.
-  ComplexMatrixF target_cov_mats_[kNumFreqBins];
-  ComplexMatrixF uniform_cov_mat_[kNumFreqBins];
-  // Array of length |kNumFreqBins|, Matrix of size |num_input_channels_| x
-  // |num_input_channels_|. ScopedVector has a size equal to the number of
-  // interferer scenarios.
-  ScopedVector<ComplexMatrixF> interf_cov_mats_[kNumFreqBins];
-
-  // Of length |kNumFreqBins|.
-  float wave_numbers_[kNumFreqBins];
-
-  // Preallocated for ProcessAudioBlock()
-  // Of length |kNumFreqBins|.
-  float rxiws_[kNumFreqBins];
-  // The vector has a size equal to the number of interferer scenarios.
-  std::vector<float> rpsiws_[kNumFreqBins];
-
-  // The microphone normalization factor.
-  ComplexMatrixF eig_m_;
+  // Vectors of size |1| x |num_input_channels_| for each bin.
+  BinPlanes delay_sum_masks_;
+  BinPlanes normalized_delay_sum_masks_;
+
+  // Matrices of size |num_input_channels_| x |num_input_channels_| for each
+  // bin.
+  BinPlanes target_cov_mats_;
+  BinPlanes uniform_cov_mats_;
+  // One matrix of size |num_input_channels_| x |num_input_channels_| per
+  // interferer scenario for each bin, one scenario after the other.
+  BinPlanes interf_cov_mats_;
+
+  // Of length |num_freq_bins_|.
+  std::vector<float> wave_numbers_;
+
+  // Of length |num_freq_bins_|.
+  std::vector<float> rxiws_;
+  // Of length |num_freq_bins_| per interferer scenario, one scenario after the
+  // other.
+  std::vector<float> rpsiws_;
+
+  // Preallocated for ProcessAudioBlock().
+  // The input of the current block normalized to unit norm, of size |1| x
+  // |num_input_channels_| for each bin.
+  BinPlanes input_;
+  // The following are of length |num_freq_bins_|: the inverse norm of the
+  // input, the product of |input_| with conj(|delay_sum_masks_|) and
+  // conj(|input_|) * |target_cov_mats_| * transpose(|input_|).
+  std::vector<float> input_scales_;
+  std::vector<float> delay_sum_re_;
+  std::vector<float> delay_sum_im_;
+  std::vector<float> target_norms_;
+  // Like |target_norms_| for |interf_cov_mats_|, one scenario after the other.
+  std::vector<float> interf_norms_;
+  // The outer product of two input channels, of length |num_freq_bins_|.
+  std::vector<float> outer_re_;
+  std::vector<float> outer_im_;
+  // The delay-and-sum beamformed output, of length |num_freq_bins_|.
+  std::vector<float> output_re_;
+  std::vector<float> output_im_;
 
   // For processing the high-frequency input signal.
   float high_pass_postfilter_mask_;
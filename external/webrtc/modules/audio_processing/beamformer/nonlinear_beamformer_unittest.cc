@@ -15,6 +15,9 @@
 
 #include <math.h>
 
+#include <algorithm>
+#include <cmath>
+
 #include "testing/gtest/include/gtest/gtest.h"
 
 namespace webrtc {
@@ -23,6 +26,9 @@ namespace {
 const int kChunkSizeMs = 10;
 const int kSampleRateHz = 16000;
 
+// As in nonlinear_beamformer.cc.
+const float kCutOffConstant = 0.9999f;
+
 SphericalPointf AzimuthToSphericalPoint(float azimuth_radians) {
   return SphericalPointf(azimuth_radians, 0.f, 1.f);
 }
@@ -48,6 +54,63 @@ void AimAndVerify(NonlinearBeamformer* bf, float target_azimuth_radians) {
   Verify(bf, target_azimuth_radians);
 }
 
+// Feeds |bf| with a tone from a far-field source at |azimuth_radians| to the
+// microphones of |array_geometry| and returns the energy of the output of the
+// last chunk.
+float ProcessTone(NonlinearBeamformer* bf,
+                  const std::vector<Point>& array_geometry,
+                  float azimuth_radians,
+                  size_t num_chunks) {
+  const float kSpeedOfSoundMeterSeconds = 343.f;
+  const size_t num_channels = array_geometry.size();
+  const size_t kChunkLength = kSampleRateHz * kChunkSizeMs / 1000;
+  ChannelBuffer<float> input(kChunkLength, num_channels);
+  ChannelBuffer<float> output(kChunkLength, 1);
+  float energy = 0.f;
+  for (size_t i = 0; i < num_chunks; ++i) {
+    for (size_t j = 0; j < kChunkLength; ++j) {
+      const float time_s =
+          static_cast<float>(i * kChunkLength + j) / kSampleRateHz;
+      for (size_t ch = 0; ch < num_channels; ++ch) {
+        const float delay_s = -array_geometry[ch].x() *
+                              std::cos(azimuth_radians) /
+                              kSpeedOfSoundMeterSeconds;
+        input.channels()[ch][j] =
+            1000.f * std::sin(2.f * static_cast<float>(M_PI) * 1000.f *
+                              (time_s - delay_s));
+      }
+    }
+    bf->ProcessChunk(input, &output);
+    energy = 0.f;
+    for (size_t j = 0; j < kChunkLength; ++j) {
+      energy += output.channels()[0][j] * output.channels()[0][j];
+    }
+  }
+  return energy;
+}
+
+// Does conj(|x|) * |mat| * transpose(|x|) for the |num_channels| x
+// |num_channels| matrix |mat| given as |num_channels|^2 values, row by row,
+// starting at value |first_value| of |planes| for bin |bin|.
+template <typename BinPlanes>
+float QuadraticForm(const std::vector<complex<float>>& x,
+                    const BinPlanes& planes,
+                    size_t first_value,
+                    size_t bin) {
+  const size_t num_channels = x.size();
+  complex<float> product(0.f, 0.f);
+  for (size_t c = 0; c < num_channels; ++c) {
+    complex<float> column_product(0.f, 0.f);
+    for (size_t r = 0; r < num_channels; ++r) {
+      const size_t value = first_value + r * num_channels + c;
+      column_product += conj(x[r]) * complex<float>(planes.re(value)[bin],
+                                                    planes.im(value)[bin]);
+    }
+    product += column_product * x[c];
+  }
+  return std::max(product.real(), 0.f);
+}
+
 }  // namespace
 
 TEST(NonlinearBeamformerTest, AimingModifiesBeam) {
@@ -144,4 +207,112 @@ TEST(NonlinearBeamformerTest, InterfAnglesTakeAmbiguityIntoAccount) {
   }
 }
 
+TEST(NonlinearBeamformerTest, SuppressesInterferenceForAllFftSizes) {
+  const float kTargetAzimuthRadians = static_cast<float>(M_PI) / 2.f;
+  std::vector<Point> array_geometry;
+  for (int i = 0; i < 8; ++i) {
+    array_geometry.push_back(Point(0.03f * i, 0.f, 0.f));
+  }
+  for (size_t fft_size = NonlinearBeamformer::kMinFftSize;
+       fft_size <= NonlinearBeamformer::kMaxFftSize; fft_size *= 2) {
+    SCOPED_TRACE(fft_size);
+    NonlinearBeamformer bf(array_geometry,
+                           AzimuthToSphericalPoint(kTargetAzimuthRadians),
+                           fft_size);
+    bf.Initialize(kChunkSizeMs, kSampleRateHz);
+    EXPECT_EQ(fft_size, bf.fft_size());
+    const float target_energy =
+        ProcessTone(&bf, array_geometry, kTargetAzimuthRadians, 100);
+    EXPECT_TRUE(std::isfinite(target_energy));
+    EXPECT_TRUE(bf.is_target_present());
+    const float interference_energy =
+        ProcessTone(&bf, array_geometry, 0.f, 100);
+    EXPECT_TRUE(std::isfinite(interference_energy));
+    EXPECT_GT(target_energy, 10.f * interference_energy);
+  }
+}
+
+TEST(NonlinearBeamformerTest, PostfilterMasksMatchPerBinCalculation) {
+  std::vector<Point> array_geometry;
+  array_geometry.push_back(Point(-0.04f, 0.f, 0.f));
+  array_geometry.push_back(Point(0.f, 0.f, 0.f));
+  array_geometry.push_back(Point(0.07f, 0.f, 0.f));
+  const size_t num_channels = array_geometry.size();
+  NonlinearBeamformer bf(array_geometry);
+  bf.Initialize(kChunkSizeMs, kSampleRateHz);
+  const size_t num_freq_bins = bf.num_freq_bins_;
+  const size_t num_elements = num_channels * num_channels;
+
+  // Random input, with silent bins and bins whose power is too small for its
+  // inverse to be represented.
+  std::vector<std::vector<complex<float>>> input_data(
+      num_channels, std::vector<complex<float>>(num_freq_bins));
+  std::vector<const complex<float>*> input(num_channels);
+  uint32_t state = 1;
+  for (size_t c = 0; c < num_channels; ++c) {
+    for (size_t i = 0; i < num_freq_bins; ++i) {
+      state = 1664525u * state + 1013904223u;
+      const float re = static_cast<float>(state >> 8) / (1 << 24) - 0.5f;
+      state = 1664525u * state + 1013904223u;
+      const float im = static_cast<float>(state >> 8) / (1 << 24) - 0.5f;
+      const float amplitude = i % 7 == 0 ? 0.f : i % 5 == 0 ? 1e-21f : 1000.f;
+      input_data[c][i] = amplitude * complex<float>(re, im);
+    }
+    input[c] = &input_data[c][0];
+  }
+  bf.CalculatePostfilterMasks(&input[0]);
+
+  // The mask of each bin as calculated before the bins were processed
+  // together: the input of the bin is normalized to unit norm and the
+  // quadratic forms are evaluated on it.
+  for (size_t i = bf.low_mean_start_bin_; i <= bf.high_mean_end_bin_; ++i) {
+    SCOPED_TRACE(i);
+    std::vector<complex<float>> x(num_channels);
+    float power = 0.f;
+    for (size_t c = 0; c < num_channels; ++c) {
+      x[c] = input_data[c][i];
+      power += std::norm(x[c]);
+    }
+    const float norm = std::sqrt(power);
+    if (norm != 0.f) {
+      for (size_t c = 0; c < num_channels; ++c) {
+        x[c] *= 1.f / norm;
+      }
+    }
+
+    const float rxim = QuadraticForm(x, bf.target_cov_mats_, 0, i);
+    float ratio_rxiw_rxim = 0.f;
+    if (rxim > 0.f) {
+      ratio_rxiw_rxim = bf.rxiws_[i] / rxim;
+    }
+    complex<float> rmw(0.f, 0.f);
+    for (size_t c = 0; c < num_channels; ++c) {
+      rmw += conj(complex<float>(bf.delay_sum_masks_.re(c)[i],
+                                 bf.delay_sum_masks_.im(c)[i])) *
+             x[c];
+    }
+    const float rmw_r = std::abs(rmw) * std::abs(rmw);
+
+    float expected_mask = 0.f;
+    for (size_t j = 0; j < 2; ++j) {
+      const float rpsim =
+          QuadraticForm(x, bf.interf_cov_mats_, j * num_elements, i);
+      float ratio = 0.f;
+      if (rpsim > 0.f) {
+        ratio = bf.rpsiws_[j * num_freq_bins + i] / rpsim;
+      }
+      const float mask =
+          (1.f - std::min(kCutOffConstant, ratio / rmw_r)) /
+          (1.f - std::min(kCutOffConstant, ratio / ratio_rxiw_rxim));
+      if (j == 0 || mask < expected_mask) {
+        expected_mask = mask;
+      }
+    }
+
+    ASSERT_TRUE(std::isfinite(bf.new_mask_[i]));
+    EXPECT_NEAR(expected_mask, bf.new_mask_[i],
+                1e-4f * std::max(1.f, std::fabs(expected_mask)));
+  }
+}
+
 }  // namespace webrtc
@@ -0,0 +1,279 @@
+/*
+ *  Copyright (c) 2016 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "webrtc/modules/audio_processing/duplex/duplex_engine.h"
+
+#include <string.h>
+
+#include <algorithm>
+
+#include "webrtc/base/atomicops.h"
+#include "webrtc/base/checks.h"
+#include "webrtc/common_audio/include/audio_util.h"
+
+namespace webrtc {
+namespace {
+
+// Periods each ring can hold on top of one chunk, before audio is dropped.
+const size_t kQueuedPeriods = 4;
+
+size_t ChunkFrames(const DuplexEngine::StreamFormat& format) {
+  return static_cast<size_t>(AudioProcessing::kChunkSizeMs *
+                             format.sample_rate_hz / 1000);
+}
+
+size_t QueueFrames(const DuplexEngine::StreamFormat& format) {
+  return kQueuedPeriods * format.period_frames + ChunkFrames(format);
+}
+
+// Processed audio which the capture queue starts out with, so that each
+// OnCapture() call finds a full period ready while its own audio is processed.
+size_t PrimingFrames(const DuplexEngine::StreamFormat& format) {
+  const size_t chunk_frames = ChunkFrames(format);
+  return format.period_frames +
+         (format.period_frames % chunk_frames ? chunk_frames : 0);
+}
+
+void AtomicAdd(volatile int* value, size_t delta) {
+  int old_value;
+  do {
+    old_value = rtc::AtomicOps::AcquireLoad(value);
+  } while (rtc::AtomicOps::CompareAndSwap(
+               value, old_value, old_value + static_cast<int>(delta)) !=
+           old_value);
+}
+
+// Deinterleaves |regions| into |channels|, converting to the [-1, 1] range.
+void DeinterleaveRegions(
+    const SpscRingBuffer<int16_t>::Regions<const int16_t>& regions,
+    size_t num_channels,
+    float* const* channels) {
+  size_t offset = 0;
+  for (int r = 0; r < 2; ++r) {
+    const int16_t* interleaved = regions.data[r];
+    for (size_t i = 0; i < regions.items[r]; ++i) {
+      for (size_t ch = 0; ch < num_channels; ++ch) {
+        channels[ch][offset + i] = S16ToFloat(*interleaved++);
+      }
+    }
+    offset += regions.items[r];
+  }
+}
+
+void InterleaveRegions(
+    const float* const* channels,
+    size_t num_channels,
+    const SpscRingBuffer<int16_t>::Regions<int16_t>& regions) {
+  size_t offset = 0;
+  for (int r = 0; r < 2; ++r) {
+    int16_t* interleaved = regions.data[r];
+    for (size_t i = 0; i < regions.items[r]; ++i) {
+      for (size_t ch = 0; ch < num_channels; ++ch) {
+        *interleaved++ = FloatToS16(channels[ch][offset + i]);
+      }
+    }
+    offset += regions.items[r];
+  }
+}
+
+void AllocateChunk(const StreamConfig& config,
+                   std::vector<float>* chunk,
+                   std::vector<float*>* channels) {
+  chunk->assign(config.num_samples(), 0.f);
+  channels->resize(config.num_channels());
+  for (size_t ch = 0; ch < channels->size(); ++ch) {
+    (*channels)[ch] = &(*chunk)[ch * config.num_frames()];
+  }
+}
+
+}  // namespace
+
+DuplexEngine::DuplexEngine(AudioProcessing* apm,
+                           const StreamFormat& capture_format,
+                           const StreamFormat& render_format)
+    : apm_(apm),
+      capture_format_(capture_format),
+      render_format_(render_format),
+      capture_config_(capture_format.sample_rate_hz,
+                      static_cast<int>(capture_format.num_channels)),
+      render_config_(render_format.sample_rate_hz,
+                     static_cast<int>(render_format.num_channels)),
+      render_queue_(render_format.num_channels, QueueFrames(render_format)),
+      capture_queue_(capture_format.num_channels, QueueFrames(capture_format)),
+      processed_queue_(capture_format.num_channels,
+                       PrimingFrames(capture_format) +
+                           QueueFrames(capture_format)),
+      analog_level_(0),
+      render_queued_frames_(0),
+      capture_queued_frames_(0),
+      processed_frames_(0),
+      render_overruns_(0),
+      capture_overruns_(0),
+      capture_underruns_(0),
+      stream_delay_ms_(0),
+      wake_event_(false, false),
+      thread_(&DuplexEngine::Run, this, "DuplexEngine"),
+      running_(0) {
+  RTC_CHECK(apm_);
+  RTC_CHECK_GT(capture_format_.period_frames, 0u);
+  RTC_CHECK_GT(render_format_.period_frames, 0u);
+  AllocateChunk(capture_config_, &capture_chunk_, &capture_channels_);
+  AllocateChunk(render_config_, &render_chunk_, &render_channels_);
+}
+
+DuplexEngine::~DuplexEngine() {
+  Stop();
+}
+
+int DuplexEngine::Start() {
+  RTC_DCHECK(!rtc::AtomicOps::AcquireLoad(&running_));
+  ProcessingConfig processing_config = {
+      {capture_config_, capture_config_, render_config_, render_config_}};
+  const int err = apm_->Initialize(processing_config);
+  if (err != AudioProcessing::kNoError)
+    return err;
+  analog_level_ = apm_->gain_control()->analog_level_minimum();
+
+  render_queue_.Clear();
+  capture_queue_.Clear();
+  processed_queue_.Clear();
+  processed_queue_.WriteZeros(PrimingFrames(capture_format_));
+
+  rtc::AtomicOps::ReleaseStore(&running_, 1);
+  thread_.Start();
+  thread_.SetPriority(rtc::kRealtimePriority);
+  return AudioProcessing::kNoError;
+}
+
+void DuplexEngine::Stop() {
+  if (!rtc::AtomicOps::AcquireLoad(&running_))
+    return;
+  rtc::AtomicOps::ReleaseStore(&running_, 0);
+  wake_event_.Set();
+  thread_.Stop();
+}
+
+void DuplexEngine::OnRender(const int16_t* audio,
+                            size_t num_frames,
+                            size_t queued_frames) {
+  const size_t written = render_queue_.Write(audio, num_frames);
+  if (written < num_frames)
+    AtomicAdd(&render_overruns_, num_frames - written);
+  rtc::AtomicOps::ReleaseStore(&render_queued_frames_,
+                               static_cast<int>(queued_frames));
+}
+
+void DuplexEngine::OnCapture(int16_t* audio,
+                             size_t num_frames,
+                             size_t queued_frames) {
+  const size_t written = capture_queue_.Write(audio, num_frames);
+  if (written < num_frames)
+    AtomicAdd(&capture_overruns_, num_frames - written);
+  rtc::AtomicOps::ReleaseStore(&capture_queued_frames_,
+                               static_cast<int>(queued_frames));
+  wake_event_.Set();
+
+  const size_t read = processed_queue_.Read(audio, num_frames);
+  if (read < num_frames) {
+    memset(audio + read * capture_format_.num_channels, 0,
+           (num_frames - read) * capture_format_.num_channels *
+               sizeof(*audio));
+    AtomicAdd(&capture_underruns_, num_frames - read);
+  }
+}
+
+DuplexEngine::Statistics DuplexEngine::GetStatistics() const {
+  Statistics stats;
+  stats.processed_frames = rtc::AtomicOps::AcquireLoad(&processed_frames_);
+  stats.render_overruns = rtc::AtomicOps::AcquireLoad(&render_overruns_);
+  stats.capture_overruns = rtc::AtomicOps::AcquireLoad(&capture_overruns_);
+  stats.capture_underruns = rtc::AtomicOps::AcquireLoad(&capture_underruns_);
+  stats.stream_delay_ms = rtc::AtomicOps::AcquireLoad(&stream_delay_ms_);
+  return stats;
+}
+
+bool DuplexEngine::Run(void* obj) {
+  return static_cast<DuplexEngine*>(obj)->Process();
+}
+
+bool DuplexEngine::Process() {
+  wake_event_.Wait(rtc::Event::kForever);
+  if (!rtc::AtomicOps::AcquireLoad(&running_))
+    return false;
+  // The render audio is analyzed first, so that the capture audio always
+  // finds the render audio it may contain the echo of.
+  AnalyzeRenderChunks();
+  ProcessCaptureChunks();
+  return true;
+}
+
+void DuplexEngine::AnalyzeRenderChunks() {
+  const size_t chunk_frames = render_config_.num_frames();
+  while (render_queue_.ReadItemsAvailable() >= chunk_frames) {
+    DeinterleaveRegions(render_queue_.GetReadRegions(chunk_frames),
+                        render_format_.num_channels, &render_channels_[0]);
+    render_queue_.Consume(chunk_frames);
+    apm_->ProcessReverseStream(&render_channels_[0], render_config_,
+                               render_config_, &render_channels_[0]);
+  }
+}
+
+void DuplexEngine::ProcessCaptureChunks() {
+  const size_t chunk_frames = capture_config_.num_frames();
+  const bool analog_agc =
+      apm_->gain_control()->is_enabled() &&
+      apm_->gain_control()->mode() == GainControl::kAdaptiveAnalog;
+  while (capture_queue_.ReadItemsAvailable() >= chunk_frames) {
+    const int delay_ms =
+        StreamDelayMs(render_queue_.ReadItemsAvailable(),
+                      capture_queue_.ReadItemsAvailable() - chunk_frames);
+    rtc::AtomicOps::ReleaseStore(&stream_delay_ms_, delay_ms);
+    apm_->set_stream_delay_ms(delay_ms);
+    if (analog_agc)
+      apm_->gain_control()->set_stream_analog_level(analog_level_);
+
+    DeinterleaveRegions(capture_queue_.GetReadRegions(chunk_frames),
+                        capture_format_.num_channels, &capture_channels_[0]);
+    capture_queue_.Consume(chunk_frames);
+    apm_->ProcessStream(&capture_channels_[0], capture_config_,
+                        capture_config_, &capture_channels_[0]);
+    if (analog_agc)
+      analog_level_ = apm_->gain_control()->stream_analog_level();
+
+    const SpscRingBuffer<int16_t>::Regions<int16_t> regions =
+        processed_queue_.GetWriteRegions(chunk_frames);
+    const size_t written = regions.items[0] + regions.items[1];
+    InterleaveRegions(&capture_channels_[0], capture_format_.num_channels,
+                      regions);
+    processed_queue_.Commit(written);
+    if (written < chunk_frames)
+      AtomicAdd(&capture_overruns_, chunk_frames - written);
+    AtomicAdd(&processed_frames_, chunk_frames);
+  }
+}
+
+// The delay from analyzing the newest render chunk until it is played out,
+// plus the delay from capturing the current capture chunk until now.
+int DuplexEngine::StreamDelayMs(size_t render_backlog,
+                                size_t capture_backlog) const {
+  const int render_frames =
+      rtc::AtomicOps::AcquireLoad(&render_queued_frames_) +
+      static_cast<int>(render_format_.period_frames) -
+      static_cast<int>(render_backlog + render_config_.num_frames());
+  const int capture_frames =
+      rtc::AtomicOps::AcquireLoad(&capture_queued_frames_) +
+      static_cast<int>(capture_backlog + capture_config_.num_frames());
+  const int delay_ms =
+      std::max(render_frames, 0) * 1000 / render_format_.sample_rate_hz +
+      capture_frames * 1000 / capture_format_.sample_rate_hz;
+  return delay_ms;
+}
+
+}  // namespace webrtc
@@ -0,0 +1,163 @@
+/*
+ *  Copyright (c) 2016 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef WEBRTC_MODULES_AUDIO_PROCESSING_DUPLEX_DUPLEX_ENGINE_H_
+#define WEBRTC_MODULES_AUDIO_PROCESSING_DUPLEX_DUPLEX_ENGINE_H_
+
+#include <vector>
+
+#include "webrtc/base/constructormagic.h"
+#include "webrtc/base/event.h"
+#include "webrtc/base/platform_thread.h"
+#include "webrtc/base/scoped_ptr.h"
+#include "webrtc/modules/audio_processing/include/audio_processing.h"
+#include "webrtc/modules/audio_processing/spsc_ring_buffer.h"
+
+namespace webrtc {
+
+// Runs an AudioProcessing instance between the playback and the capture
+// stream of one full duplex audio device, without ever running it on either
+// of the audio threads.
+//
+// The playback thread hands its interleaved int16 audio to OnRender(), which
+// queues it in a lock-free ring. The capture thread hands its audio to
+// OnCapture(), which queues it in a second ring and replaces it, in place,
+// with earlier audio which has already been processed. A worker thread drains
+// both rings in 10 ms chunks: the render audio is passed to
+// ProcessReverseStream() and the capture audio to ProcessStream(), reading
+// and writing the ring memory directly. The audio threads never wait for the
+// worker, so a slow APM call can no longer overrun the device; it shows up
+// as an underrun of the processed audio instead (see Statistics).
+//
+// The audio threads copy their audio; only the worker works on the ring
+// memory in place. The device buffers belong to the caller and are reused
+// as soon as the call returns, so OnRender() copies one period into the
+// render ring, and OnCapture() copies one period into the capture ring and
+// one processed period back out. This costs two memcpy() of a period per
+// capture call and one per render call, next to the int16 to float
+// conversion of every chunk which the APM needs anyway.
+//
+// Because the capture audio is processed after OnCapture() has returned, the
+// processed capture audio lags the device by one capture period, plus one
+// chunk when the period is not a whole number of chunks. The period is the
+// one the device was opened with: a 1024 frame period at 48 kHz adds 21 ms
+// plus a 10 ms chunk, while a 480 frame (10 ms) period adds only 10 ms.
+//
+// The stream delay is measured rather than configured: both audio threads
+// report how many frames are queued in the device when they hand over their
+// audio, and the worker adds the audio still queued in the rings.
+class DuplexEngine {
+ public:
+  struct StreamFormat {
+    StreamFormat(int sample_rate_hz, size_t num_channels, size_t period_frames)
+        : sample_rate_hz(sample_rate_hz),
+          num_channels(num_channels),
+          period_frames(period_frames) {}
+
+    int sample_rate_hz;
+    size_t num_channels;
+    // Frames per device period, i.e. per OnRender() or OnCapture() call.
+    size_t period_frames;
+  };
+
+  struct Statistics {
+    Statistics()
+        : processed_frames(0),
+          render_overruns(0),
+          capture_overruns(0),
+          capture_underruns(0),
+          stream_delay_ms(0) {}
+
+    // Capture frames passed through ProcessStream().
+    size_t processed_frames;
+    // Frames dropped because the worker fell behind the playback thread.
+    size_t render_overruns;
+    // Frames dropped because the worker fell behind the capture thread.
+    size_t capture_overruns;
+    // Frames returned as silence because no processed audio was ready.
+    size_t capture_underruns;
+    // The delay passed to the last ProcessStream() call.
+    int stream_delay_ms;
+  };
+
+  // Takes ownership of |apm|, which should be configured before Start().
+  DuplexEngine(AudioProcessing* apm,
+               const StreamFormat& capture_format,
+               const StreamFormat& render_format);
+  ~DuplexEngine();
+
+  AudioProcessing* apm() { return apm_.get(); }
+  const StreamFormat& capture_format() const { return capture_format_; }
+  const StreamFormat& render_format() const { return render_format_; }
+
+  // Initializes |apm| to the stream formats and starts the worker. Returns
+  // the APM error code.
+  int Start();
+  // Stops the worker. Neither audio thread may be in the engine.
+  void Stop();
+
+  // Called by the playback thread with the |num_frames| frames it is about
+  // to write to the device, which already holds |queued_frames| frames.
+  void OnRender(const int16_t* audio, size_t num_frames, size_t queued_frames);
+
+  // Called by the capture thread with the |num_frames| frames it has read
+  // from the device, which still holds |queued_frames| frames. Replaces
+  // |audio| with processed audio.
+  void OnCapture(int16_t* audio, size_t num_frames, size_t queued_frames);
+
+  // May be called from any thread.
+  Statistics GetStatistics() const;
+
+ private:
+  static bool Run(void* obj);
+  bool Process();
+  void AnalyzeRenderChunks();
+  void ProcessCaptureChunks();
+  int StreamDelayMs(size_t render_backlog, size_t capture_backlog) const;
+
+  rtc::scoped_ptr<AudioProcessing> apm_;
+  const StreamFormat capture_format_;
+  const StreamFormat render_format_;
+  const StreamConfig capture_config_;
+  const StreamConfig render_config_;
+
+  // Rings of interleaved frames, one item per frame.
+  SpscRingBuffer<int16_t> render_queue_;
+  SpscRingBuffer<int16_t> capture_queue_;
+  SpscRingBuffer<int16_t> processed_queue_;
+
+  // Deinterleaved 10 ms chunks, only touched by the worker.
+  std::vector<float> render_chunk_;
+  std::vector<float*> render_channels_;
+  std::vector<float> capture_chunk_;
+  std::vector<float*> capture_channels_;
+  int analog_level_;
+
+  // Device queue levels, in frames, published by the audio threads.
+  volatile int render_queued_frames_;
+  volatile int capture_queued_frames_;
+
+  // Statistics, updated atomically.
+  volatile int processed_frames_;
+  volatile int render_overruns_;
+  volatile int capture_overruns_;
+  volatile int capture_underruns_;
+  volatile int stream_delay_ms_;
+
+  rtc::Event wake_event_;
+  rtc::PlatformThread thread_;
+  volatile int running_;
+
+  RTC_DISALLOW_COPY_AND_ASSIGN(DuplexEngine);
+};
+
+}  // namespace webrtc
+
+#endif  // WEBRTC_MODULES_AUDIO_PROCESSING_DUPLEX_DUPLEX_ENGINE_H_
@@ -0,0 +1,125 @@
+/*
+ *  Copyright (c) 2016 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "webrtc/modules/audio_processing/duplex/duplex_engine.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "testing/gtest/include/gtest/gtest.h"
+#include "webrtc/system_wrappers/include/sleep.h"
+
+namespace webrtc {
+namespace {
+
+const int kSampleRateHz = 48000;
+const size_t kNumChannels = 2;
+const size_t kChunkFrames = kSampleRateHz / 100;
+const int kTimeoutMs = 5000;
+
+// Waits until the worker has processed |frames| capture frames in total.
+bool WaitForProcessedFrames(const DuplexEngine& engine, size_t frames) {
+  for (int i = 0; i < kTimeoutMs; ++i) {
+    if (engine.GetStatistics().processed_frames >= frames)
+      return true;
+    SleepMs(1);
+  }
+  return false;
+}
+
+int16_t Sample(size_t index) {
+  return static_cast<int16_t>(index * 37);
+}
+
+// With no component enabled the APM passes the audio through unchanged, so
+// the output must be the input delayed by the priming of the engine.
+void RunPassThrough(size_t period_frames, size_t expected_delay_frames) {
+  const DuplexEngine::StreamFormat format(kSampleRateHz, kNumChannels,
+                                          period_frames);
+  DuplexEngine engine(AudioProcessing::Create(), format, format);
+  ASSERT_EQ(AudioProcessing::kNoError, engine.Start());
+
+  const size_t kNumPeriods = 40;
+  std::vector<int16_t> output;
+  std::vector<int16_t> period(period_frames * kNumChannels);
+  size_t next_sample = 0;
+  for (size_t p = 0; p < kNumPeriods; ++p) {
+    for (size_t i = 0; i < period.size(); ++i)
+      period[i] = Sample(next_sample++);
+    engine.OnRender(&period[0], period_frames, 0);
+    engine.OnCapture(&period[0], period_frames, 0);
+    output.insert(output.end(), period.begin(), period.end());
+    const size_t captured = (p + 1) * period_frames;
+    ASSERT_TRUE(WaitForProcessedFrames(
+        engine, captured - captured % kChunkFrames));
+  }
+
+  const DuplexEngine::Statistics stats = engine.GetStatistics();
+  EXPECT_EQ(0u, stats.render_overruns);
+  EXPECT_EQ(0u, stats.capture_overruns);
+  EXPECT_EQ(0u, stats.capture_underruns);
+
+  const size_t delay = expected_delay_frames * kNumChannels;
+  for (size_t i = 0; i < delay; ++i)
+    ASSERT_EQ(0, output[i]) << "at sample " << i;
+  for (size_t i = delay; i < output.size(); ++i)
+    ASSERT_EQ(Sample(i - delay), output[i]) << "at sample " << i;
+}
+
+TEST(DuplexEngineTest, PassesThroughWithWholeChunkPeriods) {
+  RunPassThrough(2 * kChunkFrames, 2 * kChunkFrames);
+}
+
+TEST(DuplexEngineTest, PassesThroughWithPartialChunkPeriods) {
+  RunPassThrough(1024, 1024 + kChunkFrames);
+}
+
+TEST(DuplexEngineTest, MeasuresStreamDelay) {
+  const DuplexEngine::StreamFormat format(kSampleRateHz, kNumChannels,
+                                          kChunkFrames);
+  AudioProcessing* apm = AudioProcessing::Create();
+  apm->echo_cancellation()->Enable(true);
+  DuplexEngine engine(apm, format, format);
+  ASSERT_EQ(AudioProcessing::kNoError, engine.Start());
+
+  std::vector<int16_t> period(kChunkFrames * kNumChannels, 0);
+  // 20 ms queued for playback, and 5 ms still in the capture device after
+  // reading a 10 ms chunk.
+  engine.OnRender(&period[0], kChunkFrames, 2 * kChunkFrames);
+  engine.OnCapture(&period[0], kChunkFrames, kChunkFrames / 2);
+  ASSERT_TRUE(WaitForProcessedFrames(engine, kChunkFrames));
+  EXPECT_EQ(35, engine.GetStatistics().stream_delay_ms);
+}
+
+// Without a running worker the audio threads must still return at once,
+// dropping the input and returning silence.
+TEST(DuplexEngineTest, DoesNotBlockOnStalledWorker) {
+  const DuplexEngine::StreamFormat format(kSampleRateHz, kNumChannels,
+                                          kChunkFrames);
+  DuplexEngine engine(AudioProcessing::Create(), format, format);
+
+  std::vector<int16_t> period(kChunkFrames * kNumChannels, 1000);
+  for (int i = 0; i < 10; ++i) {
+    engine.OnRender(&period[0], kChunkFrames, 0);
+    engine.OnCapture(&period[0], kChunkFrames, 0);
+    for (size_t j = 0; j < period.size(); ++j)
+      ASSERT_EQ(0, period[j]);
+    std::fill(period.begin(), period.end(), 1000);
+  }
+
+  const DuplexEngine::Statistics stats = engine.GetStatistics();
+  EXPECT_GT(stats.render_overruns, 0u);
+  EXPECT_GT(stats.capture_overruns, 0u);
+  EXPECT_EQ(10 * kChunkFrames, stats.capture_underruns);
+  EXPECT_EQ(0u, stats.processed_frames);
+}
+
+}  // namespace
+}  // namespace webrtc
@@ -18,6 +18,7 @@ extern "C" {
 }
 #include "webrtc/modules/audio_processing/aec/echo_cancellation.h"
 #include "webrtc/modules/audio_processing/audio_buffer.h"
+#include "webrtc/modules/audio_processing/render_queue.h"
 
 namespace webrtc {
 
@@ -52,13 +53,6 @@ AudioProcessing::Error MapError(int err) {
       return AudioProcessing::kUnspecifiedError;
   }
 }
-
-// Maximum length that a frame of samples can have.
-static const size_t kMaxAllowedValuesOfSamplesPerFrame = 160;
-// Maximum number of frames to buffer in the render queue.
-// TODO(peah): Decrease this once we properly handle hugely unbalanced
-// reverse and forward call numbers.
-static const size_t kMaxNumFramesToBuffer = 100;
 }  // namespace
 
 EchoCancellationImpl::EchoCancellationImpl(const AudioProcessing* apm,
@@ -76,8 +70,7 @@ EchoCancellationImpl::EchoCancellationImpl(const AudioProcessing* apm,
       stream_has_echo_(false),
       delay_logging_enabled_(false),
       extended_filter_enabled_(false),
-      delay_agnostic_enabled_(false),
-      render_queue_element_max_size_(0) {
+      delay_agnostic_enabled_(false) {
   RTC_DCHECK(apm);
   RTC_DCHECK(crit_render);
   RTC_DCHECK(crit_capture);
@@ -85,7 +78,8 @@ EchoCancellationImpl::EchoCancellationImpl(const AudioProcessing* apm,
 
 EchoCancellationImpl::~EchoCancellationImpl() {}
 
-int EchoCancellationImpl::ProcessRenderAudio(const AudioBuffer* audio) {
+int EchoCancellationImpl::ProcessRenderAudio(const AudioBuffer* audio,
+                                             RenderQueueItem* item) {
   rtc::CritScope cs_render(crit_render_);
   if (!is_component_enabled()) {
     return AudioProcessing::kNoError;
@@ -98,7 +92,6 @@ int EchoCancellationImpl::ProcessRenderAudio(const AudioBuffer* audio) {
 
   // The ordering convention must be followed to pass to the correct AEC.
   size_t handle_index = 0;
-  render_queue_buffer_.clear();
   for (int i = 0; i < apm_->num_output_channels(); i++) {
     for (int j = 0; j < audio->num_channels(); j++) {
       Handle* my_handle = static_cast<Handle*>(handle(handle_index));
@@ -111,50 +104,38 @@ int EchoCancellationImpl::ProcessRenderAudio(const AudioBuffer* audio) {
       if (err != AudioProcessing::kNoError) {
         return MapError(err);  // TODO(ajm): warning possible?
       }
-
-      // Buffer the samples in the render queue.
-      render_queue_buffer_.insert(render_queue_buffer_.end(),
-                                  audio->split_bands_const_f(j)[kBand0To8kHz],
-                                  (audio->split_bands_const_f(j)[kBand0To8kHz] +
-                                   audio->num_frames_per_band()));
     }
   }
 
-  // Insert the samples into the queue.
-  if (!render_signal_queue_->Insert(&render_queue_buffer_)) {
-    // The data queue is full and needs to be emptied.
-    ReadQueuedRenderData();
-
-    // Retry the insert (should always work).
-    RTC_DCHECK_EQ(render_signal_queue_->Insert(&render_queue_buffer_), true);
+  // All the AECs of a reverse channel share its samples, which are copied
+  // only once.
+  if (item) {
+    for (int j = 0; j < audio->num_channels(); j++) {
+      memcpy(item->band0_f(j), audio->split_bands_const_f(j)[kBand0To8kHz],
+             audio->num_frames_per_band() * sizeof(float));
+    }
+    item->add_content(RenderQueueItem::kBand0Float);
   }
 
   return AudioProcessing::kNoError;
 }
 
-// Read chunks of data that were received and queued on the render side from
-// a queue. All the data chunks are buffered into the farend signal of the AEC.
-void EchoCancellationImpl::ReadQueuedRenderData() {
+// Buffers a frame of data that was received and queued on the render side
+// into the farend signal of the AECs.
+void EchoCancellationImpl::BufferRenderData(const RenderQueueItem& item) {
   rtc::CritScope cs_capture(crit_capture_);
-  if (!is_component_enabled()) {
+  if (!is_component_enabled() ||
+      !item.has_content(RenderQueueItem::kBand0Float)) {
     return;
   }
 
-  while (render_signal_queue_->Remove(&capture_queue_buffer_)) {
-    size_t handle_index = 0;
-    int buffer_index = 0;
-    const int num_frames_per_band =
-        capture_queue_buffer_.size() /
-        (apm_->num_output_channels() * apm_->num_reverse_channels());
-    for (int i = 0; i < apm_->num_output_channels(); i++) {
-      for (int j = 0; j < apm_->num_reverse_channels(); j++) {
-        Handle* my_handle = static_cast<Handle*>(handle(handle_index));
-        WebRtcAec_BufferFarend(my_handle, &capture_queue_buffer_[buffer_index],
-                               num_frames_per_band);
-
-        buffer_index += num_frames_per_band;
-        handle_index++;
-      }
+  size_t handle_index = 0;
+  for (int i = 0; i < apm_->num_output_channels(); i++) {
+    for (int j = 0; j < apm_->num_reverse_channels(); j++) {
+      Handle* my_handle = static_cast<Handle*>(handle(handle_index));
+      WebRtcAec_BufferFarend(my_handle, item.band0_f(j),
+                             item.num_frames_per_band());
+      handle_index++;
     }
   }
 }
@@ -402,44 +383,7 @@ struct AecCore* EchoCancellationImpl::aec_core() const {
 }
 
 int EchoCancellationImpl::Initialize() {
-  int err = ProcessingComponent::Initialize();
-  {
-    rtc::CritScope cs(crit_capture_);
-    if (err != AudioProcessing::kNoError || !is_component_enabled()) {
-      return err;
-    }
-  }
-
-  AllocateRenderQueue();
-
-  return AudioProcessing::kNoError;
-}
-
-void EchoCancellationImpl::AllocateRenderQueue() {
-  const size_t new_render_queue_element_max_size = std::max<size_t>(
-      static_cast<size_t>(1),
-      kMaxAllowedValuesOfSamplesPerFrame * num_handles_required());
-
-  rtc::CritScope cs_render(crit_render_);
-  rtc::CritScope cs_capture(crit_capture_);
-
-  // Reallocate the queue if the queue item size is too small to fit the
-  // data to put in the queue.
-  if (render_queue_element_max_size_ < new_render_queue_element_max_size) {
-    render_queue_element_max_size_ = new_render_queue_element_max_size;
-
-    std::vector<float> template_queue_element(render_queue_element_max_size_);
-
-    render_signal_queue_.reset(
-        new SwapQueue<std::vector<float>, RenderQueueItemVerifier<float>>(
-            kMaxNumFramesToBuffer, template_queue_element,
-            RenderQueueItemVerifier<float>(render_queue_element_max_size_)));
-
-    render_queue_buffer_.resize(render_queue_element_max_size_);
-    capture_queue_buffer_.resize(render_queue_element_max_size_);
-  } else {
-    render_signal_queue_->Clear();
-  }
+  return ProcessingComponent::Initialize();
 }
 
 void EchoCancellationImpl::SetExtraOptions(const Config& config) {
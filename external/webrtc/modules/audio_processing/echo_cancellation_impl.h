@@ -13,13 +13,13 @@
 
 #include "webrtc/base/criticalsection.h"
 #include "webrtc/base/scoped_ptr.h"
-#include "webrtc/common_audio/swap_queue.h"
 #include "webrtc/modules/audio_processing/include/audio_processing.h"
 #include "webrtc/modules/audio_processing/processing_component.h"
 
 namespace webrtc {
 
 class AudioBuffer;
+class RenderQueueItem;
 
 class EchoCancellationImpl : public EchoCancellation,
                              public ProcessingComponent {
@@ -29,7 +29,9 @@ class EchoCancellationImpl : public EchoCancellation,
                        rtc::CriticalSection* crit_capture);
   virtual ~EchoCancellationImpl();
 
-  int ProcessRenderAudio(const AudioBuffer* audio);
+  // Checks the render |audio| and, unless |item| is NULL, copies the part
+  // used by the AEC into it.
+  int ProcessRenderAudio(const AudioBuffer* audio, RenderQueueItem* item);
   int ProcessCaptureAudio(AudioBuffer* audio);
 
   // EchoCancellation implementation.
@@ -44,9 +46,9 @@ class EchoCancellationImpl : public EchoCancellation,
   bool is_delay_agnostic_enabled() const;
   bool is_extended_filter_enabled() const;
 
-  // Reads render side data that has been queued on the render call.
+  // Buffers the render data of a frame queued on the render call.
   // Called holding the capture lock.
-  void ReadQueuedRenderData();
+  void BufferRenderData(const RenderQueueItem& item);
 
  private:
   // EchoCancellation implementation.
@@ -75,8 +77,6 @@ class EchoCancellationImpl : public EchoCancellation,
   int num_handles_required() const override;
   int GetHandleError(void* handle) const override;
 
-  void AllocateRenderQueue();
-
   // Not guarded as its public API is thread safe.
   const AudioProcessing* apm_;
 
@@ -92,15 +92,6 @@ class EchoCancellationImpl : public EchoCancellation,
   bool delay_logging_enabled_ GUARDED_BY(crit_capture_);
   bool extended_filter_enabled_ GUARDED_BY(crit_capture_);
   bool delay_agnostic_enabled_ GUARDED_BY(crit_capture_);
-
-  size_t render_queue_element_max_size_ GUARDED_BY(crit_render_)
-      GUARDED_BY(crit_capture_);
-  std::vector<float> render_queue_buffer_ GUARDED_BY(crit_render_);
-  std::vector<float> capture_queue_buffer_ GUARDED_BY(crit_capture_);
-
-  // Lock protection not needed.
-  rtc::scoped_ptr<SwapQueue<std::vector<float>, RenderQueueItemVerifier<float>>>
-      render_signal_queue_;
 };
 
 }  // namespace webrtc
@@ -15,6 +15,7 @@
 
 #include "webrtc/modules/audio_processing/aecm/echo_control_mobile.h"
 #include "webrtc/modules/audio_processing/audio_buffer.h"
+#include "webrtc/modules/audio_processing/render_queue.h"
 #include "webrtc/system_wrappers/include/logging.h"
 
 namespace webrtc {
@@ -55,12 +56,6 @@ AudioProcessing::Error MapError(int err) {
       return AudioProcessing::kUnspecifiedError;
   }
 }
-// Maximum length that a frame of samples can have.
-static const size_t kMaxAllowedValuesOfSamplesPerFrame = 160;
-// Maximum number of frames to buffer in the render queue.
-// TODO(peah): Decrease this once we properly handle hugely unbalanced
-// reverse and forward call numbers.
-static const size_t kMaxNumFramesToBuffer = 100;
 }  // namespace
 
 size_t EchoControlMobile::echo_path_size_bytes() {
@@ -76,8 +71,7 @@ EchoControlMobileImpl::EchoControlMobileImpl(const AudioProcessing* apm,
       crit_capture_(crit_capture),
       routing_mode_(kSpeakerphone),
       comfort_noise_enabled_(true),
-      external_echo_path_(NULL),
-      render_queue_element_max_size_(0) {
+      external_echo_path_(NULL) {
   RTC_DCHECK(apm);
   RTC_DCHECK(crit_render);
   RTC_DCHECK(crit_capture);
@@ -90,7 +84,8 @@ EchoControlMobileImpl::~EchoControlMobileImpl() {
     }
 }
 
-int EchoControlMobileImpl::ProcessRenderAudio(const AudioBuffer* audio) {
+int EchoControlMobileImpl::ProcessRenderAudio(const AudioBuffer* audio,
+                                              RenderQueueItem* item) {
   rtc::CritScope cs_render(crit_render_);
 
   if (!is_component_enabled()) {
@@ -103,7 +98,6 @@ int EchoControlMobileImpl::ProcessRenderAudio(const AudioBuffer* audio) {
   int err = AudioProcessing::kNoError;
   // The ordering convention must be followed to pass to the correct AECM.
   size_t handle_index = 0;
-  render_queue_buffer_.clear();
   for (int i = 0; i < apm_->num_output_channels(); i++) {
     for (int j = 0; j < audio->num_channels(); j++) {
       Handle* my_handle = static_cast<Handle*>(handle(handle_index));
@@ -114,52 +108,40 @@ int EchoControlMobileImpl::ProcessRenderAudio(const AudioBuffer* audio) {
       if (err != AudioProcessing::kNoError)
         return MapError(err);  // TODO(ajm): warning possible?);
 
-      // Buffer the samples in the render queue.
-      render_queue_buffer_.insert(render_queue_buffer_.end(),
-                                  audio->split_bands_const(j)[kBand0To8kHz],
-                                  (audio->split_bands_const(j)[kBand0To8kHz] +
-                                   audio->num_frames_per_band()));
-
       handle_index++;
     }
   }
 
-  // Insert the samples into the queue.
-  if (!render_signal_queue_->Insert(&render_queue_buffer_)) {
-    // The data queue is full and needs to be emptied.
-    ReadQueuedRenderData();
-
-    // Retry the insert (should always work).
-    RTC_DCHECK_EQ(render_signal_queue_->Insert(&render_queue_buffer_), true);
+  // All the AECMs of a reverse channel share its samples, which are copied
+  // only once.
+  if (item) {
+    for (int j = 0; j < audio->num_channels(); j++) {
+      memcpy(item->band0(j), audio->split_bands_const(j)[kBand0To8kHz],
+             audio->num_frames_per_band() * sizeof(int16_t));
+    }
+    item->add_content(RenderQueueItem::kBand0Int16);
   }
 
   return AudioProcessing::kNoError;
 }
 
-// Read chunks of data that were received and queued on the render side from
-// a queue. All the data chunks are buffered into the farend signal of the AEC.
-void EchoControlMobileImpl::ReadQueuedRenderData() {
+// Buffers a frame of data that was received and queued on the render side
+// into the farend signal of the AECMs.
+void EchoControlMobileImpl::BufferRenderData(const RenderQueueItem& item) {
   rtc::CritScope cs_capture(crit_capture_);
 
-  if (!is_component_enabled()) {
+  if (!is_component_enabled() ||
+      !item.has_content(RenderQueueItem::kBand0Int16)) {
     return;
   }
 
-  while (render_signal_queue_->Remove(&capture_queue_buffer_)) {
-    size_t handle_index = 0;
-    int buffer_index = 0;
-    const int num_frames_per_band =
-        capture_queue_buffer_.size() /
-        (apm_->num_output_channels() * apm_->num_reverse_channels());
-    for (int i = 0; i < apm_->num_output_channels(); i++) {
-      for (int j = 0; j < apm_->num_reverse_channels(); j++) {
-        Handle* my_handle = static_cast<Handle*>(handle(handle_index));
-        WebRtcAecm_BufferFarend(my_handle, &capture_queue_buffer_[buffer_index],
-                                num_frames_per_band);
-
-        buffer_index += num_frames_per_band;
-        handle_index++;
-      }
+  size_t handle_index = 0;
+  for (int i = 0; i < apm_->num_output_channels(); i++) {
+    for (int j = 0; j < apm_->num_reverse_channels(); j++) {
+      Handle* my_handle = static_cast<Handle*>(handle(handle_index));
+      WebRtcAecm_BufferFarend(my_handle, item.band0(j),
+                              item.num_frames_per_band());
+      handle_index++;
     }
   }
 }
@@ -318,41 +300,7 @@ int EchoControlMobileImpl::Initialize() {
     return AudioProcessing::kBadSampleRateError;
   }
 
-  int err = ProcessingComponent::Initialize();
-  if (err != AudioProcessing::kNoError) {
-    return err;
-  }
-
-  AllocateRenderQueue();
-
-  return AudioProcessing::kNoError;
-}
-
-void EchoControlMobileImpl::AllocateRenderQueue() {
-  const size_t new_render_queue_element_max_size = std::max<size_t>(
-      static_cast<size_t>(1),
-      kMaxAllowedValuesOfSamplesPerFrame * num_handles_required());
-
-  rtc::CritScope cs_render(crit_render_);
-  rtc::CritScope cs_capture(crit_capture_);
-
-  // Reallocate the queue if the queue item size is too small to fit the
-  // data to put in the queue.
-  if (render_queue_element_max_size_ < new_render_queue_element_max_size) {
-    render_queue_element_max_size_ = new_render_queue_element_max_size;
-
-    std::vector<int16_t> template_queue_element(render_queue_element_max_size_);
-
-    render_signal_queue_.reset(
-        new SwapQueue<std::vector<int16_t>, RenderQueueItemVerifier<int16_t>>(
-            kMaxNumFramesToBuffer, template_queue_element,
-            RenderQueueItemVerifier<int16_t>(render_queue_element_max_size_)));
-
-    render_queue_buffer_.resize(render_queue_element_max_size_);
-    capture_queue_buffer_.resize(render_queue_element_max_size_);
-  } else {
-    render_signal_queue_->Clear();
-  }
+  return ProcessingComponent::Initialize();
 }
 
 void* EchoControlMobileImpl::CreateHandle() const {
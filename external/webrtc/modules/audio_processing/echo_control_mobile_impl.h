@@ -13,13 +13,13 @@
 
 #include "webrtc/base/criticalsection.h"
 #include "webrtc/base/scoped_ptr.h"
-#include "webrtc/common_audio/swap_queue.h"
 #include "webrtc/modules/audio_processing/include/audio_processing.h"
 #include "webrtc/modules/audio_processing/processing_component.h"
 
 namespace webrtc {
 
 class AudioBuffer;
+class RenderQueueItem;
 
 class EchoControlMobileImpl : public EchoControlMobile,
                               public ProcessingComponent {
@@ -30,7 +30,9 @@ class EchoControlMobileImpl : public EchoControlMobile,
 
   virtual ~EchoControlMobileImpl();
 
-  int ProcessRenderAudio(const AudioBuffer* audio);
+  // Checks the render |audio| and, unless |item| is NULL, copies the part
+  // used by the AECM into it.
+  int ProcessRenderAudio(const AudioBuffer* audio, RenderQueueItem* item);
   int ProcessCaptureAudio(AudioBuffer* audio);
 
   // EchoControlMobile implementation.
@@ -41,8 +43,8 @@ class EchoControlMobileImpl : public EchoControlMobile,
   // ProcessingComponent implementation.
   int Initialize() override;
 
-  // Reads render side data that has been queued on the render call.
-  void ReadQueuedRenderData();
+  // Buffers the render data of a frame queued on the render call.
+  void BufferRenderData(const RenderQueueItem& item);
 
  private:
   // EchoControlMobile implementation.
@@ -61,8 +63,6 @@ class EchoControlMobileImpl : public EchoControlMobile,
   int num_handles_required() const override;
   int GetHandleError(void* handle) const override;
 
-  void AllocateRenderQueue();
-
   // Not guarded as its public API is thread safe.
   const AudioProcessing* apm_;
 
@@ -73,17 +73,6 @@ class EchoControlMobileImpl : public EchoControlMobile,
   bool comfort_noise_enabled_ GUARDED_BY(crit_capture_);
   unsigned char* external_echo_path_ GUARDED_BY(crit_render_)
       GUARDED_BY(crit_capture_);
-
-  size_t render_queue_element_max_size_ GUARDED_BY(crit_render_)
-      GUARDED_BY(crit_capture_);
-
-  std::vector<int16_t> render_queue_buffer_ GUARDED_BY(crit_render_);
-  std::vector<int16_t> capture_queue_buffer_ GUARDED_BY(crit_capture_);
-
-  // Lock protection not needed.
-  rtc::scoped_ptr<
-      SwapQueue<std::vector<int16_t>, RenderQueueItemVerifier<int16_t>>>
-      render_signal_queue_;
 };
 }  // namespace webrtc
 
@@ -11,9 +11,11 @@
 #include "webrtc/modules/audio_processing/gain_control_impl.h"
 
 #include <assert.h>
+#include <string.h>
 
 #include "webrtc/modules/audio_processing/audio_buffer.h"
 #include "webrtc/modules/audio_processing/agc/legacy/gain_control.h"
+#include "webrtc/modules/audio_processing/render_queue.h"
 
 namespace webrtc {
 
@@ -33,13 +35,6 @@ int16_t MapSetting(GainControl::Mode mode) {
   return -1;
 }
 
-// Maximum length that a frame of samples can have.
-static const size_t kMaxAllowedValuesOfSamplesPerFrame = 160;
-// Maximum number of frames to buffer in the render queue.
-// TODO(peah): Decrease this once we properly handle hugely unbalanced
-// reverse and forward call numbers.
-static const size_t kMaxNumFramesToBuffer = 100;
-
 }  // namespace
 
 GainControlImpl::GainControlImpl(const AudioProcessing* apm,
@@ -57,8 +52,7 @@ GainControlImpl::GainControlImpl(const AudioProcessing* apm,
       compression_gain_db_(9),
       analog_capture_level_(0),
       was_analog_level_set_(false),
-      stream_is_saturated_(false),
-      render_queue_element_max_size_(0) {
+      stream_is_saturated_(false) {
   RTC_DCHECK(apm);
   RTC_DCHECK(crit_render);
   RTC_DCHECK(crit_capture);
@@ -66,7 +60,8 @@ GainControlImpl::GainControlImpl(const AudioProcessing* apm,
 
 GainControlImpl::~GainControlImpl() {}
 
-int GainControlImpl::ProcessRenderAudio(AudioBuffer* audio) {
+int GainControlImpl::ProcessRenderAudio(AudioBuffer* audio,
+                                        RenderQueueItem* item) {
   rtc::CritScope cs(crit_render_);
   if (!is_component_enabled()) {
     return AudioProcessing::kNoError;
@@ -74,7 +69,6 @@ int GainControlImpl::ProcessRenderAudio(AudioBuffer* audio) {
 
   assert(audio->num_frames_per_band() <= 160);
 
-  render_queue_buffer_.resize(0);
   for (int i = 0; i < num_handles(); i++) {
     Handle* my_handle = static_cast<Handle*>(handle(i));
     int err =
@@ -82,45 +76,32 @@ int GainControlImpl::ProcessRenderAudio(AudioBuffer* audio) {
 
     if (err != AudioProcessing::kNoError)
       return GetHandleError(my_handle);
-
-    // Buffer the samples in the render queue.
-    render_queue_buffer_.insert(
-        render_queue_buffer_.end(), audio->mixed_low_pass_data(),
-        (audio->mixed_low_pass_data() + audio->num_frames_per_band()));
   }
 
-  // Insert the samples into the queue.
-  if (!render_signal_queue_->Insert(&render_queue_buffer_)) {
-    // The data queue is full and needs to be emptied.
-    ReadQueuedRenderData();
-
-    // Retry the insert (should always work).
-    RTC_DCHECK_EQ(render_signal_queue_->Insert(&render_queue_buffer_), true);
+  // All the AGCs share the mixed samples, which are copied only once.
+  if (item) {
+    memcpy(item->mixed_low_pass_data(), audio->mixed_low_pass_data(),
+           audio->num_frames_per_band() * sizeof(int16_t));
+    item->add_content(RenderQueueItem::kMixedLowPass);
   }
 
   return AudioProcessing::kNoError;
 }
 
-// Read chunks of data that were received and queued on the render side from
-// a queue. All the data chunks are buffered into the farend signal of the AGC.
-void GainControlImpl::ReadQueuedRenderData() {
+// Buffers a frame of data that was received and queued on the render side
+// into the farend signal of the AGCs.
+void GainControlImpl::BufferRenderData(const RenderQueueItem& item) {
   rtc::CritScope cs(crit_capture_);
 
-  if (!is_component_enabled()) {
+  if (!is_component_enabled() ||
+      !item.has_content(RenderQueueItem::kMixedLowPass)) {
     return;
   }
 
-  while (render_signal_queue_->Remove(&capture_queue_buffer_)) {
-    int buffer_index = 0;
-    const int num_frames_per_band =
-        capture_queue_buffer_.size() / num_handles();
-    for (int i = 0; i < num_handles(); i++) {
-      Handle* my_handle = static_cast<Handle*>(handle(i));
-      WebRtcAgc_AddFarend(my_handle, &capture_queue_buffer_[buffer_index],
-                          num_frames_per_band);
-
-      buffer_index += num_frames_per_band;
-    }
+  for (int i = 0; i < num_handles(); i++) {
+    Handle* my_handle = static_cast<Handle*>(handle(i));
+    WebRtcAgc_AddFarend(my_handle, item.mixed_low_pass_data(),
+                        item.num_frames_per_band());
   }
 }
 
@@ -364,8 +345,6 @@ int GainControlImpl::Initialize() {
     return err;
   }
 
-  AllocateRenderQueue();
-
   rtc::CritScope cs_capture(crit_capture_);
   const int n = num_handles();
   RTC_CHECK_GE(n, 0) << "Bad number of handles: " << n;
@@ -374,30 +353,6 @@ int GainControlImpl::Initialize() {
   return AudioProcessing::kNoError;
 }
 
-void GainControlImpl::AllocateRenderQueue() {
-  const size_t new_render_queue_element_max_size =
-      std::max<size_t>(static_cast<size_t>(1),
-                       kMaxAllowedValuesOfSamplesPerFrame * num_handles());
-
-  rtc::CritScope cs_render(crit_render_);
-  rtc::CritScope cs_capture(crit_capture_);
-
-  if (render_queue_element_max_size_ < new_render_queue_element_max_size) {
-    render_queue_element_max_size_ = new_render_queue_element_max_size;
-    std::vector<int16_t> template_queue_element(render_queue_element_max_size_);
-
-    render_signal_queue_.reset(
-        new SwapQueue<std::vector<int16_t>, RenderQueueItemVerifier<int16_t>>(
-            kMaxNumFramesToBuffer, template_queue_element,
-            RenderQueueItemVerifier<int16_t>(render_queue_element_max_size_)));
-
-    render_queue_buffer_.resize(render_queue_element_max_size_);
-    capture_queue_buffer_.resize(render_queue_element_max_size_);
-  } else {
-    render_signal_queue_->Clear();
-  }
-}
-
 void* GainControlImpl::CreateHandle() const {
   return WebRtcAgc_Create();
 }
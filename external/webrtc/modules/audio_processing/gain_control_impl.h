@@ -16,13 +16,13 @@
 #include "webrtc/base/criticalsection.h"
 #include "webrtc/base/scoped_ptr.h"
 #include "webrtc/base/thread_annotations.h"
-#include "webrtc/common_audio/swap_queue.h"
 #include "webrtc/modules/audio_processing/include/audio_processing.h"
 #include "webrtc/modules/audio_processing/processing_component.h"
 
 namespace webrtc {
 
 class AudioBuffer;
+class RenderQueueItem;
 
 class GainControlImpl : public GainControl,
                         public ProcessingComponent {
@@ -32,7 +32,9 @@ class GainControlImpl : public GainControl,
                   rtc::CriticalSection* crit_capture);
   virtual ~GainControlImpl();
 
-  int ProcessRenderAudio(AudioBuffer* audio);
+  // Checks the render |audio| and, unless |item| is NULL, copies the part
+  // used by the AGC into it.
+  int ProcessRenderAudio(AudioBuffer* audio, RenderQueueItem* item);
   int AnalyzeCaptureAudio(AudioBuffer* audio);
   int ProcessCaptureAudio(AudioBuffer* audio);
 
@@ -45,8 +47,8 @@ class GainControlImpl : public GainControl,
   bool is_limiter_enabled() const override;
   Mode mode() const override;
 
-  // Reads render side data that has been queued on the render call.
-  void ReadQueuedRenderData();
+  // Buffers the render data of a frame queued on the render call.
+  void BufferRenderData(const RenderQueueItem& item);
 
  private:
   // GainControl implementation.
@@ -71,8 +73,6 @@ class GainControlImpl : public GainControl,
   int num_handles_required() const override;
   int GetHandleError(void* handle) const override;
 
-  void AllocateRenderQueue();
-
   // Not guarded as its public API is thread safe.
   const AudioProcessing* apm_;
 
@@ -89,16 +89,6 @@ class GainControlImpl : public GainControl,
   int analog_capture_level_ GUARDED_BY(crit_capture_);
   bool was_analog_level_set_ GUARDED_BY(crit_capture_);
   bool stream_is_saturated_ GUARDED_BY(crit_capture_);
-
-  size_t render_queue_element_max_size_ GUARDED_BY(crit_render_)
-      GUARDED_BY(crit_capture_);
-  std::vector<int16_t> render_queue_buffer_ GUARDED_BY(crit_render_);
-  std::vector<int16_t> capture_queue_buffer_ GUARDED_BY(crit_capture_);
-
-  // Lock protection not needed.
-  rtc::scoped_ptr<
-      SwapQueue<std::vector<int16_t>, RenderQueueItemVerifier<int16_t>>>
-      render_signal_queue_;
 };
 }  // namespace webrtc
 
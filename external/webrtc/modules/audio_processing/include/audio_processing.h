@@ -115,7 +115,8 @@ struct Beamforming {
       : enabled(false),
         array_geometry(),
         target_direction(
-            SphericalPointf(static_cast<float>(M_PI) / 2.f, 0.f, 1.f)) {}
+            SphericalPointf(static_cast<float>(M_PI) / 2.f, 0.f, 1.f)),
+        fft_size(kDefaultBeamformerFftSize) {}
   Beamforming(bool enabled, const std::vector<Point>& array_geometry)
       : Beamforming(enabled,
                     array_geometry,
@@ -124,12 +125,25 @@ struct Beamforming {
   Beamforming(bool enabled,
               const std::vector<Point>& array_geometry,
               SphericalPointf target_direction)
+      : Beamforming(enabled,
+                    array_geometry,
+                    target_direction,
+                    kDefaultBeamformerFftSize) {}
+  // |fft_size| trades latency against frequency resolution. It has to be a
+  // power of two in [128, 1024], otherwise AudioProcessing fails to initialize
+  // with kBadParameterError.
+  Beamforming(bool enabled,
+              const std::vector<Point>& array_geometry,
+              SphericalPointf target_direction,
+              size_t fft_size)
       : enabled(enabled),
         array_geometry(array_geometry),
-        target_direction(target_direction) {}
+        target_direction(target_direction),
+        fft_size(fft_size) {}
   const bool enabled;
   const std::vector<Point> array_geometry;
   const SphericalPointf target_direction;
+  const size_t fft_size;
 };
 
 // Use to enable intelligibility enhancer in audio processing. Must be provided
@@ -25,11 +25,12 @@ extern const int16_t WebRtcNsx_kLogTable[9];
 extern const int16_t WebRtcNsx_kCounterDiv[201];
 extern const int16_t WebRtcNsx_kLogTableFrac[256];
 #else
-static const int16_t WebRtcNsx_kLogTable[9] = {
+/* Tables are also used by the x86 SSE4.1 code in nsx_core_sse41.c. */
+const int16_t WebRtcNsx_kLogTable[9] = {
   0, 177, 355, 532, 710, 887, 1065, 1242, 1420
 };
 
-static const int16_t WebRtcNsx_kCounterDiv[201] = {
+const int16_t WebRtcNsx_kCounterDiv[201] = {
   32767, 16384, 10923, 8192, 6554, 5461, 4681, 4096, 3641, 3277, 2979, 2731,
   2521, 2341, 2185, 2048, 1928, 1820, 1725, 1638, 1560, 1489, 1425, 1365, 1311,
   1260, 1214, 1170, 1130, 1092, 1057, 1024, 993, 964, 936, 910, 886, 862, 840,
@@ -46,7 +47,7 @@ static const int16_t WebRtcNsx_kCounterDiv[201] = {
   172, 172, 171, 170, 169, 168, 167, 166, 165, 165, 164, 163
 };
 
-static const int16_t WebRtcNsx_kLogTableFrac[256] = {
+const int16_t WebRtcNsx_kLogTableFrac[256] = {
   0,   1,   3,   4,   6,   7,   9,  10,  11,  13,  14,  16,  17,  18,  20,  21,
   22,  24,  25,  26,  28,  29,  30,  32,  33,  34,  36,  37,  38,  40,  41,  42,
   44,  45,  46,  47,  49,  50,  51,  52,  54,  55,  56,  57,  59,  60,  61,  62,
@@ -557,6 +558,15 @@ AnalysisUpdate WebRtcNsx_AnalysisUpdate;
 Denormalize WebRtcNsx_Denormalize;
 NormalizeRealBuffer WebRtcNsx_NormalizeRealBuffer;
 
+void WebRtcNsx_InitC(void) {
+  WebRtcNsx_NoiseEstimation = NoiseEstimationC;
+  WebRtcNsx_PrepareSpectrum = PrepareSpectrumC;
+  WebRtcNsx_SynthesisUpdate = SynthesisUpdateC;
+  WebRtcNsx_AnalysisUpdate = AnalysisUpdateC;
+  WebRtcNsx_Denormalize = DenormalizeC;
+  WebRtcNsx_NormalizeRealBuffer = NormalizeRealBufferC;
+}
+
 #if (defined WEBRTC_DETECT_NEON || defined WEBRTC_HAS_NEON)
 // Initialize function pointers for ARM Neon platform.
 static void WebRtcNsx_InitNeon(void) {
@@ -567,6 +577,17 @@ static void WebRtcNsx_InitNeon(void) {
 }
 #endif
 
+#if defined(WEBRTC_ARCH_X86_FAMILY)
+// Initialize function pointers for x86 platforms with SSE4.1.
+static void WebRtcNsx_InitSSE41(void) {
+  WebRtcNsx_NoiseEstimation = WebRtcNsx_NoiseEstimationSSE41;
+  WebRtcNsx_PrepareSpectrum = WebRtcNsx_PrepareSpectrumSSE41;
+  WebRtcNsx_SynthesisUpdate = WebRtcNsx_SynthesisUpdateSSE41;
+  WebRtcNsx_AnalysisUpdate = WebRtcNsx_AnalysisUpdateSSE41;
+  WebRtcNsx_Denormalize = WebRtcNsx_DenormalizeSSE41;
+}
+#endif
+
 #if defined(MIPS32_LE)
 // Initialize function pointers for MIPS platform.
 static void WebRtcNsx_InitMips(void) {
@@ -755,12 +776,13 @@ int32_t WebRtcNsx_InitCore(NoiseSuppressionFixedC* inst, uint32_t fs) {
 #endif
 
   // Initialize function pointers.
-  WebRtcNsx_NoiseEstimation = NoiseEstimationC;
-  WebRtcNsx_PrepareSpectrum = PrepareSpectrumC;
-  WebRtcNsx_SynthesisUpdate = SynthesisUpdateC;
-  WebRtcNsx_AnalysisUpdate = AnalysisUpdateC;
-  WebRtcNsx_Denormalize = DenormalizeC;
-  WebRtcNsx_NormalizeRealBuffer = NormalizeRealBufferC;
+  WebRtcNsx_InitC();
+
+#if defined(WEBRTC_ARCH_X86_FAMILY)
+  if (WebRtc_GetCPUInfo(kSSE4_1)) {
+    WebRtcNsx_InitSSE41();
+  }
+#endif
 
 #ifdef WEBRTC_DETECT_NEON
   uint64_t features = WebRtc_GetCPUFeaturesARM();
@@ -208,6 +208,11 @@ typedef void (*NormalizeRealBuffer)(NoiseSuppressionFixedC* inst,
                                     int16_t* out);
 extern NormalizeRealBuffer WebRtcNsx_NormalizeRealBuffer;
 
+// Points the function pointers above to the generic C versions.
+// WebRtcNsx_InitCore() does this before it selects the platform specific
+// versions, and tests use it to get the reference implementation.
+void WebRtcNsx_InitC(void);
+
 // Compute speech/noise probability.
 // Intended to be private.
 void WebRtcNsx_SpeechNoiseProb(NoiseSuppressionFixedC* inst,
@@ -233,6 +238,27 @@ void WebRtcNsx_PrepareSpectrumNeon(NoiseSuppressionFixedC* inst,
                                    int16_t* freq_buff);
 #endif
 
+#if defined(WEBRTC_ARCH_X86_FAMILY)
+// For the above function pointers, functions for generic platforms are declared
+// and defined as static in file nsx_core.c, while those for x86 platforms with
+// SSE4.1 are declared below and defined in file nsx_core_sse41.c.
+void WebRtcNsx_NoiseEstimationSSE41(NoiseSuppressionFixedC* inst,
+                                    uint16_t* magn,
+                                    uint32_t* noise,
+                                    int16_t* q_noise);
+void WebRtcNsx_PrepareSpectrumSSE41(NoiseSuppressionFixedC* inst,
+                                    int16_t* freq_buff);
+void WebRtcNsx_SynthesisUpdateSSE41(NoiseSuppressionFixedC* inst,
+                                    int16_t* out_frame,
+                                    int16_t gain_factor);
+void WebRtcNsx_AnalysisUpdateSSE41(NoiseSuppressionFixedC* inst,
+                                   int16_t* out,
+                                   int16_t* new_speech);
+void WebRtcNsx_DenormalizeSSE41(NoiseSuppressionFixedC* inst,
+                                int16_t* in,
+                                int factor);
+#endif
+
 #if defined(MIPS32_LE)
 // For the above function pointers, functions for generic platforms are declared
 // and defined as static in file nsx_core.c, while those for MIPS platforms
@@ -0,0 +1,432 @@
+/*
+ *  Copyright (c) 2016 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+// The functions in this file are bit-exact with the generic C versions in
+// nsx_core.c.
+
+#include "webrtc/modules/audio_processing/ns/nsx_core.h"
+
+#include <assert.h>
+#include <smmintrin.h>
+#include <string.h>
+
+// Tables are defined in nsx_core.c.
+extern const int16_t WebRtcNsx_kLogTable[9];
+extern const int16_t WebRtcNsx_kCounterDiv[201];
+extern const int16_t WebRtcNsx_kLogTableFrac[256];
+
+// Multiplies the eight 16-bit values in |a| and |b| into 32-bit products.
+static __inline void Mul16x16(__m128i a,
+                              __m128i b,
+                              __m128i* lo,
+                              __m128i* hi) {
+  const __m128i prod_lo = _mm_mullo_epi16(a, b);
+  const __m128i prod_hi = _mm_mulhi_epi16(a, b);
+  *lo = _mm_unpacklo_epi16(prod_lo, prod_hi);
+  *hi = _mm_unpackhi_epi16(prod_lo, prod_hi);
+}
+
+// Packs the 32-bit values in |lo| and |hi| into 16 bits by truncation, as an
+// (int16_t) cast does in C. _mm_packs_epi32() would saturate instead.
+static __inline __m128i PackTruncate(__m128i lo, __m128i hi) {
+  const __m128i zero = _mm_setzero_si128();
+  return _mm_packus_epi32(_mm_blend_epi16(lo, zero, 0xAA),
+                          _mm_blend_epi16(hi, zero, 0xAA));
+}
+
+// (int16_t)((a * b + 8192) >> 14) for eight 16-bit values, i.e.
+// WEBRTC_SPL_MUL_16_16_RSFT_WITH_ROUND(a, b, 14) truncated to 16 bits.
+static __inline __m128i MulRoundQ14(__m128i a, __m128i b) {
+  const __m128i round = _mm_set1_epi32(1 << 13);
+  __m128i lo, hi;
+  Mul16x16(a, b, &lo, &hi);
+  lo = _mm_srai_epi32(_mm_add_epi32(lo, round), 14);
+  hi = _mm_srai_epi32(_mm_add_epi32(hi, round), 14);
+  return PackTruncate(lo, hi);
+}
+
+// (int16_t)((a * b) >> 14) for eight 16-bit values.
+static __inline __m128i MulQ14(__m128i a, __m128i b) {
+  __m128i lo, hi;
+  Mul16x16(a, b, &lo, &hi);
+  return PackTruncate(_mm_srai_epi32(lo, 14), _mm_srai_epi32(hi, 14));
+}
+
+// FACTOR_Q16 >> (14 - WebRtcSpl_NormW16(density)), the step size of the
+// quantile estimate for bins with a density above 512. Such a density has at
+// most five leading zero bits, and each of them doubles the step size.
+static __inline __m128i DenseDelta(__m128i density) {
+  __m128i delta = _mm_set1_epi16(FACTOR_Q16 >> 14);
+  int threshold;
+  for (threshold = 1 << 14; threshold >= 1 << 10; threshold >>= 1) {
+    const __m128i below =
+        _mm_cmpgt_epi16(_mm_set1_epi16((int16_t)threshold), density);
+    delta = _mm_add_epi16(delta, _mm_and_si128(delta, below));
+  }
+  return delta;
+}
+
+// Update the noise estimation information. The per-bin shift can go either
+// way and is applied on 32 bits, so this is kept scalar.
+static void UpdateNoiseEstimate(NoiseSuppressionFixedC* inst, size_t offset) {
+  int32_t tmp32no1 = 0;
+  int32_t tmp32no2 = 0;
+  int16_t tmp16 = 0;
+  const int16_t kExp2Const = 11819; // Q13
+
+  size_t i = 0;
+
+  tmp16 = WebRtcSpl_MaxValueW16(inst->noiseEstLogQuantile + offset,
+                                inst->magnLen);
+  // Guarantee a Q-domain as high as possible and still fit in int16
+  inst->qNoise = 14 - (int) WEBRTC_SPL_MUL_16_16_RSFT_WITH_ROUND(
+                   kExp2Const, tmp16, 21);
+  for (i = 0; i < inst->magnLen; i++) {
+    // inst->quantile[i]=exp(inst->lquantile[offset+i]);
+    // in Q21
+    tmp32no2 = kExp2Const * inst->noiseEstLogQuantile[offset + i];
+    tmp32no1 = (0x00200000 | (tmp32no2 & 0x001FFFFF)); // 2^21 + frac
+    tmp16 = (int16_t)(tmp32no2 >> 21);
+    tmp16 -= 21;// shift 21 to get result in Q0
+    tmp16 += (int16_t) inst->qNoise; //shift to get result in Q(qNoise)
+    if (tmp16 < 0) {
+      tmp32no1 >>= -tmp16;
+    } else {
+      tmp32no1 <<= tmp16;
+    }
+    inst->noiseEstQuantile[i] = WebRtcSpl_SatW32ToW16(tmp32no1);
+  }
+}
+
+// Noise Estimation
+void WebRtcNsx_NoiseEstimationSSE41(NoiseSuppressionFixedC* inst,
+                                    uint16_t* magn,
+                                    uint32_t* noise,
+                                    int16_t* q_noise) {
+  int16_t lmagn[HALF_ANAL_BLOCKL], counter, countDiv;
+  int16_t countProd, delta, zeros, frac;
+  int16_t log2, tabind, logval, tmp16, tmp16no1, tmp16no2;
+  const int16_t log2_const = 22713; // Q15
+  const int16_t width_factor = 21845;
+
+  size_t i, s, offset;
+
+  tabind = inst->stages - inst->normData;
+  assert(tabind < 9);
+  assert(tabind > -9);
+  if (tabind < 0) {
+    logval = -WebRtcNsx_kLogTable[-tabind];
+  } else {
+    logval = WebRtcNsx_kLogTable[tabind];
+  }
+
+  // lmagn(i)=log(magn(i))=log(2)*log2(magn(i))
+  // magn is in Q(-stages), and the real lmagn values are:
+  // real_lmagn(i)=log(magn(i)*2^stages)=log(magn(i))+log(2^stages)
+  // lmagn in Q8
+  for (i = 0; i < inst->magnLen; i++) {
+    if (magn[i]) {
+      zeros = WebRtcSpl_NormU32((uint32_t)magn[i]);
+      frac = (int16_t)((((uint32_t)magn[i] << zeros)
+                        & 0x7FFFFFFF) >> 23);
+      assert(frac < 256);
+      // log2(magn(i))
+      log2 = (int16_t)(((31 - zeros) << 8)
+                       + WebRtcNsx_kLogTableFrac[frac]);
+      // log2(magn(i))*log(2)
+      lmagn[i] = (int16_t)((log2 * log2_const) >> 15);
+      // + log(2^stages)
+      lmagn[i] += logval;
+    } else {
+      lmagn[i] = logval;
+    }
+  }
+
+  const __m128i logval_16x8 = _mm_set1_epi16(logval);
+  const __m128i width_16x8 = _mm_set1_epi16(WIDTH_Q8);
+  const __m128i one_16x8 = _mm_set1_epi16(1);
+  const __m128i two_16x8 = _mm_set1_epi16(2);
+  const __m128i density_min_16x8 = _mm_set1_epi16(512);
+
+  int16_t factor = FACTOR_Q7;
+  if (inst->blockIndex < END_STARTUP_LONG) {
+    // Smaller step size during startup. This prevents from using
+    // unrealistic values causing overflow.
+    factor = FACTOR_Q7_STARTUP;
+  }
+  const __m128i factor_16x8 = _mm_set1_epi16(factor);
+
+  // loop over simultaneous estimates
+  for (s = 0; s < SIMULT; s++) {
+    offset = s * inst->magnLen;
+
+    // Get counter values from state
+    counter = inst->noiseEstCounter[s];
+    assert(counter < 201);
+    countDiv = WebRtcNsx_kCounterDiv[counter];
+    countProd = (int16_t)(counter * countDiv);
+    tmp16no2 = (int16_t)WEBRTC_SPL_MUL_16_16_RSFT_WITH_ROUND(
+                 width_factor, countDiv, 15);
+
+    const __m128i countDiv_16x8 = _mm_set1_epi16(countDiv);
+    const __m128i countProd_16x8 = _mm_set1_epi16(countProd);
+    const __m128i density_inc_16x8 = _mm_set1_epi16(tmp16no2);
+
+    // quant_est(...)
+    for (i = 0; i + 7 < inst->magnLen; i += 8) {
+      __m128i* log_quantile_p =
+          (__m128i*)&inst->noiseEstLogQuantile[offset + i];
+      __m128i* density_p = (__m128i*)&inst->noiseEstDensity[offset + i];
+      const __m128i lmagn_16x8 = _mm_loadu_si128((const __m128i*)&lmagn[i]);
+      const __m128i log_quantile = _mm_loadu_si128(log_quantile_p);
+      const __m128i density = _mm_loadu_si128(density_p);
+
+      // Compute delta.
+      const __m128i delta_16x8 =
+          _mm_blendv_epi8(factor_16x8, DenseDelta(density),
+                          _mm_cmpgt_epi16(density, density_min_16x8));
+
+      // tmp16 = (int16_t)((delta * countDiv) >> 14), which is non-negative
+      // and at most 10239. The divisions below are therefore plain shifts.
+      const __m128i step = MulQ14(delta_16x8, countDiv_16x8);
+
+      // Upwards: log_quantile += (tmp16 + 2) / 4.
+      const __m128i up = _mm_add_epi16(
+          log_quantile, _mm_srai_epi16(_mm_add_epi16(step, two_16x8), 2));
+
+      // Downwards: log_quantile -= ((tmp16 + 1) / 2) * 3 / 2, where
+      // (3 * h) / 2 == h + h / 2 keeps the intermediate within 16 bits.
+      const __m128i half = _mm_srai_epi16(_mm_add_epi16(step, one_16x8), 1);
+      __m128i down = _mm_sub_epi16(
+          log_quantile, _mm_add_epi16(half, _mm_srai_epi16(half, 1)));
+      // logval is the smallest fixed point representation we can have.
+      down = _mm_max_epi16(down, logval_16x8);
+
+      const __m128i new_log_quantile = _mm_blendv_epi8(
+          down, up, _mm_cmpgt_epi16(lmagn_16x8, log_quantile));
+      _mm_storeu_si128(log_quantile_p, new_log_quantile);
+
+      // Update density estimate where
+      // |lmagn[i] - noiseEstLogQuantile[offset + i]| < WIDTH_Q8. The
+      // saturating differences keep the comparison exact.
+      const __m128i inside = _mm_and_si128(
+          _mm_cmpgt_epi16(width_16x8,
+                          _mm_subs_epi16(lmagn_16x8, new_log_quantile)),
+          _mm_cmpgt_epi16(width_16x8,
+                          _mm_subs_epi16(new_log_quantile, lmagn_16x8)));
+      // _mm_mulhrs_epi16() is WEBRTC_SPL_MUL_16_16_RSFT_WITH_ROUND(a, b, 15).
+      const __m128i new_density = _mm_add_epi16(
+          _mm_mulhrs_epi16(density, countProd_16x8), density_inc_16x8);
+      _mm_storeu_si128(density_p,
+                       _mm_blendv_epi8(density, new_density, inside));
+    }  // end loop over magnitude spectrum
+
+    // Remaining bins.
+    for (; i < inst->magnLen; i++) {
+      // compute delta
+      if (inst->noiseEstDensity[offset + i] > 512) {
+        // Get the value for delta by shifting intead of dividing.
+        int factor = WebRtcSpl_NormW16(inst->noiseEstDensity[offset + i]);
+        delta = (int16_t)(FACTOR_Q16 >> (14 - factor));
+      } else {
+        delta = FACTOR_Q7;
+        if (inst->blockIndex < END_STARTUP_LONG) {
+          // Smaller step size during startup. This prevents from using
+          // unrealistic values causing overflow.
+          delta = FACTOR_Q7_STARTUP;
+        }
+      }
+
+      // update log quantile estimate
+      tmp16 = (int16_t)((delta * countDiv) >> 14);
+      if (lmagn[i] > inst->noiseEstLogQuantile[offset + i]) {
+        // +=QUANTILE*delta/(inst->counter[s]+1) QUANTILE=0.25, =1 in Q2
+        // CounterDiv=1/(inst->counter[s]+1) in Q15
+        tmp16 += 2;
+        inst->noiseEstLogQuantile[offset + i] += tmp16 / 4;
+      } else {
+        tmp16 += 1;
+        // *(1-QUANTILE), in Q2 QUANTILE=0.25, 1-0.25=0.75=3 in Q2
+        tmp16no1 = (int16_t)((tmp16 / 2) * 3 / 2);
+        inst->noiseEstLogQuantile[offset + i] -= tmp16no1;
+        if (inst->noiseEstLogQuantile[offset + i] < logval) {
+          // This is the smallest fixed point representation we can
+          // have, hence we limit the output.
+          inst->noiseEstLogQuantile[offset + i] = logval;
+        }
+      }
+
+      // update density estimate
+      if (WEBRTC_SPL_ABS_W16(lmagn[i] - inst->noiseEstLogQuantile[offset + i])
+          < WIDTH_Q8) {
+        tmp16no1 = (int16_t)WEBRTC_SPL_MUL_16_16_RSFT_WITH_ROUND(
+                     inst->noiseEstDensity[offset + i], countProd, 15);
+        inst->noiseEstDensity[offset + i] = tmp16no1 + tmp16no2;
+      }
+    }
+
+    if (counter >= END_STARTUP_LONG) {
+      inst->noiseEstCounter[s] = 0;
+      if (inst->blockIndex >= END_STARTUP_LONG) {
+        UpdateNoiseEstimate(inst, offset);
+      }
+    }
+    inst->noiseEstCounter[s]++;
+
+  }  // end loop over simultaneous estimates
+
+  // Sequentially update the noise during startup
+  if (inst->blockIndex < END_STARTUP_LONG) {
+    UpdateNoiseEstimate(inst, offset);
+  }
+
+  for (i = 0; i + 7 < inst->magnLen; i += 8) {
+    const __m128i quantile =
+        _mm_loadu_si128((const __m128i*)&inst->noiseEstQuantile[i]);
+    _mm_storeu_si128((__m128i*)&noise[i], _mm_cvtepi16_epi32(quantile));
+    _mm_storeu_si128((__m128i*)&noise[i + 4],
+                     _mm_cvtepi16_epi32(_mm_srli_si128(quantile, 8)));
+  }
+  for (; i < inst->magnLen; i++) {
+    noise[i] = (uint32_t)(inst->noiseEstQuantile[i]); // Q(qNoise)
+  }
+  (*q_noise) = (int16_t)inst->qNoise;
+}
+
+// Filter the data in the frequency domain, and create spectrum.
+void WebRtcNsx_PrepareSpectrumSSE41(NoiseSuppressionFixedC* inst,
+                                    int16_t* freq_buf) {
+  const __m128i zero = _mm_setzero_si128();
+  size_t i;
+
+  assert(inst->magnLen == inst->anaLen2 + 1);
+  assert(inst->anaLen2 % 8 == 0);
+
+  // The filtering and the creation of the spectrum are done in one pass:
+  // for (i = 0; i < inst->magnLen; i++) {
+  //   inst->real[i] = (int16_t)((inst->real[i] *
+  //      (int16_t)(inst->noiseSupFilter[i])) >> 14);  // Q(normData-stages)
+  //   inst->imag[i] = (int16_t)((inst->imag[i] *
+  //      (int16_t)(inst->noiseSupFilter[i])) >> 14);  // Q(normData-stages)
+  //   freq_buf[2 * i] = inst->real[i];
+  //   freq_buf[2 * i + 1] = -inst->imag[i];
+  // }
+  for (i = 0; i < inst->anaLen2; i += 8) {
+    const __m128i ns_filter =
+        _mm_loadu_si128((const __m128i*)&inst->noiseSupFilter[i]);
+    const __m128i real = MulQ14(
+        _mm_loadu_si128((const __m128i*)&inst->real[i]), ns_filter);
+    const __m128i imag = MulQ14(
+        _mm_loadu_si128((const __m128i*)&inst->imag[i]), ns_filter);
+    const __m128i neg_imag = _mm_sub_epi16(zero, imag);
+    _mm_storeu_si128((__m128i*)&inst->real[i], real);
+    _mm_storeu_si128((__m128i*)&inst->imag[i], imag);
+    _mm_storeu_si128((__m128i*)&freq_buf[2 * i],
+                     _mm_unpacklo_epi16(real, neg_imag));
+    _mm_storeu_si128((__m128i*)&freq_buf[2 * i + 8],
+                     _mm_unpackhi_epi16(real, neg_imag));
+  }
+
+  // Filter the last element
+  inst->real[i] = (int16_t)((inst->real[i] *
+      (int16_t)(inst->noiseSupFilter[i])) >> 14);
+  inst->imag[i] = (int16_t)((inst->imag[i] *
+      (int16_t)(inst->noiseSupFilter[i])) >> 14);
+  freq_buf[inst->anaLen] = inst->real[inst->anaLen2];
+  freq_buf[inst->anaLen + 1] = -inst->imag[inst->anaLen2];
+}
+
+// Denormalize the real-valued signal |in|, the output from inverse FFT.
+void WebRtcNsx_DenormalizeSSE41(NoiseSuppressionFixedC* inst,
+                                int16_t* in,
+                                int factor) {
+  const int shift = factor - inst->normData;
+  const __m128i count = _mm_cvtsi32_si128(shift >= 0 ? shift : -shift);
+  size_t i;
+
+  assert(inst->anaLen % 8 == 0);
+
+  for (i = 0; i < inst->anaLen; i += 8) {
+    const __m128i in_16x8 = _mm_loadu_si128((const __m128i*)&in[i]);
+    __m128i lo = _mm_cvtepi16_epi32(in_16x8);
+    __m128i hi = _mm_cvtepi16_epi32(_mm_srli_si128(in_16x8, 8));
+    if (shift >= 0) {
+      lo = _mm_sll_epi32(lo, count);
+      hi = _mm_sll_epi32(hi, count);
+    } else {
+      lo = _mm_sra_epi32(lo, count);
+      hi = _mm_sra_epi32(hi, count);
+    }
+    // Saturate to Q0.
+    _mm_storeu_si128((__m128i*)&inst->real[i], _mm_packs_epi32(lo, hi));
+  }
+}
+
+// For the noise supression process, synthesis, read out fully processed
+// segment, and update synthesis buffer.
+void WebRtcNsx_SynthesisUpdateSSE41(NoiseSuppressionFixedC* inst,
+                                    int16_t* out_frame,
+                                    int16_t gain_factor) {
+  const __m128i gain = _mm_set1_epi16(gain_factor);
+  const __m128i round = _mm_set1_epi32(1 << 12);
+  size_t i;
+
+  assert(inst->anaLen % 8 == 0);
+
+  // synthesis
+  for (i = 0; i < inst->anaLen; i += 8) {
+    // Q0, window in Q14
+    const __m128i windowed = MulRoundQ14(
+        _mm_loadu_si128((const __m128i*)&inst->window[i]),
+        _mm_loadu_si128((const __m128i*)&inst->real[i]));
+    __m128i lo, hi;
+    Mul16x16(windowed, gain, &lo, &hi);
+    // Down shift with rounding and saturate to Q0.
+    lo = _mm_srai_epi32(_mm_add_epi32(lo, round), 13);
+    hi = _mm_srai_epi32(_mm_add_epi32(hi, round), 13);
+    __m128i* synthesis_p = (__m128i*)&inst->synthesisBuffer[i];
+    _mm_storeu_si128(synthesis_p,
+                     _mm_adds_epi16(_mm_loadu_si128(synthesis_p),
+                                    _mm_packs_epi32(lo, hi)));
+  }
+
+  // read out fully processed segment
+  memcpy(out_frame, inst->synthesisBuffer,
+         inst->blockLen10ms * sizeof(*inst->synthesisBuffer));
+
+  // update synthesis buffer
+  memmove(inst->synthesisBuffer, inst->synthesisBuffer + inst->blockLen10ms,
+          (inst->anaLen - inst->blockLen10ms) * sizeof(*inst->synthesisBuffer));
+  memset(inst->synthesisBuffer + inst->anaLen - inst->blockLen10ms, 0,
+         inst->blockLen10ms * sizeof(*inst->synthesisBuffer));
+}
+
+// Update analysis buffer for lower band, and window data before FFT.
+void WebRtcNsx_AnalysisUpdateSSE41(NoiseSuppressionFixedC* inst,
+                                   int16_t* out,
+                                   int16_t* new_speech) {
+  size_t i;
+
+  assert(inst->anaLen % 8 == 0);
+
+  // For lower band update analysis buffer.
+  memmove(inst->analysisBuffer, inst->analysisBuffer + inst->blockLen10ms,
+          (inst->anaLen - inst->blockLen10ms) * sizeof(*inst->analysisBuffer));
+  memcpy(inst->analysisBuffer + inst->anaLen - inst->blockLen10ms, new_speech,
+         inst->blockLen10ms * sizeof(*inst->analysisBuffer));
+
+  // Window data before FFT.
+  for (i = 0; i < inst->anaLen; i += 8) {
+    _mm_storeu_si128(
+        (__m128i*)&out[i],
+        MulRoundQ14(_mm_loadu_si128((const __m128i*)&inst->window[i]),
+                    _mm_loadu_si128((const __m128i*)&inst->analysisBuffer[i])));
+  }
+}
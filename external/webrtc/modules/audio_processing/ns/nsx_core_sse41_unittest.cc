@@ -0,0 +1,222 @@
+/*
+ *  Copyright (c) 2016 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "testing/gtest/include/gtest/gtest.h"
+extern "C" {
+#include "webrtc/modules/audio_processing/ns/noise_suppression_x.h"
+#include "webrtc/modules/audio_processing/ns/nsx_core.h"
+#include "webrtc/modules/audio_processing/ns/nsx_defines.h"
+}
+#include "webrtc/system_wrappers/include/cpu_features_wrapper.h"
+
+namespace webrtc {
+namespace {
+
+const int kNumFrames = 600;  // Well past the END_STARTUP_LONG blocks.
+
+// The tests pass without running anything on CPUs without SSE4.1, so say so.
+bool HasSse41() {
+  if (WebRtc_GetCPUInfo(kSSE4_1))
+    return true;
+  printf("Skipping test: the CPU does not support SSE4.1.\n");
+  return false;
+}
+
+void InitSSE41() {
+  WebRtcNsx_NoiseEstimation = WebRtcNsx_NoiseEstimationSSE41;
+  WebRtcNsx_PrepareSpectrum = WebRtcNsx_PrepareSpectrumSSE41;
+  WebRtcNsx_SynthesisUpdate = WebRtcNsx_SynthesisUpdateSSE41;
+  WebRtcNsx_AnalysisUpdate = WebRtcNsx_AnalysisUpdateSSE41;
+  WebRtcNsx_Denormalize = WebRtcNsx_DenormalizeSSE41;
+}
+
+int16_t RandomInt16() {
+  return static_cast<int16_t>(rand() & 0xFFFF);
+}
+
+void FillRandom(int16_t* data, size_t length) {
+  for (size_t i = 0; i < length; ++i) {
+    data[i] = RandomInt16();
+  }
+}
+
+void ExpectEqual(const int16_t* expected,
+                 const int16_t* actual,
+                 size_t length) {
+  for (size_t i = 0; i < length; ++i) {
+    ASSERT_EQ(expected[i], actual[i]) << "at index " << i;
+  }
+}
+
+// Tone plus noise whose level changes every 100 frames, so that the noise
+// estimate moves both up and down.
+void GenerateFrame(int frame, size_t length, int16_t* data) {
+  const float level = (frame / 100) % 2 ? 3000.f : 300.f;
+  for (size_t i = 0; i < length; ++i) {
+    const float tone =
+        2000.f * sinf(0.05f * static_cast<float>(frame * length + i));
+    const float noise =
+        level * (static_cast<float>(rand()) / RAND_MAX - 0.5f);
+    data[i] = static_cast<int16_t>(tone + noise);
+  }
+}
+
+class NsxSse41Test : public ::testing::TestWithParam<uint32_t> {
+ protected:
+  void SetUp() override {
+    srand(42);
+    c_ = WebRtcNsx_Create();
+    sse41_ = WebRtcNsx_Create();
+    ASSERT_EQ(0, WebRtcNsx_Init(c_, GetParam()));
+    ASSERT_EQ(0, WebRtcNsx_Init(sse41_, GetParam()));
+  }
+
+  void TearDown() override {
+    WebRtcNsx_Free(c_);
+    WebRtcNsx_Free(sse41_);
+  }
+
+  NoiseSuppressionFixedC* c_inst() {
+    return reinterpret_cast<NoiseSuppressionFixedC*>(c_);
+  }
+
+  NoiseSuppressionFixedC* sse41_inst() {
+    return reinterpret_cast<NoiseSuppressionFixedC*>(sse41_);
+  }
+
+  // Copies the state of the C instance, but keeps the FFT of the SSE4.1 one.
+  void CopyState() {
+    struct RealFFT* real_fft = sse41_inst()->real_fft;
+    *sse41_inst() = *c_inst();
+    sse41_inst()->real_fft = real_fft;
+  }
+
+  NsxHandle* c_;
+  NsxHandle* sse41_;
+};
+
+TEST_P(NsxSse41Test, ProcessIsBitExact) {
+  if (!HasSse41())
+    return;
+  const size_t frame_length = c_inst()->blockLen10ms;
+  int16_t in[ANAL_BLOCKL_MAX];
+  int16_t c_out[ANAL_BLOCKL_MAX];
+  int16_t sse41_out[ANAL_BLOCKL_MAX];
+  const int16_t* in_bands[1] = {in};
+  int16_t* c_out_bands[1] = {c_out};
+  int16_t* sse41_out_bands[1] = {sse41_out};
+
+  for (int frame = 0; frame < kNumFrames; ++frame) {
+    GenerateFrame(frame, frame_length, in);
+    WebRtcNsx_InitC();
+    WebRtcNsx_Process(c_, in_bands, 1, c_out_bands);
+    InitSSE41();
+    WebRtcNsx_Process(sse41_, in_bands, 1, sse41_out_bands);
+    ASSERT_NO_FATAL_FAILURE(ExpectEqual(c_out, sse41_out, frame_length))
+        << "in frame " << frame;
+  }
+  ExpectEqual(c_inst()->noiseEstLogQuantile,
+              sse41_inst()->noiseEstLogQuantile, SIMULT * HALF_ANAL_BLOCKL);
+  ExpectEqual(c_inst()->noiseEstDensity, sse41_inst()->noiseEstDensity,
+              SIMULT * HALF_ANAL_BLOCKL);
+}
+
+// Runs the kernels on full range random data, which reaches the wrap-around
+// and saturation cases that real audio rarely does.
+TEST_P(NsxSse41Test, KernelsAreBitExactForFullRangeInput) {
+  if (!HasSse41())
+    return;
+  NoiseSuppressionFixedC* c = c_inst();
+  NoiseSuppressionFixedC* sse41 = sse41_inst();
+
+  for (int trial = 0; trial < 50; ++trial) {
+    // PrepareSpectrum.
+    FillRandom(c->real, ANAL_BLOCKL_MAX);
+    FillRandom(c->imag, ANAL_BLOCKL_MAX);
+    FillRandom(reinterpret_cast<int16_t*>(c->noiseSupFilter),
+               HALF_ANAL_BLOCKL);
+    CopyState();
+    int16_t c_freq[ANAL_BLOCKL_MAX + 2];
+    int16_t sse41_freq[ANAL_BLOCKL_MAX + 2];
+    WebRtcNsx_InitC();
+    WebRtcNsx_PrepareSpectrum(c, c_freq);
+    WebRtcNsx_PrepareSpectrumSSE41(sse41, sse41_freq);
+    ASSERT_NO_FATAL_FAILURE(ExpectEqual(c_freq, sse41_freq, c->anaLen + 2));
+    ASSERT_NO_FATAL_FAILURE(ExpectEqual(c->real, sse41->real, c->magnLen));
+    ASSERT_NO_FATAL_FAILURE(ExpectEqual(c->imag, sse41->imag, c->magnLen));
+
+    // Denormalize, shifting both ways.
+    int16_t in[ANAL_BLOCKL_MAX];
+    FillRandom(in, ANAL_BLOCKL_MAX);
+    const int factor = c->normData + trial % 20 - 10;
+    WebRtcNsx_Denormalize(c, in, factor);
+    WebRtcNsx_DenormalizeSSE41(sse41, in, factor);
+    ASSERT_NO_FATAL_FAILURE(ExpectEqual(c->real, sse41->real, c->anaLen));
+
+    // SynthesisUpdate.
+    FillRandom(c->synthesisBuffer, ANAL_BLOCKL_MAX);
+    CopyState();
+    int16_t c_out[ANAL_BLOCKL_MAX];
+    int16_t sse41_out[ANAL_BLOCKL_MAX];
+    const int16_t gain = RandomInt16();
+    WebRtcNsx_SynthesisUpdate(c, c_out, gain);
+    WebRtcNsx_SynthesisUpdateSSE41(sse41, sse41_out, gain);
+    ASSERT_NO_FATAL_FAILURE(ExpectEqual(c_out, sse41_out, c->blockLen10ms));
+    ASSERT_NO_FATAL_FAILURE(ExpectEqual(c->synthesisBuffer,
+                                        sse41->synthesisBuffer, c->anaLen));
+
+    // AnalysisUpdate.
+    int16_t speech[ANAL_BLOCKL_MAX];
+    FillRandom(speech, ANAL_BLOCKL_MAX);
+    WebRtcNsx_AnalysisUpdate(c, c_out, speech);
+    WebRtcNsx_AnalysisUpdateSSE41(sse41, sse41_out, speech);
+    ASSERT_NO_FATAL_FAILURE(ExpectEqual(c_out, sse41_out, c->anaLen));
+    ASSERT_NO_FATAL_FAILURE(ExpectEqual(c->analysisBuffer,
+                                        sse41->analysisBuffer, c->anaLen));
+
+    // NoiseEstimation, both during and after startup.
+    uint16_t magn[HALF_ANAL_BLOCKL];
+    FillRandom(reinterpret_cast<int16_t*>(magn), HALF_ANAL_BLOCKL);
+    for (size_t i = 0; i < SIMULT * HALF_ANAL_BLOCKL; ++i) {
+      c->noiseEstLogQuantile[i] = static_cast<int16_t>(rand() % 4096);
+      c->noiseEstDensity[i] = RandomInt16();
+    }
+    c->blockIndex = trial % 2 ? 0 : END_STARTUP_LONG;
+    CopyState();
+    uint32_t c_noise[HALF_ANAL_BLOCKL];
+    uint32_t sse41_noise[HALF_ANAL_BLOCKL];
+    int16_t c_q_noise = 0;
+    int16_t sse41_q_noise = 0;
+    WebRtcNsx_NoiseEstimation(c, magn, c_noise, &c_q_noise);
+    WebRtcNsx_NoiseEstimationSSE41(sse41, magn, sse41_noise, &sse41_q_noise);
+    EXPECT_EQ(c_q_noise, sse41_q_noise);
+    for (size_t i = 0; i < c->magnLen; ++i) {
+      ASSERT_EQ(c_noise[i], sse41_noise[i]) << "at index " << i;
+    }
+    ASSERT_NO_FATAL_FAILURE(ExpectEqual(c->noiseEstLogQuantile,
+                                        sse41->noiseEstLogQuantile,
+                                        SIMULT * HALF_ANAL_BLOCKL));
+    ASSERT_NO_FATAL_FAILURE(ExpectEqual(c->noiseEstDensity,
+                                        sse41->noiseEstDensity,
+                                        SIMULT * HALF_ANAL_BLOCKL));
+  }
+}
+
+INSTANTIATE_TEST_CASE_P(SampleRates,
+                        NsxSse41Test,
+                        ::testing::Values(8000u, 16000u));
+
+}  // namespace
+}  // namespace webrtc
@@ -28,11 +28,15 @@
 
 #define LOG_TAG "goc.pcm"
 
-#include "webrtc/modules/audio_processing/include/audio_processing.h"
-#include "tinyalsa/include/tinyalsa/asoundlib.h"
-#include "webrtc/modules/include/module_common_types.h"
-#include "webrtc/common_audio/include/audio_util.h"
 #include <android/log.h>
+#include <cutils/properties.h>
+#include <stdio.h>
+
+#include "tinyalsa/include/tinyalsa/asoundlib.h"
+#include "webrtc/base/atomicops.h"
+#include "webrtc/base/criticalsection.h"
+#include "webrtc/modules/audio_processing/duplex/duplex_engine.h"
+#include "webrtc/modules/audio_processing/include/audio_processing.h"
 
 #define ALOGV(...) __android_log_print(ANDROID_LOG_VERBOSE, LOG_TAG, __VA_ARGS__)
 #define ALOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
@@ -41,13 +45,8 @@
 #define ALOGW(...) __android_log_print(ANDROID_LOG_WARN, LOG_TAG, __VA_ARGS__)
 
 using namespace webrtc;
+
 extern "C" {
-/************************************************************************************/
-static AudioProcessing* apm = NULL;
-static volatile bool is_read = false, is_write = false;
-static struct pcm *capture = NULL, *playback = NULL, *pcm1 = NULL;
-static int analog_level = 0;
-extern int pcm_link(struct pcm *,struct pcm*);
 extern long pcm_get_delay(struct pcm *);
 extern struct pcm *L_pcm_open_req(unsigned int card, unsigned int device,
                      unsigned int flags, struct pcm_config *config, int requested_rate);
@@ -55,84 +54,238 @@ extern struct pcm *L_pcm_open(unsigned int card, unsigned int device,
                      unsigned int flags, struct pcm_config *config);
 extern int L_pcm_close(struct pcm *pcm);
 extern int L_pcm_read(struct pcm *pcm, void *data, unsigned int count);
-extern int L_pcm_read_ex(struct pcm *pcm, void *data, unsigned int count);
 extern int L_pcm_write(struct pcm *pcm, const void *data, unsigned int count);
+}
+
+namespace {
+
+/*
+ * The playback and the capture stream of one card/device pair. A
+ * DuplexEngine runs between them while both are open.
+ *
+ * Devices are created by open and never freed, so the audio threads can
+ * look them up without a lock. Each audio thread holds its own lock while it
+ * is in the engine; the locks are only contended by open and close, which
+ * take both of them to create or destroy the engine.
+ */
+struct DuplexDevice {
+    DuplexDevice(unsigned card, unsigned device)
+        : card(card), device(device), capture(NULL), playback(NULL),
+          capture_channels(0), mirror_left(true), engine(NULL) {}
+
+    const unsigned card;
+    const unsigned device;
+    struct pcm *volatile capture;
+    struct pcm *volatile playback;
+    struct pcm_config capture_config;
+    struct pcm_config playback_config;
+    /* Channels of the capture audio handed to the caller. */
+    unsigned capture_channels;
+    /* Copy the left capture channel into the right one, see mirror_left(). */
+    bool mirror_left;
+    rtc::CriticalSection capture_lock;
+    rtc::CriticalSection playback_lock;
+    DuplexEngine *engine;
+};
+
+const int kMaxDevices = 8;
+
+/* Serializes open and close. */
+rtc::GlobalLockPod g_devices_lock;
+DuplexDevice *volatile g_devices[kMaxDevices];
+
+DuplexDevice *find_device(struct pcm *pcm, bool capture)
+{
+    for (int i = 0; i < kMaxDevices; i++) {
+        DuplexDevice *d = rtc::AtomicOps::AtomicLoadPtr(&g_devices[i]);
+        if (d == NULL)
+            break;
+        if (rtc::AtomicOps::AtomicLoadPtr(capture ? &d->capture : &d->playback) == pcm)
+            return d;
+    }
+    return NULL;
+}
+
+size_t queued_frames(struct pcm *pcm)
+{
+    long delay = pcm_get_delay(pcm);
+    return delay > 0 ? delay : 0;
+}
+
+void store_pcm(struct pcm *volatile *slot, struct pcm *pcm)
+{
+    rtc::AtomicOps::CompareAndSwapPtr(slot, rtc::AtomicOps::AtomicLoadPtr(slot), pcm);
+}
+
+/* Must be called with |g_devices_lock| held. */
+DuplexDevice *get_device(unsigned card, unsigned device)
+{
+    for (int i = 0; i < kMaxDevices; i++) {
+        DuplexDevice *d = g_devices[i];
+        if (d == NULL) {
+            d = new DuplexDevice(card, device);
+            rtc::AtomicOps::CompareAndSwapPtr(&g_devices[i], (DuplexDevice *)NULL, d);
+            return d;
+        }
+        if (d->card == card && d->device == device)
+            return d;
+    }
+    return NULL;
+}
+
+/*
+ * The boards this shim was written for have a single microphone, wired to
+ * the left channel, and the right channel of a stereo capture carries noise.
+ * The left channel is therefore copied into the right one before processing,
+ * on every device by default. Set the "goc.pcm.mirror_left.<card>.<device>"
+ * property to 0 to process the capture channels of a device as captured.
+ */
+bool mirror_left(unsigned card, unsigned device)
+{
+    char key[PROPERTY_KEY_MAX];
+    char value[PROPERTY_VALUE_MAX];
+
+    snprintf(key, sizeof(key), "goc.pcm.mirror_left.%u.%u", card, device);
+    property_get(key, value, "1");
+    return value[0] != '0';
+}
+
+void copy_left_to_right(int16_t *audio, size_t frames, unsigned channels)
+{
+    for (size_t i = 0; i < frames; i++, audio += channels)
+        audio[1] = audio[0];
+}
 
-static inline void audioFrame(AudioFrame& frame,void *audio,size_t size)
+AudioProcessing *create_apm(void)
 {
-    frame.id_ = 0;
-    frame.sample_rate_hz_ = 48000;
-    frame.num_channels_ = 2;
-    memcpy(frame.data_, audio, size);
-    frame.samples_per_channel_ = 480;
+    AudioProcessing *apm = AudioProcessing::Create();
+
+    apm->level_estimator()->Enable(false);
+    apm->high_pass_filter()->Enable(true);
+    apm->echo_cancellation()->enable_metrics(false);
+    apm->echo_cancellation()->enable_drift_compensation(false);
+    apm->echo_cancellation()->set_suppression_level(EchoCancellation::kHighSuppression);
+    apm->echo_cancellation()->Enable(true);
+
+    apm->noise_suppression()->set_level(NoiseSuppression::kVeryHigh);
+    apm->noise_suppression()->Enable(true);
+
+    apm->gain_control()->set_analog_level_limits(0, 255);
+    apm->gain_control()->set_mode(GainControl::kAdaptiveAnalog);
+    apm->gain_control()->Enable(true);
+
+    return apm;
 }
 
-static void try_apm_enable(void)
+/* Must be called with |g_devices_lock| held. */
+void start_engine(DuplexDevice *d)
 {
-    if(apm == NULL && is_read && is_write) {
-        apm = AudioProcessing::Create();
-        apm->Initialize(48000, 48000, 48000,
-                AudioProcessing::ChannelLayout::kStereo,
-                AudioProcessing::ChannelLayout::kStereo,
-                AudioProcessing::ChannelLayout::kStereo
-                );
+    if (d->capture_config.format != PCM_FORMAT_S16_LE ||
+        d->playback_config.format != PCM_FORMAT_S16_LE) {
+        ALOGW("card{%u, %u}: only S16_LE is processed", d->card, d->device);
+        return;
+    }
 
-        apm->level_estimator()->Enable(false);
-        apm->high_pass_filter()->Enable(true);
-        apm->echo_cancellation()->enable_metrics(false);
-        apm->echo_cancellation()->enable_drift_compensation(false);
-        apm->echo_cancellation()->set_suppression_level(EchoCancellation::kHighSuppression);
-        apm->echo_cancellation()->Enable(true);
+    DuplexEngine *engine = new DuplexEngine(create_apm(),
+            DuplexEngine::StreamFormat(d->capture_config.rate,
+                                       d->capture_channels,
+                                       d->capture_config.period_size),
+            DuplexEngine::StreamFormat(d->playback_config.rate,
+                                       d->playback_config.channels,
+                                       d->playback_config.period_size));
+    int err = engine->Start();
+    if (err != AudioProcessing::kNoError) {
+        ALOGE("card{%u, %u}: apm init failed %d", d->card, d->device, err);
+        delete engine;
+        return;
+    }
+
+    ALOGI("card{%u, %u}: capture{%u, %u, %u%s} playback{%u, %u, %u}",
+          d->card, d->device,
+          d->capture_config.rate, d->capture_channels, d->capture_config.period_size,
+          d->mirror_left && d->capture_channels > 1 ? ", mirrored" : "",
+          d->playback_config.rate, d->playback_config.channels,
+          d->playback_config.period_size);
+
+    rtc::CritScope capture_cs(&d->capture_lock);
+    rtc::CritScope playback_cs(&d->playback_lock);
+    d->engine = engine;
+}
 
-        apm->noise_suppression()->set_level(NoiseSuppression::kVeryHigh);
-        apm->noise_suppression()->Enable(true);
+/* Must be called with |g_devices_lock| held. */
+void stop_engine(DuplexDevice *d)
+{
+    DuplexEngine *engine;
+    {
+        rtc::CritScope capture_cs(&d->capture_lock);
+        rtc::CritScope playback_cs(&d->playback_lock);
+        engine = d->engine;
+        d->engine = NULL;
+    }
+    if (engine == NULL)
+        return;
+
+    DuplexEngine::Statistics stats = engine->GetStatistics();
+    ALOGI("card{%u, %u}: delay %d ms, overruns{%zu, %zu}, underruns %zu",
+          d->card, d->device, stats.stream_delay_ms, stats.render_overruns,
+          stats.capture_overruns, stats.capture_underruns);
+    delete engine;
+}
+
+void attach_pcm(unsigned card, unsigned device, unsigned flags,
+        const struct pcm_config *config, struct pcm *pcm)
+{
+    if (pcm == NULL || !pcm_is_ready(pcm))
+        return;
+
+    rtc::GlobalLockScope ls(&g_devices_lock);
+    DuplexDevice *d = get_device(card, device);
+    if (d == NULL) {
+        ALOGW("card{%u, %u}: too many devices", card, device);
+        return;
+    }
 
-        apm->gain_control()->set_analog_level_limits(0,255);
-        apm->gain_control()->set_mode(GainControl::kAdaptiveAnalog);
-        apm->gain_control()->Enable(true);
+    if (flags & PCM_IN) {
+        d->capture_config = *config;
+        /* The capture audio is downmixed to the channels it was opened with. */
+        d->capture_channels = config->in_init_channels == 1 ? 1 : config->channels;
+        d->mirror_left = mirror_left(card, device);
+        store_pcm(&d->capture, pcm);
+    } else {
+        d->playback_config = *config;
+        store_pcm(&d->playback, pcm);
     }
+
+    if (d->capture && d->playback)
+        start_engine(d);
 }
 
-static void try_apm_disable(void)
+void detach_pcm(struct pcm *pcm)
 {
-    if(apm != NULL) {
-        delete apm;
-        apm = NULL;
+    rtc::GlobalLockScope ls(&g_devices_lock);
+    for (int i = 0; i < kMaxDevices && g_devices[i]; i++) {
+        DuplexDevice *d = g_devices[i];
+        if (d->capture == pcm || d->playback == pcm) {
+            stop_engine(d);
+            store_pcm(d->capture == pcm ? &d->capture : &d->playback, NULL);
+            return;
+        }
     }
 }
 
-#if 0
-FILE *fr = NULL, *fw = NULL, *fe = NULL;
-#define OPEN(f, path) do {if(f == NULL) f = fopen(path, "w");}while(0)
-#define WRITE(f, buff, size) do{if(f != NULL) fwrite(buff, 1, size, f);}while(0)
-#else
-#define OPEN(f, path)
-#define WRITE(f, buff, size) 
-#endif
+}  // namespace
+
+extern "C" {
 
 struct pcm *W_pcm_open_req(unsigned card, unsigned device,
         unsigned flags, struct pcm_config *config, int requested_rate)
 {
     struct pcm *pcm;
-    //try_apm_enable();
 
-    //ALOGD("period_size : %d, %d", config->period_size, config->period_count);
     ALOGD("pcm_open_req period{%d, %d}, card{%d, %d, %x}", config->period_size, config->period_count, card, device, flags);
 
-    //if((flags & PCM_IN) && !card && !device)
-    //    config->period_size = 480;
-    config->period_size = 1024;
     pcm = L_pcm_open_req(card, device, flags, config, requested_rate);
-    config->period_size = 480;
-    if(!card && !device) {
-        ((flags & PCM_IN) ? capture : playback) = pcm;
-        if(capture && playback) {
-            OPEN(fw, "/data/goc/pcm/write.pcm");
-            OPEN(fr, "/data/goc/pcm/read.pcm");
-            OPEN(fe, "/data/goc/pcm/echo.pcm");
-            //apm->Initialize();
-        }
-    }
+    attach_pcm(card, device, flags, config, pcm);
 
     return pcm;
 }
@@ -140,56 +293,30 @@ struct pcm *W_pcm_open_req(unsigned card, unsigned device,
 struct pcm *W_pcm_open(unsigned card, unsigned device,
         unsigned flags, struct pcm_config *config)
 {
-    struct pcm * pcm;
-    //try_apm_enable();
+    struct pcm *pcm;
 
     ALOGD("pcm_open period{%d, %d}, card{%d, %d, %x}", config->period_size, config->period_count, card, device, flags);
 
-    //if((flags & PCM_IN) && !card && !device)
-    config->period_size = 1024;
     pcm = L_pcm_open(card, device, flags, config);
-    config->period_size = 480;
-    if(!card && !device) {
-        ((flags & PCM_IN) ? capture : playback) = pcm;
-        if(capture && playback) {
-            OPEN(fw, "/data/goc/pcm/write.pcm");
-            OPEN(fr, "/data/goc/pcm/read.pcm");
-            OPEN(fe, "/data/goc/pcm/echo.pcm");
-            //apm->Initialize();
-        }
-    }
+    attach_pcm(card, device, flags, config, pcm);
 
     return pcm;
 }
 
-static long playback_delay = 0, capture_delay = 0;
-
-static void fixup(short audio[], int count)
-{
-    for(int i = 0;i < count;i += 2)
-        audio[i + 1] = audio[i];
-
-}
-
 int W_pcm_read(struct pcm *pcm, void *data, unsigned count)
 {
-    capture_delay = pcm_get_delay(pcm) ?: 240;
     int res = L_pcm_read(pcm, data, count);
-    if(pcm == capture && playback) {
-        is_read = true;
-        if(is_read && is_write) {
-            try_apm_enable();
-            //ALOGV("delay : {%d, %d, %d}, %d", playback_delay + capture_delay, playback_delay, capture_delay, count);
-            AudioFrame frame;
-            fixup((short*)data, count / 2);
-            WRITE(fr, data, count);
-            audioFrame(frame, data, count);
-            apm->gain_control()->set_stream_analog_level(analog_level);
-            apm->set_stream_delay_ms(40/*(playback_delay + capture_delay) / (48)*/);
-            apm->ProcessStream(&frame);
-            analog_level = apm->gain_control()->stream_analog_level();
-            memcpy(data, frame.data_, count);
-            WRITE(fe, data, count);
+    if (res != 0)
+        return res;
+
+    DuplexDevice *d = find_device(pcm, true);
+    if (d != NULL) {
+        rtc::CritScope cs(&d->capture_lock);
+        if (d->engine != NULL) {
+            size_t frames = count / (d->capture_channels * sizeof(int16_t));
+            if (d->mirror_left && d->capture_channels > 1)
+                copy_left_to_right((int16_t *)data, frames, d->capture_channels);
+            d->engine->OnCapture((int16_t *)data, frames, queued_frames(pcm));
         }
     }
     return res;
@@ -197,16 +324,13 @@ int W_pcm_read(struct pcm *pcm, void *data, unsigned count)
 
 int W_pcm_write(struct pcm *pcm, const void *data, unsigned count)
 {
-    if(pcm == playback && capture) {
-        is_write = true;
-        if(is_write && is_read) {
-            try_apm_enable();
-            AudioFrame frame;
-            audioFrame(frame, (void*)data, (size_t)count);
-            playback_delay = pcm_get_delay(playback) ?: 960;
-            //ALOGV("playback %d,%d\n", playback_delay, count);
-            apm->AnalyzeReverseStream(&frame);
-            WRITE(fw, data, count);
+    DuplexDevice *d = find_device(pcm, false);
+    if (d != NULL) {
+        rtc::CritScope cs(&d->playback_lock);
+        if (d->engine != NULL) {
+            d->engine->OnRender((const int16_t *)data,
+                    count / (d->playback_config.channels * sizeof(int16_t)),
+                    queued_frames(pcm));
         }
     }
     return L_pcm_write(pcm, data, count);
@@ -214,16 +338,7 @@ int W_pcm_write(struct pcm *pcm, const void *data, unsigned count)
 
 int W_pcm_close(struct pcm *pcm)
 {
-    if(capture == pcm) {
-        capture = NULL;
-        is_read = false;
-        try_apm_disable();
-    }
-    if(playback == pcm) {
-        capture = NULL;
-        is_write = false;
-        try_apm_disable();
-    }
+    detach_pcm(pcm);
     return L_pcm_close(pcm);
 }
 
@@ -17,22 +17,6 @@
 
 namespace webrtc {
 
-// Functor to use when supplying a verifier function for the queue item
-// verifcation.
-template <typename T>
-class RenderQueueItemVerifier {
- public:
-  explicit RenderQueueItemVerifier(size_t minimum_capacity)
-      : minimum_capacity_(minimum_capacity) {}
-
-  bool operator()(const std::vector<T>& v) const {
-    return v.capacity() >= minimum_capacity_;
-  }
-
- private:
-  size_t minimum_capacity_;
-};
-
 class ProcessingComponent {
  public:
   ProcessingComponent();
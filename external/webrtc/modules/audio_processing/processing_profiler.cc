@@ -0,0 +1,144 @@
+/*
+ *  Copyright (c) 2016 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "webrtc/modules/audio_processing/processing_profiler.h"
+
+#include <algorithm>
+
+#include "webrtc/base/arraysize.h"
+#include "webrtc/base/checks.h"
+#include "webrtc/modules/audio_processing/audio_buffer.h"
+
+namespace webrtc {
+namespace {
+
+const char* const kCaptureStageNames[] = {
+    "processing",
+    "input_conversion",
+    "agc_manager_analysis",
+    "split",
+    "intelligibility",
+    "beamformer",
+    "high_pass_filter",
+    "gain_control_analysis",
+    "noise_suppression_analysis",
+    "echo_cancellation",
+    "noise_suppression",
+    "echo_control_mobile",
+    "voice_detection",
+    "gain_control",
+    "merge",
+    "transient_suppression",
+    "level_estimator",
+    "output_conversion",
+};
+static_assert(arraysize(kCaptureStageNames) ==
+                  ProcessingProfiler::kNumCaptureStages,
+              "A name is needed for every capture stage");
+
+const char* const kRenderStageNames[] = {
+    "processing",
+    "input_conversion",
+    "split",
+    "intelligibility",
+    "echo_cancellation",
+    "echo_control_mobile",
+    "gain_control",
+    "merge",
+    "output_conversion",
+};
+static_assert(arraysize(kRenderStageNames) ==
+                  ProcessingProfiler::kNumRenderStages,
+              "A name is needed for every render stage");
+
+}  // namespace
+
+const size_t ProcessingProfiler::kNumHistogramBins;
+
+ProcessingProfiler::StageStatistics::StageStatistics()
+    : calls(0), total_ns(0), max_ns(0) {
+  std::fill(histogram, histogram + kNumHistogramBins, 0);
+}
+
+ProcessingProfiler::Statistics::Statistics()
+    : conversions(0), resamplings(0), format_conversions(0) {}
+
+ProcessingProfiler::ProcessingProfiler(Direction direction)
+    : direction_(direction), enabled_(false) {
+  Reset();
+}
+
+ProcessingProfiler::~ProcessingProfiler() {}
+
+size_t ProcessingProfiler::NumStages(Direction direction) {
+  return direction == kCapture ? static_cast<size_t>(kNumCaptureStages)
+                               : static_cast<size_t>(kNumRenderStages);
+}
+
+const char* ProcessingProfiler::StageName(Direction direction, size_t stage) {
+  RTC_DCHECK_LT(stage, NumStages(direction));
+  return direction == kCapture ? kCaptureStageNames[stage]
+                               : kRenderStageNames[stage];
+}
+
+size_t ProcessingProfiler::HistogramBin(int64_t duration_ns) {
+  int64_t duration_us = duration_ns / rtc::kNumNanosecsPerMicrosec;
+  size_t bin = 0;
+  while (duration_us > 0 && bin < kNumHistogramBins - 1) {
+    duration_us >>= 1;
+    ++bin;
+  }
+  return bin;
+}
+
+void ProcessingProfiler::Reset() {
+  stats_ = Statistics();
+  stats_.stages.resize(NumStages(direction_));
+}
+
+void ProcessingProfiler::EndStage(size_t stage, int64_t start_ns) {
+  RTC_DCHECK_LT(stage, stats_.stages.size());
+  const int64_t duration_ns =
+      static_cast<int64_t>(rtc::TimeNanos()) - start_ns;
+  StageStatistics& stage_stats = stats_.stages[stage];
+  ++stage_stats.calls;
+  stage_stats.total_ns += duration_ns;
+  stage_stats.max_ns = std::max(stage_stats.max_ns, duration_ns);
+  ++stage_stats.histogram[HistogramBin(duration_ns)];
+}
+
+void ProcessingProfiler::CountConversion(size_t from_frames,
+                                         size_t to_frames) {
+  if (!enabled_)
+    return;
+  ++stats_.conversions;
+  if (from_frames != to_frames)
+    ++stats_.resamplings;
+}
+
+void ProcessingProfiler::CountFormatConversions(size_t count) {
+  if (!enabled_)
+    return;
+  stats_.format_conversions += count;
+}
+
+ScopedFormatConversionCounter::ScopedFormatConversionCounter(
+    ProcessingProfiler* profiler,
+    const AudioBuffer* buffer)
+    : profiler_(profiler),
+      buffer_(buffer),
+      start_count_(buffer->num_format_conversions()) {}
+
+ScopedFormatConversionCounter::~ScopedFormatConversionCounter() {
+  profiler_->CountFormatConversions(buffer_->num_format_conversions() -
+                                    start_count_);
+}
+
+}  // namespace webrtc
@@ -0,0 +1,179 @@
+/*
+ *  Copyright (c) 2016 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef WEBRTC_MODULES_AUDIO_PROCESSING_PROCESSING_PROFILER_H_
+#define WEBRTC_MODULES_AUDIO_PROCESSING_PROCESSING_PROFILER_H_
+
+#include <stddef.h>
+
+#include <vector>
+
+#include "webrtc/base/constructormagic.h"
+#include "webrtc/base/timeutils.h"
+#include "webrtc/typedefs.h"
+
+namespace webrtc {
+
+class AudioBuffer;
+
+// Accumulates the time spent in each stage of one processing direction of
+// the APM, along with a duration histogram per stage, and counts the format
+// conversions of the AudioBuffer, both at the API boundary and between its
+// int16 and float representations during processing.
+//
+// Profiling is disabled by default, in which case timing a stage costs a
+// single branch. Not thread safe; each direction owns a profiler which is
+// protected by the lock of that direction.
+class ProcessingProfiler {
+ public:
+  enum Direction { kCapture, kRender };
+
+  // Capture side stages, in processing order. kCaptureProcessing covers the
+  // whole of the processing between the input and the output conversion.
+  enum CaptureStage {
+    kCaptureProcessing = 0,
+    kCaptureInputConversion,
+    kCaptureAgcManagerAnalysis,
+    kCaptureSplit,
+    kCaptureIntelligibility,
+    kCaptureBeamformer,
+    kCaptureHighPassFilter,
+    kCaptureGainControlAnalysis,
+    kCaptureNoiseSuppressionAnalysis,
+    kCaptureEchoCancellation,
+    kCaptureNoiseSuppression,
+    kCaptureEchoControlMobile,
+    kCaptureVoiceDetection,
+    kCaptureGainControl,
+    kCaptureMerge,
+    kCaptureTransientSuppression,
+    kCaptureLevelEstimator,
+    kCaptureOutputConversion,
+    kNumCaptureStages
+  };
+
+  // Render side stages, in processing order. kRenderProcessing covers the
+  // whole of the processing between the input and the output conversion.
+  enum RenderStage {
+    kRenderProcessing = 0,
+    kRenderInputConversion,
+    kRenderSplit,
+    kRenderIntelligibility,
+    kRenderEchoCancellation,
+    kRenderEchoControlMobile,
+    kRenderGainControl,
+    kRenderMerge,
+    kRenderOutputConversion,
+    kNumRenderStages
+  };
+
+  // The histogram bins double in width: bin 0 counts the durations below
+  // 1 us, bin i the durations in [2^(i - 1), 2^i) us and the last bin all
+  // longer durations, from 16.384 ms on.
+  static const size_t kNumHistogramBins = 16;
+
+  struct StageStatistics {
+    StageStatistics();
+
+    size_t calls;
+    int64_t total_ns;
+    int64_t max_ns;
+    size_t histogram[kNumHistogramBins];
+  };
+
+  struct Statistics {
+    Statistics();
+
+    // Indexed by CaptureStage or RenderStage.
+    std::vector<StageStatistics> stages;
+    // Conversions between the API format and the processing format.
+    size_t conversions;
+    // Conversions which changed the sample rate.
+    size_t resamplings;
+    // Conversions of the whole AudioBuffer data between int16 and float,
+    // when a component reads the data in the format not written last. These
+    // are not part of |conversions|.
+    size_t format_conversions;
+  };
+
+  explicit ProcessingProfiler(Direction direction);
+  ~ProcessingProfiler();
+
+  static size_t NumStages(Direction direction);
+  // Returns a short lower case name, such as "echo_cancellation".
+  static const char* StageName(Direction direction, size_t stage);
+  // Returns the bin of |stats.histogram| which counts a duration of
+  // |duration_ns|.
+  static size_t HistogramBin(int64_t duration_ns);
+
+  Direction direction() const { return direction_; }
+  bool enabled() const { return enabled_; }
+  // Keeps the statistics accumulated so far.
+  void set_enabled(bool enabled) { enabled_ = enabled; }
+  void Reset();
+
+  // Returns the start time to pass to EndStage(), or -1 if disabled.
+  int64_t StartStage() const {
+    return enabled_ ? static_cast<int64_t>(rtc::TimeNanos()) : -1;
+  }
+  void EndStage(size_t stage, int64_t start_ns);
+
+  // Counts a conversion from |from_frames| to |to_frames| frames per channel.
+  void CountConversion(size_t from_frames, size_t to_frames);
+  // Counts |count| int16 <-> float conversions inside the AudioBuffer.
+  void CountFormatConversions(size_t count);
+
+  const Statistics& statistics() const { return stats_; }
+
+ private:
+  const Direction direction_;
+  bool enabled_;
+  Statistics stats_;
+
+  RTC_DISALLOW_COPY_AND_ASSIGN(ProcessingProfiler);
+};
+
+// Times the enclosing scope as one call of |stage|.
+class ScopedStageTimer {
+ public:
+  ScopedStageTimer(ProcessingProfiler* profiler, size_t stage)
+      : profiler_(profiler), stage_(stage), start_ns_(profiler->StartStage()) {}
+  ~ScopedStageTimer() {
+    if (start_ns_ >= 0)
+      profiler_->EndStage(stage_, start_ns_);
+  }
+
+ private:
+  ProcessingProfiler* const profiler_;
+  const size_t stage_;
+  const int64_t start_ns_;
+
+  RTC_DISALLOW_COPY_AND_ASSIGN(ScopedStageTimer);
+};
+
+// Counts the int16 <-> float conversions of |buffer| within the enclosing
+// scope, including when it is left early on an error.
+class ScopedFormatConversionCounter {
+ public:
+  ScopedFormatConversionCounter(ProcessingProfiler* profiler,
+                                const AudioBuffer* buffer);
+  ~ScopedFormatConversionCounter();
+
+ private:
+  ProcessingProfiler* const profiler_;
+  const AudioBuffer* const buffer_;
+  const size_t start_count_;
+
+  RTC_DISALLOW_COPY_AND_ASSIGN(ScopedFormatConversionCounter);
+};
+
+}  // namespace webrtc
+
+#endif  // WEBRTC_MODULES_AUDIO_PROCESSING_PROCESSING_PROFILER_H_
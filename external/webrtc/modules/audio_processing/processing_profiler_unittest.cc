@@ -0,0 +1,124 @@
+/*
+ *  Copyright (c) 2016 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "webrtc/modules/audio_processing/processing_profiler.h"
+
+#include <string>
+
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace webrtc {
+namespace {
+
+size_t HistogramSum(const ProcessingProfiler::StageStatistics& stats) {
+  size_t sum = 0;
+  for (size_t i = 0; i < ProcessingProfiler::kNumHistogramBins; ++i)
+    sum += stats.histogram[i];
+  return sum;
+}
+
+TEST(ProcessingProfilerTest, IsDisabledByDefault) {
+  ProcessingProfiler profiler(ProcessingProfiler::kCapture);
+  EXPECT_FALSE(profiler.enabled());
+  EXPECT_EQ(-1, profiler.StartStage());
+  {
+    ScopedStageTimer timer(&profiler, ProcessingProfiler::kCaptureSplit);
+  }
+  profiler.CountConversion(480, 160);
+  profiler.CountFormatConversions(2);
+
+  const ProcessingProfiler::Statistics& stats = profiler.statistics();
+  ASSERT_EQ(static_cast<size_t>(ProcessingProfiler::kNumCaptureStages),
+            stats.stages.size());
+  EXPECT_EQ(0u, stats.stages[ProcessingProfiler::kCaptureSplit].calls);
+  EXPECT_EQ(0u, stats.conversions);
+  EXPECT_EQ(0u, stats.format_conversions);
+}
+
+TEST(ProcessingProfilerTest, TimesStages) {
+  ProcessingProfiler profiler(ProcessingProfiler::kRender);
+  profiler.set_enabled(true);
+  for (int i = 0; i < 3; ++i) {
+    ScopedStageTimer timer(&profiler, ProcessingProfiler::kRenderMerge);
+  }
+  profiler.EndStage(ProcessingProfiler::kRenderSplit,
+                    profiler.StartStage() - 5 * rtc::kNumNanosecsPerMillisec);
+
+  const ProcessingProfiler::Statistics& stats = profiler.statistics();
+  ASSERT_EQ(static_cast<size_t>(ProcessingProfiler::kNumRenderStages),
+            stats.stages.size());
+  const ProcessingProfiler::StageStatistics& merge =
+      stats.stages[ProcessingProfiler::kRenderMerge];
+  EXPECT_EQ(3u, merge.calls);
+  EXPECT_EQ(3u, HistogramSum(merge));
+  EXPECT_LE(merge.max_ns, merge.total_ns);
+
+  const ProcessingProfiler::StageStatistics& split =
+      stats.stages[ProcessingProfiler::kRenderSplit];
+  EXPECT_EQ(1u, split.calls);
+  EXPECT_GE(split.max_ns, 5 * rtc::kNumNanosecsPerMillisec);
+  EXPECT_EQ(split.max_ns, split.total_ns);
+  EXPECT_EQ(1u, split.histogram[ProcessingProfiler::HistogramBin(
+                    split.max_ns)]);
+  EXPECT_EQ(0u, stats.stages[ProcessingProfiler::kRenderProcessing].calls);
+
+  profiler.Reset();
+  EXPECT_TRUE(profiler.enabled());
+  EXPECT_EQ(0u, profiler.statistics().stages[ProcessingProfiler::kRenderMerge]
+                    .calls);
+}
+
+TEST(ProcessingProfilerTest, HistogramBinsDoubleInWidth) {
+  const int64_t kUs = rtc::kNumNanosecsPerMicrosec;
+  EXPECT_EQ(0u, ProcessingProfiler::HistogramBin(0));
+  EXPECT_EQ(0u, ProcessingProfiler::HistogramBin(kUs - 1));
+  EXPECT_EQ(1u, ProcessingProfiler::HistogramBin(kUs));
+  EXPECT_EQ(2u, ProcessingProfiler::HistogramBin(2 * kUs));
+  EXPECT_EQ(2u, ProcessingProfiler::HistogramBin(4 * kUs - 1));
+  EXPECT_EQ(11u, ProcessingProfiler::HistogramBin(1500 * kUs));
+  EXPECT_EQ(ProcessingProfiler::kNumHistogramBins - 1,
+            ProcessingProfiler::HistogramBin(16384 * kUs));
+  EXPECT_EQ(ProcessingProfiler::kNumHistogramBins - 1,
+            ProcessingProfiler::HistogramBin(rtc::kNumNanosecsPerSec));
+}
+
+TEST(ProcessingProfilerTest, CountsConversions) {
+  ProcessingProfiler profiler(ProcessingProfiler::kCapture);
+  profiler.set_enabled(true);
+  profiler.CountConversion(480, 480);
+  profiler.CountConversion(441, 480);
+  profiler.CountConversion(480, 160);
+  EXPECT_EQ(3u, profiler.statistics().conversions);
+  EXPECT_EQ(2u, profiler.statistics().resamplings);
+  EXPECT_EQ(0u, profiler.statistics().format_conversions);
+
+  profiler.CountFormatConversions(2);
+  profiler.CountFormatConversions(0);
+  EXPECT_EQ(2u, profiler.statistics().format_conversions);
+  EXPECT_EQ(3u, profiler.statistics().conversions);
+}
+
+TEST(ProcessingProfilerTest, NamesEveryStage) {
+  for (size_t i = 0; i < ProcessingProfiler::kNumCaptureStages; ++i) {
+    EXPECT_FALSE(std::string(ProcessingProfiler::StageName(
+                                 ProcessingProfiler::kCapture, i)).empty());
+  }
+  for (size_t i = 0; i < ProcessingProfiler::kNumRenderStages; ++i) {
+    EXPECT_FALSE(std::string(ProcessingProfiler::StageName(
+                                 ProcessingProfiler::kRender, i)).empty());
+  }
+  EXPECT_EQ(std::string("echo_cancellation"),
+            ProcessingProfiler::StageName(
+                ProcessingProfiler::kCapture,
+                ProcessingProfiler::kCaptureEchoCancellation));
+}
+
+}  // namespace
+}  // namespace webrtc
@@ -0,0 +1,124 @@
+/*
+ *  Copyright (c) 2016 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "webrtc/modules/audio_processing/render_queue.h"
+
+#include <algorithm>
+
+#include "webrtc/base/atomicops.h"
+#include "webrtc/base/checks.h"
+
+namespace webrtc {
+namespace {
+
+const size_t kCacheLineSize = 64;
+
+// Every per-channel array holds a whole number of cache lines, so that all
+// arrays in all slots start on a cache line.
+static_assert(RenderQueueItem::kMaxFramesPerBand * sizeof(int16_t) %
+                      kCacheLineSize ==
+                  0,
+              "Slot arrays must fill whole cache lines");
+
+}  // namespace
+
+const size_t RenderQueueItem::kMaxFramesPerBand;
+const size_t RenderQueue::kNumSlots;
+
+RenderQueue::RenderQueue()
+    : ring_(1, kNumSlots),
+      max_channels_(0),
+      frame_read_(false),
+      render_started_(0),
+      overflows_(0),
+      underflows_(0) {}
+
+RenderQueue::~RenderQueue() {}
+
+void RenderQueue::Allocate(size_t num_channels) {
+  num_channels = std::max<size_t>(num_channels, 1);
+  const size_t num_slots = ring_.num_slots();
+  if (num_channels > max_channels_) {
+    const size_t frames = RenderQueueItem::kMaxFramesPerBand;
+    const size_t float_size = num_channels * frames * sizeof(float);
+    const size_t int16_size = num_channels * frames * sizeof(int16_t);
+    const size_t mixed_size = frames * sizeof(int16_t);
+    const size_t slot_size = float_size + int16_size + mixed_size;
+
+    buffer_.reset(
+        AlignedMalloc<uint8_t>(num_slots * slot_size, kCacheLineSize));
+    for (size_t i = 0; i < num_slots; ++i) {
+      uint8_t* data = buffer_.get() + i * slot_size;
+      RenderQueueItem* item = ring_.slot(i);
+      item->float_data_ = reinterpret_cast<float*>(data);
+      item->int16_data_ = reinterpret_cast<int16_t*>(data + float_size);
+      item->mixed_data_ =
+          reinterpret_cast<int16_t*>(data + float_size + int16_size);
+    }
+    max_channels_ = num_channels;
+  }
+
+  for (size_t i = 0; i < num_slots; ++i) {
+    RenderQueueItem* item = ring_.slot(i);
+    item->num_channels_ = num_channels;
+    item->num_frames_per_band_ = 0;
+    item->content_ = 0;
+  }
+  ring_.Clear();
+  rtc::AtomicOps::ReleaseStore(&render_started_, 0);
+  frame_read_ = false;
+}
+
+RenderQueueItem* RenderQueue::BeginWrite(size_t num_frames_per_band) {
+  RTC_DCHECK_LE(num_frames_per_band, RenderQueueItem::kMaxFramesPerBand);
+  if (max_channels_ == 0)
+    return NULL;
+  if (ring_.WriteItemsAvailable() == 0) {
+    rtc::AtomicOps::Increment(&overflows_);
+    return NULL;
+  }
+  RenderQueueItem* item = ring_.GetWriteRegions(1).data[0];
+  item->num_frames_per_band_ = num_frames_per_band;
+  item->content_ = 0;
+  return item;
+}
+
+void RenderQueue::EndWrite() {
+  if (ring_.GetWriteRegions(1).data[0]->content_ == 0)
+    return;
+  ring_.Commit(1);
+  rtc::AtomicOps::ReleaseStore(&render_started_, 1);
+}
+
+const RenderQueueItem* RenderQueue::BeginRead() {
+  if (ring_.ReadItemsAvailable() == 0)
+    return NULL;
+  return ring_.GetReadRegions(1).data[0];
+}
+
+void RenderQueue::EndRead() {
+  ring_.Consume(1);
+  frame_read_ = true;
+}
+
+void RenderQueue::CheckUnderflow() {
+  if (!frame_read_ && rtc::AtomicOps::AcquireLoad(&render_started_))
+    rtc::AtomicOps::Increment(&underflows_);
+  frame_read_ = false;
+}
+
+RenderQueue::Statistics RenderQueue::GetStatistics() const {
+  Statistics stats;
+  stats.overflows = rtc::AtomicOps::AcquireLoad(&overflows_);
+  stats.underflows = rtc::AtomicOps::AcquireLoad(&underflows_);
+  return stats;
+}
+
+}  // namespace webrtc
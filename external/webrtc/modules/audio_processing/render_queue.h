@@ -0,0 +1,137 @@
+/*
+ *  Copyright (c) 2016 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef WEBRTC_MODULES_AUDIO_PROCESSING_RENDER_QUEUE_H_
+#define WEBRTC_MODULES_AUDIO_PROCESSING_RENDER_QUEUE_H_
+
+#include <stddef.h>
+
+#include "webrtc/base/constructormagic.h"
+#include "webrtc/base/scoped_ptr.h"
+#include "webrtc/modules/audio_processing/spsc_ring_buffer.h"
+#include "webrtc/system_wrappers/include/aligned_malloc.h"
+#include "webrtc/typedefs.h"
+
+namespace webrtc {
+
+// One 10 ms render frame, as queued for the capture side components. Each
+// component fills in the representation it consumes on the render side and
+// marks it as present; a frame only carries the representations of the
+// components which were enabled when it was queued.
+class RenderQueueItem {
+ public:
+  enum Content {
+    // The lowest band of every channel as float, for the AEC.
+    kBand0Float = 1 << 0,
+    // The lowest band of every channel as int16, for the AECM.
+    kBand0Int16 = 1 << 1,
+    // The mixed lowest band as int16, for the AGC.
+    kMixedLowPass = 1 << 2,
+  };
+
+  size_t num_channels() const { return num_channels_; }
+  size_t num_frames_per_band() const { return num_frames_per_band_; }
+
+  bool has_content(Content content) const { return (content_ & content) != 0; }
+  void add_content(Content content) { content_ |= content; }
+
+  float* band0_f(size_t channel) {
+    return float_data_ + channel * kMaxFramesPerBand;
+  }
+  const float* band0_f(size_t channel) const {
+    return float_data_ + channel * kMaxFramesPerBand;
+  }
+  int16_t* band0(size_t channel) {
+    return int16_data_ + channel * kMaxFramesPerBand;
+  }
+  const int16_t* band0(size_t channel) const {
+    return int16_data_ + channel * kMaxFramesPerBand;
+  }
+  int16_t* mixed_low_pass_data() { return mixed_data_; }
+  const int16_t* mixed_low_pass_data() const { return mixed_data_; }
+
+  static const size_t kMaxFramesPerBand = 160;
+
+ private:
+  friend class RenderQueue;
+
+  float* float_data_;
+  int16_t* int16_data_;
+  int16_t* mixed_data_;
+  size_t num_channels_;
+  size_t num_frames_per_band_;
+  int content_;
+};
+
+// Hands the render frames over from the render thread to the capture thread,
+// where they are fanned out to all the components using them.
+//
+// The frames live in an SpscRingBuffer of preallocated slots, whose data is
+// cache line aligned and which the render side fills in place; no memory is
+// allocated and no lock is taken after Allocate(). The render thread is the
+// only producer and the capture thread the only consumer, so neither needs
+// the other's lock. When the capture side falls behind and the ring is full,
+// new render frames are dropped and counted as overflows.
+class RenderQueue {
+ public:
+  struct Statistics {
+    Statistics() : overflows(0), underflows(0) {}
+
+    // Render frames dropped because the ring was full.
+    size_t overflows;
+    // Capture side reads which found no new render frame, once the render
+    // stream has started.
+    size_t underflows;
+  };
+
+  static const size_t kNumSlots = 100;
+
+  RenderQueue();
+  ~RenderQueue();
+
+  // Prepares the ring for frames of |num_channels| channels and empties it.
+  // Only reallocates when the ring is too small. Neither side may be active.
+  void Allocate(size_t num_channels);
+
+  // Render side. Returns the slot to fill in with the next frame, or NULL if
+  // the ring is full. The slot is queued by EndWrite().
+  RenderQueueItem* BeginWrite(size_t num_frames_per_band);
+  // Queues the slot returned by BeginWrite(), unless no content was added.
+  void EndWrite();
+
+  // Capture side. Returns the oldest queued frame, or NULL if there is none.
+  // The frame is released by EndRead().
+  const RenderQueueItem* BeginRead();
+  void EndRead();
+
+  // Counts an underflow if no frame has been read since the last call.
+  void CheckUnderflow();
+
+  // May be called from any thread.
+  Statistics GetStatistics() const;
+
+ private:
+  rtc::scoped_ptr<uint8_t, AlignedFreeDeleter> buffer_;
+  SpscRingBuffer<RenderQueueItem> ring_;
+  size_t max_channels_;
+
+  // Only accessed by the capture side.
+  bool frame_read_;
+
+  volatile int render_started_;
+  volatile int overflows_;
+  volatile int underflows_;
+
+  RTC_DISALLOW_COPY_AND_ASSIGN(RenderQueue);
+};
+
+}  // namespace webrtc
+
+#endif  // WEBRTC_MODULES_AUDIO_PROCESSING_RENDER_QUEUE_H_
@@ -0,0 +1,194 @@
+/*
+ *  Copyright (c) 2016 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "webrtc/modules/audio_processing/render_queue.h"
+
+#include "testing/gtest/include/gtest/gtest.h"
+#include "webrtc/base/platform_thread.h"
+
+namespace webrtc {
+namespace {
+
+const size_t kNumChannels = 2;
+const size_t kNumFramesPerBand = 160;
+
+// Marks the frame with |value| in all of its representations.
+void WriteFrame(RenderQueueItem* item, int value) {
+  for (size_t ch = 0; ch < item->num_channels(); ++ch) {
+    for (size_t i = 0; i < item->num_frames_per_band(); ++i) {
+      item->band0_f(ch)[i] = static_cast<float>(value + ch);
+      item->band0(ch)[i] = static_cast<int16_t>(value + ch);
+    }
+  }
+  for (size_t i = 0; i < item->num_frames_per_band(); ++i)
+    item->mixed_low_pass_data()[i] = static_cast<int16_t>(value);
+  item->add_content(RenderQueueItem::kBand0Float);
+  item->add_content(RenderQueueItem::kBand0Int16);
+  item->add_content(RenderQueueItem::kMixedLowPass);
+}
+
+void ExpectFrame(const RenderQueueItem& item, int value) {
+  ASSERT_EQ(kNumChannels, item.num_channels());
+  ASSERT_EQ(kNumFramesPerBand, item.num_frames_per_band());
+  for (size_t ch = 0; ch < item.num_channels(); ++ch) {
+    for (size_t i = 0; i < item.num_frames_per_band(); ++i) {
+      ASSERT_EQ(static_cast<float>(value + ch), item.band0_f(ch)[i]);
+      ASSERT_EQ(static_cast<int16_t>(value + ch), item.band0(ch)[i]);
+    }
+  }
+  for (size_t i = 0; i < item.num_frames_per_band(); ++i)
+    ASSERT_EQ(static_cast<int16_t>(value), item.mixed_low_pass_data()[i]);
+}
+
+bool PushFrame(RenderQueue* queue, int value) {
+  RenderQueueItem* item = queue->BeginWrite(kNumFramesPerBand);
+  if (!item)
+    return false;
+  WriteFrame(item, value);
+  queue->EndWrite();
+  return true;
+}
+
+TEST(RenderQueueTest, SlotsAreCacheLineAligned) {
+  RenderQueue queue;
+  queue.Allocate(kNumChannels);
+  for (size_t i = 0; i < 3; ++i) {
+    RenderQueueItem* item = queue.BeginWrite(kNumFramesPerBand);
+    ASSERT_TRUE(item);
+    for (size_t ch = 0; ch < kNumChannels; ++ch) {
+      EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(item->band0_f(ch)) % 64);
+      EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(item->band0(ch)) % 64);
+    }
+    EXPECT_EQ(0u,
+              reinterpret_cast<uintptr_t>(item->mixed_low_pass_data()) % 64);
+    WriteFrame(item, 0);
+    queue.EndWrite();
+  }
+}
+
+TEST(RenderQueueTest, WrapsAround) {
+  RenderQueue queue;
+  queue.Allocate(kNumChannels);
+  int next_write = 0;
+  int next_read = 0;
+  for (int i = 0; i < 50; ++i) {
+    for (int j = 0; j < 7; ++j)
+      ASSERT_TRUE(PushFrame(&queue, next_write++));
+    while (const RenderQueueItem* item = queue.BeginRead()) {
+      ASSERT_NO_FATAL_FAILURE(ExpectFrame(*item, next_read++));
+      queue.EndRead();
+    }
+    ASSERT_EQ(next_write, next_read);
+  }
+  EXPECT_EQ(0u, queue.GetStatistics().overflows);
+}
+
+TEST(RenderQueueTest, CountsOverflowsAndDropsNewestFrames) {
+  RenderQueue queue;
+  queue.Allocate(kNumChannels);
+  for (size_t i = 0; i < RenderQueue::kNumSlots; ++i)
+    ASSERT_TRUE(PushFrame(&queue, static_cast<int>(i)));
+  EXPECT_FALSE(PushFrame(&queue, -1));
+  EXPECT_FALSE(PushFrame(&queue, -1));
+  EXPECT_EQ(2u, queue.GetStatistics().overflows);
+
+  for (size_t i = 0; i < RenderQueue::kNumSlots; ++i) {
+    const RenderQueueItem* item = queue.BeginRead();
+    ASSERT_TRUE(item);
+    ASSERT_NO_FATAL_FAILURE(ExpectFrame(*item, static_cast<int>(i)));
+    queue.EndRead();
+  }
+  EXPECT_FALSE(queue.BeginRead());
+}
+
+TEST(RenderQueueTest, CountsUnderflowsOnceRenderHasStarted) {
+  RenderQueue queue;
+  queue.Allocate(kNumChannels);
+  queue.CheckUnderflow();
+  EXPECT_EQ(0u, queue.GetStatistics().underflows);
+
+  ASSERT_TRUE(PushFrame(&queue, 0));
+  queue.BeginRead();
+  queue.EndRead();
+  queue.CheckUnderflow();
+  EXPECT_EQ(0u, queue.GetStatistics().underflows);
+  queue.CheckUnderflow();
+  queue.CheckUnderflow();
+  EXPECT_EQ(2u, queue.GetStatistics().underflows);
+}
+
+TEST(RenderQueueTest, SkipsFramesWithoutContent) {
+  RenderQueue queue;
+  queue.Allocate(kNumChannels);
+  RenderQueueItem* item = queue.BeginWrite(kNumFramesPerBand);
+  ASSERT_TRUE(item);
+  queue.EndWrite();
+  EXPECT_FALSE(queue.BeginRead());
+
+  item = queue.BeginWrite(kNumFramesPerBand);
+  ASSERT_TRUE(item);
+  EXPECT_FALSE(item->has_content(RenderQueueItem::kMixedLowPass));
+  item->add_content(RenderQueueItem::kMixedLowPass);
+  queue.EndWrite();
+  const RenderQueueItem* read_item = queue.BeginRead();
+  ASSERT_TRUE(read_item);
+  EXPECT_TRUE(read_item->has_content(RenderQueueItem::kMixedLowPass));
+  EXPECT_FALSE(read_item->has_content(RenderQueueItem::kBand0Float));
+  EXPECT_FALSE(read_item->has_content(RenderQueueItem::kBand0Int16));
+}
+
+// Streams frames from a render thread to the capture side on the test thread
+// and checks that they arrive intact and in order.
+class Renderer {
+ public:
+  Renderer(RenderQueue* queue, int total_frames)
+      : queue_(queue),
+        total_frames_(total_frames),
+        next_frame_(0),
+        thread_(&Renderer::Run, this, "Renderer") {
+    thread_.Start();
+  }
+  ~Renderer() { thread_.Stop(); }
+
+ private:
+  static bool Run(void* obj) {
+    return static_cast<Renderer*>(obj)->Process();
+  }
+
+  bool Process() {
+    if (PushFrame(queue_, next_frame_))
+      ++next_frame_;
+    return next_frame_ < total_frames_;
+  }
+
+  RenderQueue* const queue_;
+  const int total_frames_;
+  int next_frame_;
+  rtc::PlatformThread thread_;
+};
+
+TEST(RenderQueueTest, StreamsBetweenThreads) {
+  const int kTotalFrames = 20000;
+  RenderQueue queue;
+  queue.Allocate(kNumChannels);
+  Renderer renderer(&queue, kTotalFrames);
+
+  int next_frame = 0;
+  while (next_frame < kTotalFrames) {
+    const RenderQueueItem* item = queue.BeginRead();
+    if (!item)
+      continue;
+    ASSERT_NO_FATAL_FAILURE(ExpectFrame(*item, next_frame++));
+    queue.EndRead();
+  }
+}
+
+}  // namespace
+}  // namespace webrtc
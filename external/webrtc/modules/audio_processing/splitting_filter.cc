@@ -60,11 +60,12 @@ void SplittingFilter::TwoBandsAnalysis(const IFChannelBuffer* data,
                                        IFChannelBuffer* bands) {
   RTC_DCHECK_EQ(static_cast<int>(two_bands_states_.size()),
                 data->num_channels());
+  ChannelBuffer<int16_t>* split = bands->ibuf_for_overwrite();
   for (size_t i = 0; i < two_bands_states_.size(); ++i) {
     WebRtcSpl_AnalysisQMF(data->ibuf_const()->channels()[i],
                           data->num_frames(),
-                          bands->ibuf()->channels(0)[i],
-                          bands->ibuf()->channels(1)[i],
+                          split->channels(0)[i],
+                          split->channels(1)[i],
                           two_bands_states_[i].analysis_state1,
                           two_bands_states_[i].analysis_state2);
   }
@@ -74,11 +75,12 @@ void SplittingFilter::TwoBandsSynthesis(const IFChannelBuffer* bands,
                                         IFChannelBuffer* data) {
   RTC_DCHECK_EQ(static_cast<int>(two_bands_states_.size()),
                 data->num_channels());
+  int16_t* const* merged = data->ibuf_for_overwrite()->channels();
   for (size_t i = 0; i < two_bands_states_.size(); ++i) {
     WebRtcSpl_SynthesisQMF(bands->ibuf_const()->channels(0)[i],
                            bands->ibuf_const()->channels(1)[i],
                            bands->num_frames_per_band(),
-                           data->ibuf()->channels()[i],
+                           merged[i],
                            two_bands_states_[i].synthesis_state1,
                            two_bands_states_[i].synthesis_state2);
   }
@@ -88,10 +90,11 @@ void SplittingFilter::ThreeBandsAnalysis(const IFChannelBuffer* data,
                                          IFChannelBuffer* bands) {
   RTC_DCHECK_EQ(static_cast<int>(three_band_filter_banks_.size()),
                 data->num_channels());
+  ChannelBuffer<float>* split = bands->fbuf_for_overwrite();
   for (size_t i = 0; i < three_band_filter_banks_.size(); ++i) {
     three_band_filter_banks_[i]->Analysis(data->fbuf_const()->channels()[i],
                                           data->num_frames(),
-                                          bands->fbuf()->bands(i));
+                                          split->bands(i));
   }
 }
 
@@ -99,10 +102,11 @@ void SplittingFilter::ThreeBandsSynthesis(const IFChannelBuffer* bands,
                                           IFChannelBuffer* data) {
   RTC_DCHECK_EQ(static_cast<int>(three_band_filter_banks_.size()),
                 data->num_channels());
+  float* const* merged = data->fbuf_for_overwrite()->channels();
   for (size_t i = 0; i < three_band_filter_banks_.size(); ++i) {
     three_band_filter_banks_[i]->Synthesis(bands->fbuf_const()->bands(i),
                                            bands->num_frames_per_band(),
-                                           data->fbuf()->channels()[i]);
+                                           merged[i]);
   }
 }
 
@@ -0,0 +1,217 @@
+/*
+ *  Copyright (c) 2016 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef WEBRTC_MODULES_AUDIO_PROCESSING_SPSC_RING_BUFFER_H_
+#define WEBRTC_MODULES_AUDIO_PROCESSING_SPSC_RING_BUFFER_H_
+
+#include <stddef.h>
+
+#include <algorithm>
+#include <limits>
+
+#include "webrtc/base/atomicops.h"
+#include "webrtc/base/checks.h"
+#include "webrtc/base/constructormagic.h"
+#include "webrtc/base/scoped_ptr.h"
+
+namespace webrtc {
+
+// A lock-free single producer, single consumer ring buffer of items, each
+// made of |item_size| consecutive elements of type T, such as a frame of
+// interleaved audio.
+//
+// One thread may call the producer methods and another thread the consumer
+// methods concurrently, without any further synchronization. Neither side
+// ever blocks; a write which does not fit or a read which is not satisfied
+// is truncated and the caller is told how many items were transferred.
+//
+// Instead of copying, either side may also work directly on the buffer
+// memory: Get{Read,Write}Regions() return up to two contiguous regions,
+// which are released with Consume() and Commit() respectively.
+template <typename T>
+class SpscRingBuffer {
+ public:
+  // Up to two contiguous regions of whole items, in stream order.
+  template <typename U>
+  struct Regions {
+    U* data[2];
+    size_t items[2];
+  };
+
+  SpscRingBuffer(size_t item_size, size_t capacity);
+
+  size_t item_size() const { return item_size_; }
+  size_t capacity() const { return capacity_; }
+
+  // Producer side.
+  size_t WriteItemsAvailable() const;
+  // Returns the writable space for at most |items| items.
+  Regions<T> GetWriteRegions(size_t items);
+  // Publishes |items| items written through GetWriteRegions().
+  void Commit(size_t items);
+  // Copies up to |items| items from |data| and returns the number of items
+  // written.
+  size_t Write(const T* data, size_t items);
+  // Writes up to |items| value-initialized items, such as silence, and
+  // returns the number written.
+  size_t WriteZeros(size_t items);
+
+  // Consumer side.
+  size_t ReadItemsAvailable() const;
+  // Returns the readable data for at most |items| items.
+  Regions<const T> GetReadRegions(size_t items) const;
+  // Releases |items| items read through GetReadRegions().
+  void Consume(size_t items);
+  // Copies up to |items| items to |data| and returns the number of items
+  // read.
+  size_t Read(T* data, size_t items);
+
+  // Empties the buffer. Neither side may be active during the call.
+  void Clear();
+
+  // The storage of all |capacity| + 1 slots, the spare one included, for
+  // preparing the items in place. Neither side may be active meanwhile.
+  size_t num_slots() const { return size_; }
+  T* slot(size_t index) { return buffer_.get() + index * item_size_; }
+
+ private:
+  template <typename U>
+  Regions<U> GetRegions(U* base, size_t position, size_t items) const;
+
+  const size_t item_size_;
+  const size_t capacity_;
+  // One spare slot tells a full buffer from an empty one.
+  const size_t size_;
+  rtc::scoped_ptr<T[]> buffer_;
+  // Slot positions in [0, |size_|). |write_pos_| is only stored by the
+  // producer and |read_pos_| only by the consumer, both with release
+  // semantics, and each side reads the other's position with acquire
+  // semantics.
+  volatile int write_pos_;
+  volatile int read_pos_;
+
+  RTC_DISALLOW_COPY_AND_ASSIGN(SpscRingBuffer);
+};
+
+template <typename T>
+SpscRingBuffer<T>::SpscRingBuffer(size_t item_size, size_t capacity)
+    : item_size_(item_size),
+      capacity_(capacity),
+      size_(capacity + 1),
+      buffer_(new T[size_ * item_size]),
+      write_pos_(0),
+      read_pos_(0) {
+  RTC_CHECK_GT(item_size_, 0u);
+  RTC_CHECK_GT(capacity_, 0u);
+  RTC_CHECK_LT(size_, static_cast<size_t>(std::numeric_limits<int>::max()));
+}
+
+template <typename T>
+size_t SpscRingBuffer<T>::WriteItemsAvailable() const {
+  return capacity_ - ReadItemsAvailable();
+}
+
+template <typename T>
+typename SpscRingBuffer<T>::template Regions<T>
+SpscRingBuffer<T>::GetWriteRegions(size_t items) {
+  items = std::min(items, WriteItemsAvailable());
+  return GetRegions(buffer_.get(), rtc::AtomicOps::AcquireLoad(&write_pos_),
+                    items);
+}
+
+template <typename T>
+void SpscRingBuffer<T>::Commit(size_t items) {
+  RTC_DCHECK_LE(items, WriteItemsAvailable());
+  const size_t position =
+      (rtc::AtomicOps::AcquireLoad(&write_pos_) + items) % size_;
+  rtc::AtomicOps::ReleaseStore(&write_pos_, static_cast<int>(position));
+}
+
+template <typename T>
+size_t SpscRingBuffer<T>::Write(const T* data, size_t items) {
+  const Regions<T> regions = GetWriteRegions(items);
+  const T* const middle = data + regions.items[0] * item_size_;
+  std::copy(data, middle, regions.data[0]);
+  std::copy(middle, middle + regions.items[1] * item_size_, regions.data[1]);
+  const size_t written = regions.items[0] + regions.items[1];
+  Commit(written);
+  return written;
+}
+
+template <typename T>
+size_t SpscRingBuffer<T>::WriteZeros(size_t items) {
+  const Regions<T> regions = GetWriteRegions(items);
+  std::fill(regions.data[0], regions.data[0] + regions.items[0] * item_size_,
+            T());
+  std::fill(regions.data[1], regions.data[1] + regions.items[1] * item_size_,
+            T());
+  const size_t written = regions.items[0] + regions.items[1];
+  Commit(written);
+  return written;
+}
+
+template <typename T>
+size_t SpscRingBuffer<T>::ReadItemsAvailable() const {
+  const size_t write_pos = rtc::AtomicOps::AcquireLoad(&write_pos_);
+  const size_t read_pos = rtc::AtomicOps::AcquireLoad(&read_pos_);
+  return (write_pos + size_ - read_pos) % size_;
+}
+
+template <typename T>
+typename SpscRingBuffer<T>::template Regions<const T>
+SpscRingBuffer<T>::GetReadRegions(size_t items) const {
+  items = std::min(items, ReadItemsAvailable());
+  return GetRegions<const T>(buffer_.get(),
+                             rtc::AtomicOps::AcquireLoad(&read_pos_), items);
+}
+
+template <typename T>
+void SpscRingBuffer<T>::Consume(size_t items) {
+  RTC_DCHECK_LE(items, ReadItemsAvailable());
+  const size_t position =
+      (rtc::AtomicOps::AcquireLoad(&read_pos_) + items) % size_;
+  rtc::AtomicOps::ReleaseStore(&read_pos_, static_cast<int>(position));
+}
+
+template <typename T>
+size_t SpscRingBuffer<T>::Read(T* data, size_t items) {
+  const Regions<const T> regions = GetReadRegions(items);
+  data = std::copy(regions.data[0],
+                   regions.data[0] + regions.items[0] * item_size_, data);
+  std::copy(regions.data[1], regions.data[1] + regions.items[1] * item_size_,
+            data);
+  const size_t read = regions.items[0] + regions.items[1];
+  Consume(read);
+  return read;
+}
+
+template <typename T>
+void SpscRingBuffer<T>::Clear() {
+  rtc::AtomicOps::ReleaseStore(&write_pos_, 0);
+  rtc::AtomicOps::ReleaseStore(&read_pos_, 0);
+}
+
+template <typename T>
+template <typename U>
+typename SpscRingBuffer<T>::template Regions<U> SpscRingBuffer<T>::GetRegions(
+    U* base,
+    size_t position,
+    size_t items) const {
+  Regions<U> regions;
+  regions.data[0] = base + position * item_size_;
+  regions.items[0] = std::min(items, size_ - position);
+  regions.data[1] = base;
+  regions.items[1] = items - regions.items[0];
+  return regions;
+}
+
+}  // namespace webrtc
+
+#endif  // WEBRTC_MODULES_AUDIO_PROCESSING_SPSC_RING_BUFFER_H_
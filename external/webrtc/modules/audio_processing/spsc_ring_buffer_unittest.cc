@@ -0,0 +1,173 @@
+/*
+ *  Copyright (c) 2016 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "webrtc/modules/audio_processing/spsc_ring_buffer.h"
+
+#include <vector>
+
+#include "testing/gtest/include/gtest/gtest.h"
+#include "webrtc/base/platform_thread.h"
+
+namespace webrtc {
+namespace {
+
+const size_t kNumChannels = 2;
+
+// Fills |frames| frames with a ramp starting at |first|, so that every sample
+// identifies its frame and channel.
+void FillRamp(int first, size_t frames, int16_t* interleaved) {
+  for (size_t i = 0; i < frames; ++i) {
+    for (size_t ch = 0; ch < kNumChannels; ++ch) {
+      interleaved[i * kNumChannels + ch] =
+          static_cast<int16_t>((first + i) * kNumChannels + ch);
+    }
+  }
+}
+
+void ExpectRamp(int first, size_t frames, const int16_t* interleaved) {
+  for (size_t i = 0; i < frames * kNumChannels; ++i) {
+    ASSERT_EQ(static_cast<int16_t>(first * kNumChannels + i), interleaved[i])
+        << "at sample " << i;
+  }
+}
+
+TEST(SpscRingBufferTest, WriteAndReadWrapAround) {
+  SpscRingBuffer<int16_t> buffer(kNumChannels, 10);
+  EXPECT_EQ(0u, buffer.ReadItemsAvailable());
+  EXPECT_EQ(10u, buffer.WriteItemsAvailable());
+
+  int16_t in[7 * kNumChannels];
+  int16_t out[7 * kNumChannels];
+  int next_write = 0;
+  int next_read = 0;
+  for (int i = 0; i < 20; ++i) {
+    FillRamp(next_write, 7, in);
+    ASSERT_EQ(7u, buffer.Write(in, 7));
+    next_write += 7;
+    EXPECT_EQ(7u, buffer.ReadItemsAvailable());
+    ASSERT_EQ(7u, buffer.Read(out, 7));
+    ASSERT_NO_FATAL_FAILURE(ExpectRamp(next_read, 7, out));
+    next_read += 7;
+  }
+  EXPECT_EQ(0u, buffer.ReadItemsAvailable());
+}
+
+TEST(SpscRingBufferTest, TruncatesWhenFullOrEmpty) {
+  SpscRingBuffer<int16_t> buffer(kNumChannels, 10);
+  int16_t in[12 * kNumChannels];
+  int16_t out[12 * kNumChannels];
+  FillRamp(0, 12, in);
+  EXPECT_EQ(10u, buffer.Write(in, 12));
+  EXPECT_EQ(0u, buffer.WriteItemsAvailable());
+  EXPECT_EQ(0u, buffer.Write(in, 1));
+  EXPECT_EQ(10u, buffer.Read(out, 12));
+  ExpectRamp(0, 10, out);
+  EXPECT_EQ(0u, buffer.Read(out, 1));
+}
+
+TEST(SpscRingBufferTest, RegionsSplitAtTheEnd) {
+  SpscRingBuffer<int16_t> buffer(kNumChannels, 10);
+  int16_t in[8 * kNumChannels];
+  int16_t out[8 * kNumChannels];
+  FillRamp(0, 8, in);
+  buffer.Write(in, 8);
+  buffer.Read(out, 8);
+
+  // The buffer holds 11 frames internally, so 3 frames fit before the end.
+  SpscRingBuffer<int16_t>::Regions<int16_t> write_regions =
+      buffer.GetWriteRegions(6);
+  EXPECT_EQ(3u, write_regions.items[0]);
+  EXPECT_EQ(3u, write_regions.items[1]);
+  FillRamp(100, 3, write_regions.data[0]);
+  FillRamp(103, 3, write_regions.data[1]);
+  EXPECT_EQ(0u, buffer.ReadItemsAvailable());
+  buffer.Commit(6);
+  EXPECT_EQ(6u, buffer.ReadItemsAvailable());
+
+  SpscRingBuffer<int16_t>::Regions<const int16_t> read_regions =
+      buffer.GetReadRegions(10);
+  EXPECT_EQ(3u, read_regions.items[0]);
+  EXPECT_EQ(3u, read_regions.items[1]);
+  ExpectRamp(100, 3, read_regions.data[0]);
+  ExpectRamp(103, 3, read_regions.data[1]);
+  buffer.Consume(4);
+  EXPECT_EQ(2u, buffer.Read(out, 8));
+  ExpectRamp(104, 2, out);
+}
+
+TEST(SpscRingBufferTest, WriteZerosAndClear) {
+  SpscRingBuffer<int16_t> buffer(kNumChannels, 10);
+  int16_t out[4 * kNumChannels];
+  EXPECT_EQ(4u, buffer.WriteZeros(4));
+  EXPECT_EQ(4u, buffer.Read(out, 4));
+  for (size_t i = 0; i < 4 * kNumChannels; ++i)
+    EXPECT_EQ(0, out[i]);
+
+  buffer.WriteZeros(3);
+  buffer.Clear();
+  EXPECT_EQ(0u, buffer.ReadItemsAvailable());
+  EXPECT_EQ(10u, buffer.WriteItemsAvailable());
+}
+
+// Streams a ramp from a producer thread to the consumer on the test thread,
+// in chunks of different sizes, and checks that it arrives intact.
+class Producer {
+ public:
+  Producer(SpscRingBuffer<int16_t>* buffer, int total_frames)
+      : buffer_(buffer),
+        total_frames_(total_frames),
+        next_frame_(0),
+        thread_(&Producer::Run, this, "Producer") {
+    thread_.Start();
+  }
+  ~Producer() { thread_.Stop(); }
+
+ private:
+  static bool Run(void* obj) {
+    return static_cast<Producer*>(obj)->Process();
+  }
+
+  bool Process() {
+    int16_t in[13 * kNumChannels];
+    const size_t frames = 1 + next_frame_ % 13;
+    FillRamp(next_frame_, frames, in);
+    next_frame_ += static_cast<int>(buffer_->Write(in, frames));
+    return next_frame_ < total_frames_;
+  }
+
+  SpscRingBuffer<int16_t>* const buffer_;
+  const int total_frames_;
+  int next_frame_;
+  rtc::PlatformThread thread_;
+};
+
+TEST(SpscRingBufferTest, StreamsBetweenThreads) {
+  const int kTotalFrames = 100000;
+  SpscRingBuffer<int16_t> buffer(kNumChannels, 64);
+  Producer producer(&buffer, kTotalFrames);
+
+  int next_frame = 0;
+  while (next_frame < kTotalFrames) {
+    const size_t frames = 1 + next_frame % 11;
+    const SpscRingBuffer<int16_t>::Regions<const int16_t> regions =
+        buffer.GetReadRegions(frames);
+    ASSERT_NO_FATAL_FAILURE(
+        ExpectRamp(next_frame, regions.items[0], regions.data[0]));
+    ASSERT_NO_FATAL_FAILURE(ExpectRamp(
+        next_frame + static_cast<int>(regions.items[0]), regions.items[1],
+        regions.data[1]));
+    const size_t read = regions.items[0] + regions.items[1];
+    buffer.Consume(read);
+    next_frame += static_cast<int>(read);
+  }
+}
+
+}  // namespace
+}  // namespace webrtc
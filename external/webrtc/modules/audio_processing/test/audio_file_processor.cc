@@ -56,7 +56,7 @@ bool WavFileProcessor::ProcessChunk() {
     return false;
   }
   {
-    const auto st = ScopedTimer(mutable_proc_time());
+    const auto st = ScopedTimer(mutable_proc_time(), mutable_times());
     RTC_CHECK_EQ(kNoErr,
                  ap_->ProcessStream(in_buf_.channels(), input_config_,
                                     output_config_, out_buf_.channels()));
@@ -65,6 +65,69 @@ bool WavFileProcessor::ProcessChunk() {
   return true;
 }
 
+InMemoryProcessor::InMemoryProcessor(scoped_ptr<AudioProcessing> ap,
+                                     int sample_rate_hz,
+                                     const ChannelBuffer<float>* capture,
+                                     const ChannelBuffer<float>* reverse,
+                                     int num_output_channels,
+                                     int stream_delay_ms)
+    : ap_(ap.Pass()),
+      capture_(capture),
+      reverse_(reverse),
+      capture_config_(sample_rate_hz, capture->num_channels()),
+      reverse_config_(sample_rate_hz, reverse ? reverse->num_channels() : 1),
+      output_config_(sample_rate_hz, num_output_channels),
+      stream_delay_ms_(stream_delay_ms),
+      next_frame_(0),
+      analog_level_(127),
+      capture_chunk_(capture->num_channels()),
+      reverse_chunk_(reverse ? reverse->num_channels() : 0),
+      out_buf_(output_config_.num_frames(), num_output_channels),
+      reverse_out_buf_(reverse_config_.num_frames(),
+                       reverse_config_.num_channels()) {
+  RTC_CHECK(!reverse_ || reverse_->num_frames() >= capture_->num_frames());
+  const ProcessingConfig config = {
+      {capture_config_, output_config_, reverse_config_, reverse_config_}};
+  RTC_CHECK_EQ(kNoErr, ap_->Initialize(config));
+}
+
+bool InMemoryProcessor::ProcessChunk() {
+  const size_t chunk_frames = capture_config_.num_frames();
+  if (next_frame_ + chunk_frames > capture_->num_frames()) {
+    return false;
+  }
+  for (size_t i = 0; i < capture_chunk_.size(); ++i) {
+    capture_chunk_[i] = capture_->channels()[i] + next_frame_;
+  }
+  for (size_t i = 0; i < reverse_chunk_.size(); ++i) {
+    reverse_chunk_[i] = reverse_->channels()[i] + next_frame_;
+  }
+  next_frame_ += chunk_frames;
+
+  GainControl* gain_control = ap_->gain_control();
+  const bool analog_agc = gain_control->is_enabled() &&
+                          gain_control->mode() == GainControl::kAdaptiveAnalog;
+  {
+    const auto st = ScopedTimer(mutable_proc_time(), mutable_times());
+    if (reverse_) {
+      RTC_CHECK_EQ(kNoErr, ap_->ProcessReverseStream(
+                               &reverse_chunk_[0], reverse_config_,
+                               reverse_config_, reverse_out_buf_.channels()));
+    }
+    RTC_CHECK_EQ(kNoErr, ap_->set_stream_delay_ms(stream_delay_ms_));
+    if (analog_agc) {
+      RTC_CHECK_EQ(kNoErr, gain_control->set_stream_analog_level(analog_level_));
+    }
+    RTC_CHECK_EQ(kNoErr,
+                 ap_->ProcessStream(&capture_chunk_[0], capture_config_,
+                                    output_config_, out_buf_.channels()));
+    if (analog_agc) {
+      analog_level_ = gain_control->stream_analog_level();
+    }
+  }
+  return true;
+}
+
 AecDumpFileProcessor::AecDumpFileProcessor(scoped_ptr<AudioProcessing> ap,
                                            FILE* dump_file,
                                            scoped_ptr<WavWriter> out_file)
@@ -140,7 +203,7 @@ void AecDumpFileProcessor::HandleMessage(const Stream& msg) {
                 msg.input_channel(i).size());
   }
   {
-    const auto st = ScopedTimer(mutable_proc_time());
+    const auto st = ScopedTimer(mutable_proc_time(), mutable_times());
     RTC_CHECK_EQ(kNoErr, ap_->set_stream_delay_ms(msg.delay()));
     ap_->echo_cancellation()->set_stream_drift_samples(msg.drift());
     if (msg.has_keypress()) {
@@ -165,7 +228,7 @@ void AecDumpFileProcessor::HandleMessage(const ReverseStream& msg) {
                 msg.channel(i).size());
   }
   {
-    const auto st = ScopedTimer(mutable_proc_time());
+    const auto st = ScopedTimer(mutable_proc_time(), mutable_times());
     // TODO(ajm): This currently discards the processed output, which is needed
     // for e.g. intelligibility enhancement.
     RTC_CHECK_EQ(kNoErr, ap_->ProcessReverseStream(
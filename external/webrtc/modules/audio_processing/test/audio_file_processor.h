@@ -44,6 +44,7 @@ class AudioFileProcessor {
  public:
   static const int kChunksPerSecond = 1000 / AudioProcessing::kChunkSizeMs;
 
+  AudioFileProcessor() : record_times_(false) {}
   virtual ~AudioFileProcessor() {}
 
   // Processes one AudioProcessing::kChunkSizeMs of data from the input file and
@@ -53,31 +54,51 @@ class AudioFileProcessor {
   // Returns the execution time of all AudioProcessing calls.
   const TickIntervalStats& proc_time() const { return proc_time_; }
 
+  // If |record| is true, the execution time of every timed section is also
+  // kept, as needed for percentiles. A section is one chunk, except for
+  // aecdump files where the reverse and the capture calls are timed apart.
+  void set_record_times(bool record) { record_times_ = record; }
+  const std::vector<TickInterval>& times() const { return times_; }
+  // Makes room for the times of |num_sections| sections up front, so that
+  // recording them does not allocate while processing.
+  void reserve_times(size_t num_sections) { times_.reserve(num_sections); }
+
  protected:
   // RAII class for execution time measurement. Updates the provided
   // TickIntervalStats based on the time between ScopedTimer creation and
   // leaving the enclosing scope.
   class ScopedTimer {
    public:
-    explicit ScopedTimer(TickIntervalStats* proc_time)
-        : proc_time_(proc_time), start_time_(TickTime::Now()) {}
+    explicit ScopedTimer(TickIntervalStats* proc_time,
+                         std::vector<TickInterval>* times = nullptr)
+        : proc_time_(proc_time), times_(times), start_time_(TickTime::Now()) {}
 
     ~ScopedTimer() {
       TickInterval interval = TickTime::Now() - start_time_;
       proc_time_->sum += interval;
       proc_time_->max = std::max(proc_time_->max, interval);
       proc_time_->min = std::min(proc_time_->min, interval);
+      if (times_) {
+        times_->push_back(interval);
+      }
     }
 
    private:
     TickIntervalStats* const proc_time_;
+    std::vector<TickInterval>* const times_;
     TickTime start_time_;
   };
 
   TickIntervalStats* mutable_proc_time() { return &proc_time_; }
+  // Returns null unless the times are recorded.
+  std::vector<TickInterval>* mutable_times() {
+    return record_times_ ? &times_ : nullptr;
+  }
 
  private:
   TickIntervalStats proc_time_;
+  bool record_times_;
+  std::vector<TickInterval> times_;
 };
 
 // Used to read from and write to WavFile objects.
@@ -103,6 +124,46 @@ class WavFileProcessor final : public AudioFileProcessor {
   ChannelBufferWavWriter buffer_writer_;
 };
 
+// Used to process audio held in memory, for benchmarking without any file
+// access between the timed chunks. Before each capture chunk, the matching
+// chunk of the reverse stream, if any, is passed to ProcessReverseStream();
+// the timing covers both. The processed audio is discarded.
+class InMemoryProcessor final : public AudioFileProcessor {
+ public:
+  // Takes ownership of |ap| only. |capture| and the optional |reverse| are
+  // not modified, so they may be shared between processors, and hold the
+  // whole streams at |sample_rate_hz|. The reverse stream must be at least as
+  // long as the capture stream.
+  InMemoryProcessor(rtc::scoped_ptr<AudioProcessing> ap,
+                    int sample_rate_hz,
+                    const ChannelBuffer<float>* capture,
+                    const ChannelBuffer<float>* reverse,
+                    int num_output_channels,
+                    int stream_delay_ms);
+  virtual ~InMemoryProcessor() {}
+
+  // Processes the next chunk of the capture stream.
+  bool ProcessChunk() override;
+
+ private:
+  rtc::scoped_ptr<AudioProcessing> ap_;
+
+  const ChannelBuffer<float>* const capture_;
+  const ChannelBuffer<float>* const reverse_;
+  const StreamConfig capture_config_;
+  const StreamConfig reverse_config_;
+  const StreamConfig output_config_;
+  const int stream_delay_ms_;
+  size_t next_frame_;
+  int analog_level_;
+
+  // Pointers to the current chunk of each channel.
+  std::vector<const float*> capture_chunk_;
+  std::vector<const float*> reverse_chunk_;
+  ChannelBuffer<float> out_buf_;
+  ChannelBuffer<float> reverse_out_buf_;
+};
+
 // Used to read from an aecdump file and write to a WavWriter.
 class AecDumpFileProcessor final : public AudioFileProcessor {
  public:
@@ -0,0 +1,641 @@
+/*
+ *  Copyright (c) 2016 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#if defined(WEBRTC_LINUX) || defined(WEBRTC_ANDROID)
+#include <malloc.h>
+// mallinfo() is deprecated since glibc 2.33, and its int fields wrap above
+// 2 GiB.
+#if defined(__GLIBC_PREREQ)
+#if __GLIBC_PREREQ(2, 33)
+#define HAVE_MALLINFO2
+#endif
+#endif
+#endif
+#if defined(WEBRTC_POSIX)
+#include <sys/resource.h>
+#endif
+
+#include "gflags/gflags.h"
+#include "webrtc/base/checks.h"
+#include "webrtc/base/event.h"
+#include "webrtc/base/platform_thread.h"
+#include "webrtc/base/scoped_ptr.h"
+#include "webrtc/base/stringencode.h"
+#include "webrtc/common_audio/channel_buffer.h"
+#include "webrtc/common_audio/include/audio_util.h"
+#include "webrtc/common_audio/resampler/include/push_resampler.h"
+#include "webrtc/common_audio/wav_file.h"
+#include "webrtc/modules/audio_processing/beamformer/nonlinear_beamformer.h"
+#include "webrtc/modules/audio_processing/include/audio_processing.h"
+#include "webrtc/modules/audio_processing/test/audio_file_processor.h"
+#include "webrtc/modules/audio_processing/test/test_utils.h"
+#include "webrtc/system_wrappers/include/cpu_info.h"
+#include "webrtc/system_wrappers/include/tick_util.h"
+
+DEFINE_string(i, "", "Capture WAV file. A synthetic capture stream is used "
+                     "if empty.");
+DEFINE_string(reverse, "", "Render WAV file. A synthetic render stream is "
+                           "used if empty.");
+DEFINE_double(seconds, 10, "Length of the synthetic streams in seconds.");
+DEFINE_int32(delay_ms, 40, "Echo path delay of the synthetic streams, also "
+                           "reported as the stream delay.");
+DEFINE_string(o, "", "File to write the results to. Defaults to stdout.");
+
+DEFINE_string(aec, "off,normal,extended,delay_agnostic",
+              "Echo cancellation modes to sweep: off, normal, extended, "
+              "delay_agnostic.");
+DEFINE_string(ns, "off,moderate",
+              "Noise suppression levels to sweep: off, low, moderate, high, "
+              "very_high.");
+DEFINE_string(agc, "off,adaptive_digital",
+              "Gain control modes to sweep: off, adaptive_analog, "
+              "adaptive_digital, fixed_digital.");
+DEFINE_string(bf, "off", "Beamformer settings to sweep: off, on. The "
+                         "beamformer is skipped for mono capture.");
+DEFINE_int32(bf_fft_size, 256,
+             "The FFT size of the beamformer, a power of two in [128, 1024].");
+DEFINE_string(rates, "8000,16000,32000,48000", "Sample rates to sweep.");
+DEFINE_string(channels, "1", "Capture channel counts to sweep.");
+DEFINE_int32(parallel, 1,
+             "Number of independent streams to run concurrently for each "
+             "configuration, or 0 for one per core. Above 1, each "
+             "configuration is also run alone to measure the scaling.");
+
+namespace webrtc {
+namespace {
+
+const char kUsage[] =
+    "Benchmarks audio processing over a sweep of configurations. For every\n"
+    "combination of the swept settings, the capture stream, and the render\n"
+    "stream for the echo control, are processed as fast as possible and one\n"
+    "JSON object per line is written with:\n"
+    "  rtf: processing time over stream duration, per stream,\n"
+    "  p50_us, p99_us, max_us: processing time per 10 ms chunk,\n"
+    "  heap_bytes: heap held by the processing of each stream after\n"
+    "      processing, not counting the benchmark's own buffers; the\n"
+    "      processing allocates its buffers on initialization, so this\n"
+    "      approximates its peak,\n"
+    "  peak_rss_kb: peak resident size of the whole process so far.\n"
+    "Parallel runs add the wall clock time, the throughput in stream seconds\n"
+    "per second and the scaling, i.e. the throughput over that of a single\n"
+    "stream times the number of streams.";
+
+const float kArraySpacingMeters = 0.05f;
+const float kRenderLevel = 0.1f;
+const float kEchoGain = 0.3f;
+const float kNearEndLevel = 0.05f;
+const float kNoiseLevel = 0.003f;
+
+struct NamedValue {
+  const char* name;
+  int value;
+};
+
+const NamedValue kNsLevels[] = {
+    {"low", NoiseSuppression::kLow},
+    {"moderate", NoiseSuppression::kModerate},
+    {"high", NoiseSuppression::kHigh},
+    {"very_high", NoiseSuppression::kVeryHigh},
+};
+
+const NamedValue kAgcModes[] = {
+    {"adaptive_analog", GainControl::kAdaptiveAnalog},
+    {"adaptive_digital", GainControl::kAdaptiveDigital},
+    {"fixed_digital", GainControl::kFixedDigital},
+};
+
+template <size_t N>
+bool Lookup(const NamedValue (&values)[N], const std::string& name,
+            int* value) {
+  for (size_t i = 0; i < N; ++i) {
+    if (name == values[i].name) {
+      *value = values[i].value;
+      return true;
+    }
+  }
+  return false;
+}
+
+struct BenchConfig {
+  std::string aec;
+  std::string ns;
+  std::string agc;
+  bool bf;
+  int sample_rate_hz;
+  int num_channels;
+};
+
+struct BenchResult {
+  BenchResult()
+      : num_streams(0),
+        num_chunks(0),
+        proc_s(0),
+        wall_s(0),
+        p50_us(0),
+        p99_us(0),
+        max_us(0),
+        heap_bytes(-1),
+        peak_rss_kb(-1) {}
+
+  int num_streams;
+  size_t num_chunks;
+  // Mean processing time per stream.
+  double proc_s;
+  double wall_s;
+  int64_t p50_us;
+  int64_t p99_us;
+  int64_t max_us;
+  int64_t heap_bytes;
+  int64_t peak_rss_kb;
+};
+
+std::vector<std::string> SplitList(const std::string& list) {
+  std::vector<std::string> fields;
+  rtc::split(list, ',', &fields);
+  return fields;
+}
+
+bool ParseIntList(const std::string& list, std::vector<int>* values) {
+  for (const std::string& field : SplitList(list)) {
+    int value = 0;
+    if (sscanf(field.c_str(), "%d", &value) != 1 || value <= 0) {
+      return false;
+    }
+    values->push_back(value);
+  }
+  return !values->empty();
+}
+
+// Returns the bytes currently allocated on the heap, or -1 if unknown.
+int64_t HeapBytes() {
+#if defined(HAVE_MALLINFO2)
+  const struct mallinfo2 info = mallinfo2();
+  return static_cast<int64_t>(info.uordblks + info.hblkhd);
+#elif defined(WEBRTC_LINUX) || defined(WEBRTC_ANDROID)
+  const struct mallinfo info = mallinfo();
+  return static_cast<int64_t>(info.uordblks) + info.hblkhd;
+#else
+  return -1;
+#endif
+}
+
+// Returns the peak resident set size of the process, or -1 if unknown.
+int64_t PeakRssKb() {
+#if defined(WEBRTC_POSIX)
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0) {
+    return -1;
+  }
+#if defined(WEBRTC_MAC)
+  return usage.ru_maxrss / 1024;
+#else
+  return usage.ru_maxrss;
+#endif
+#else
+  return -1;
+#endif
+}
+
+// A deterministic white noise source, uniform in [-1, 1).
+class NoiseGenerator {
+ public:
+  explicit NoiseGenerator(uint32_t seed) : state_(seed) {}
+
+  float Next() {
+    state_ = state_ * 1664525u + 1013904223u;
+    return static_cast<int32_t>(state_) / 2147483648.f;
+  }
+
+ private:
+  uint32_t state_;
+};
+
+// Fills |reverse| with white noise and every channel of |capture| with its
+// echo, delayed by |delay_ms|, plus a near-end tone and noise. The near-end
+// talker is active during every other second, so that the echo control sees
+// both single and double talk.
+void GenerateStreams(int sample_rate_hz,
+                     int delay_ms,
+                     ChannelBuffer<float>* capture,
+                     ChannelBuffer<float>* reverse) {
+  NoiseGenerator noise(1);
+  float* const render = reverse->channels()[0];
+  for (size_t i = 0; i < reverse->num_frames(); ++i) {
+    render[i] = kRenderLevel * noise.Next();
+  }
+  const size_t delay_frames =
+      static_cast<size_t>(sample_rate_hz) * delay_ms / 1000;
+  for (int ch = 0; ch < capture->num_channels(); ++ch) {
+    float* const mic = capture->channels()[ch];
+    for (size_t i = 0; i < capture->num_frames(); ++i) {
+      const float echo =
+          i >= delay_frames ? kEchoGain * render[i - delay_frames] : 0.f;
+      const bool near_end_active = (i / sample_rate_hz) % 2 == 1;
+      const float near_end =
+          near_end_active
+              ? kNearEndLevel * sinf(2.f * static_cast<float>(M_PI) * 300.f *
+                                     i / sample_rate_hz)
+              : 0.f;
+      mic[i] = echo + near_end + kNoiseLevel * noise.Next();
+    }
+  }
+}
+
+// Reads |filename| and resamples it to |sample_rate_hz| in 10 ms chunks.
+// Channel i of the returned stream is channel i modulo the file's channels.
+rtc::scoped_ptr<ChannelBuffer<float>> ReadStream(const std::string& filename,
+                                                 int sample_rate_hz,
+                                                 int num_channels) {
+  WavReader reader(filename);
+  const int file_channels = reader.num_channels();
+  const size_t file_chunk_frames =
+      static_cast<size_t>(reader.sample_rate() / 100);
+  const size_t chunk_frames = static_cast<size_t>(sample_rate_hz / 100);
+  const size_t num_chunks =
+      reader.num_samples() / file_channels / file_chunk_frames;
+
+  std::vector<float> interleaved(reader.num_samples());
+  RTC_CHECK_EQ(interleaved.size(),
+               reader.ReadSamples(interleaved.size(), &interleaved[0]));
+  FloatS16ToFloat(&interleaved[0], interleaved.size(), &interleaved[0]);
+
+  rtc::scoped_ptr<ChannelBuffer<float>> stream(
+      new ChannelBuffer<float>(num_chunks * chunk_frames, num_channels));
+  std::vector<float> file_chunk(file_chunk_frames);
+  for (int ch = 0; ch < num_channels; ++ch) {
+    const int file_ch = ch % file_channels;
+    PushResampler<float> resampler;
+    RTC_CHECK_EQ(0, resampler.InitializeIfNeeded(reader.sample_rate(),
+                                                 sample_rate_hz, 1));
+    for (size_t chunk = 0; chunk < num_chunks; ++chunk) {
+      for (size_t i = 0; i < file_chunk_frames; ++i) {
+        file_chunk[i] = interleaved[(chunk * file_chunk_frames + i) *
+                                        file_channels + file_ch];
+      }
+      RTC_CHECK_EQ(static_cast<int>(chunk_frames),
+                   resampler.Resample(&file_chunk[0], file_chunk_frames,
+                                      stream->channels()[ch] +
+                                          chunk * chunk_frames,
+                                      chunk_frames));
+    }
+  }
+  return stream;
+}
+
+AudioProcessing* CreateApm(const BenchConfig& config) {
+  Config apm_config;
+  apm_config.Set<ExtendedFilter>(new ExtendedFilter(config.aec == "extended"));
+  apm_config.Set<DelayAgnostic>(
+      new DelayAgnostic(config.aec == "delay_agnostic"));
+  if (config.bf) {
+    std::vector<Point> array_geometry;
+    for (int i = 0; i < config.num_channels; ++i) {
+      array_geometry.push_back(Point(i * kArraySpacingMeters, 0.f, 0.f));
+    }
+    apm_config.Set<Beamforming>(new Beamforming(
+        true, array_geometry,
+        SphericalPointf(static_cast<float>(M_PI) / 2.f, 0.f, 1.f),
+        FLAGS_bf_fft_size));
+  }
+  AudioProcessing* ap = AudioProcessing::Create(apm_config);
+  if (!ap) {
+    fprintf(stderr, "Could not create AudioProcessing for aec=%s ns=%s "
+                    "agc=%s bf=%s at %d Hz with %d channels.\n",
+            config.aec.c_str(), config.ns.c_str(), config.agc.c_str(),
+            config.bf ? "on" : "off", config.sample_rate_hz,
+            config.num_channels);
+    exit(1);
+  }
+
+  RTC_CHECK_EQ(kNoErr, ap->echo_cancellation()->Enable(config.aec != "off"));
+  int value = 0;
+  if (Lookup(kNsLevels, config.ns, &value)) {
+    RTC_CHECK_EQ(kNoErr, ap->noise_suppression()->Enable(true));
+    RTC_CHECK_EQ(kNoErr, ap->noise_suppression()->set_level(
+                             static_cast<NoiseSuppression::Level>(value)));
+  }
+  if (Lookup(kAgcModes, config.agc, &value)) {
+    RTC_CHECK_EQ(kNoErr, ap->gain_control()->Enable(true));
+    RTC_CHECK_EQ(kNoErr, ap->gain_control()->set_mode(
+                             static_cast<GainControl::Mode>(value)));
+  }
+  return ap;
+}
+
+// Processes a stream to its end on its own thread, once |start| is set.
+class StreamThread {
+ public:
+  StreamThread(AudioFileProcessor* processor, rtc::Event* start)
+      : processor_(processor),
+        start_(start),
+        thread_(&StreamThread::Run, this, "StreamThread") {
+    thread_.Start();
+  }
+  ~StreamThread() { Join(); }
+
+  void Join() { thread_.Stop(); }
+
+ private:
+  static bool Run(void* obj) {
+    static_cast<StreamThread*>(obj)->Process();
+    return false;
+  }
+
+  void Process() {
+    start_->Wait(rtc::Event::kForever);
+    while (processor_->ProcessChunk()) {
+    }
+  }
+
+  AudioFileProcessor* const processor_;
+  rtc::Event* const start_;
+  rtc::PlatformThread thread_;
+};
+
+int64_t Percentile(std::vector<int64_t>* values, double percentile) {
+  const size_t index = std::min(
+      values->size() - 1, static_cast<size_t>(percentile * values->size()));
+  std::nth_element(values->begin(), values->begin() + index, values->end());
+  return (*values)[index];
+}
+
+BenchResult Run(const BenchConfig& config,
+                const ChannelBuffer<float>& capture,
+                const ChannelBuffer<float>& reverse,
+                int num_streams) {
+  BenchResult result;
+  result.num_streams = num_streams;
+
+  // Only the heap of the APM instances is counted, while they are created
+  // and while they run. The processors which feed them, and the chunk times
+  // they record, are set up in between.
+  const int64_t heap_before = HeapBytes();
+  std::vector<rtc::scoped_ptr<AudioProcessing>> aps;
+  for (int i = 0; i < num_streams; ++i) {
+    aps.push_back(rtc::scoped_ptr<AudioProcessing>(CreateApm(config)));
+  }
+  const int64_t heap_created = HeapBytes();
+
+  const size_t num_chunks =
+      capture.num_frames() /
+      (config.sample_rate_hz / AudioFileProcessor::kChunksPerSecond);
+  std::vector<rtc::scoped_ptr<InMemoryProcessor>> processors;
+  for (int i = 0; i < num_streams; ++i) {
+    processors.push_back(rtc::scoped_ptr<InMemoryProcessor>(
+        new InMemoryProcessor(aps[i].Pass(), config.sample_rate_hz, &capture,
+                              &reverse, config.bf ? 1 : config.num_channels,
+                              FLAGS_delay_ms)));
+    processors.back()->set_record_times(true);
+    processors.back()->reserve_times(num_chunks);
+  }
+  const int64_t heap_started = HeapBytes();
+
+  const TickTime start_time = TickTime::Now();
+  if (num_streams == 1) {
+    while (processors[0]->ProcessChunk()) {
+    }
+  } else {
+    rtc::Event start(true, false);
+    std::vector<rtc::scoped_ptr<StreamThread>> threads;
+    for (int i = 0; i < num_streams; ++i) {
+      threads.push_back(rtc::scoped_ptr<StreamThread>(
+          new StreamThread(processors[i].get(), &start)));
+    }
+    start.Set();
+    for (int i = 0; i < num_streams; ++i) {
+      threads[i]->Join();
+    }
+  }
+  result.wall_s = (TickTime::Now() - start_time).Microseconds() * 1e-6;
+
+  const int64_t heap_after = HeapBytes();
+  if (heap_before >= 0 && heap_after >= 0) {
+    result.heap_bytes =
+        ((heap_created - heap_before) + (heap_after - heap_started)) /
+        num_streams;
+  }
+  result.peak_rss_kb = PeakRssKb();
+
+  std::vector<int64_t> times_us;
+  for (int i = 0; i < num_streams; ++i) {
+    const AudioFileProcessor& processor = *processors[i];
+    result.proc_s += processor.proc_time().sum.Microseconds() * 1e-6;
+    for (const TickInterval& time : processor.times()) {
+      times_us.push_back(time.Microseconds());
+    }
+  }
+  result.proc_s /= num_streams;
+  result.num_chunks = times_us.size() / num_streams;
+  if (!times_us.empty()) {
+    result.p50_us = Percentile(&times_us, 0.5);
+    result.p99_us = Percentile(&times_us, 0.99);
+    result.max_us = *std::max_element(times_us.begin(), times_us.end());
+  }
+  return result;
+}
+
+void WriteResult(FILE* file,
+                 const BenchConfig& config,
+                 const BenchResult& result,
+                 const BenchResult* single_result) {
+  const double audio_s =
+      result.num_chunks * 1.0 / AudioFileProcessor::kChunksPerSecond;
+  fprintf(file,
+          "{\"aec\": \"%s\", \"ns\": \"%s\", \"agc\": \"%s\", \"bf\": %s, "
+          "\"sample_rate_hz\": %d, \"num_channels\": %d, \"streams\": %d, "
+          "\"audio_s\": %.2f, \"proc_s\": %.6f, \"rtf\": %.6f, "
+          "\"p50_us\": %lld, \"p99_us\": %lld, \"max_us\": %lld, "
+          "\"heap_bytes\": %lld, \"peak_rss_kb\": %lld",
+          config.aec.c_str(), config.ns.c_str(), config.agc.c_str(),
+          config.bf ? "true" : "false", config.sample_rate_hz,
+          config.num_channels, result.num_streams, audio_s, result.proc_s,
+          audio_s > 0 ? result.proc_s / audio_s : 0,
+          static_cast<long long>(result.p50_us),
+          static_cast<long long>(result.p99_us),
+          static_cast<long long>(result.max_us),
+          static_cast<long long>(result.heap_bytes),
+          static_cast<long long>(result.peak_rss_kb));
+  if (single_result) {
+    const double throughput =
+        result.wall_s > 0 ? result.num_streams * audio_s / result.wall_s : 0;
+    const double single_throughput =
+        single_result->wall_s > 0 ? audio_s / single_result->wall_s : 0;
+    fprintf(file,
+            ", \"wall_s\": %.6f, \"throughput\": %.3f, \"scaling\": %.3f",
+            result.wall_s, throughput,
+            single_throughput > 0
+                ? throughput / (result.num_streams * single_throughput)
+                : 0);
+  }
+  fprintf(file, "}\n");
+  fflush(file);
+}
+
+bool ValidateNames(const std::vector<std::string>& names,
+                   const char* flag,
+                   bool (*valid)(const std::string&)) {
+  for (const std::string& name : names) {
+    if (!valid(name)) {
+      fprintf(stderr, "Invalid -%s value: %s\n", flag, name.c_str());
+      return false;
+    }
+  }
+  return !names.empty();
+}
+
+bool IsAecMode(const std::string& name) {
+  return name == "off" || name == "normal" || name == "extended" ||
+         name == "delay_agnostic";
+}
+
+bool IsNsLevel(const std::string& name) {
+  int value = 0;
+  return name == "off" || Lookup(kNsLevels, name, &value);
+}
+
+bool IsAgcMode(const std::string& name) {
+  int value = 0;
+  return name == "off" || Lookup(kAgcModes, name, &value);
+}
+
+bool IsOnOff(const std::string& name) {
+  return name == "off" || name == "on";
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  google::SetUsageMessage(kUsage);
+  google::ParseCommandLineFlags(&argc, &argv, true);
+
+  const std::vector<std::string> aec_modes = SplitList(FLAGS_aec);
+  const std::vector<std::string> ns_levels = SplitList(FLAGS_ns);
+  const std::vector<std::string> agc_modes = SplitList(FLAGS_agc);
+  const std::vector<std::string> bf_settings = SplitList(FLAGS_bf);
+  std::vector<int> rates;
+  std::vector<int> channel_counts;
+  if (!ValidateNames(aec_modes, "aec", &IsAecMode) ||
+      !ValidateNames(ns_levels, "ns", &IsNsLevel) ||
+      !ValidateNames(agc_modes, "agc", &IsAgcMode) ||
+      !ValidateNames(bf_settings, "bf", &IsOnOff)) {
+    return 1;
+  }
+  if (!ParseIntList(FLAGS_rates, &rates) ||
+      !ParseIntList(FLAGS_channels, &channel_counts)) {
+    fprintf(stderr, "-rates and -channels must be lists of positive "
+                    "integers.\n");
+    return 1;
+  }
+  for (int rate : rates) {
+    if (rate % AudioFileProcessor::kChunksPerSecond != 0) {
+      fprintf(stderr, "Unsupported sample rate: %d\n", rate);
+      return 1;
+    }
+  }
+  if (!NonlinearBeamformer::IsValidFftSize(FLAGS_bf_fft_size)) {
+    fprintf(stderr, "-bf_fft_size must be a power of two in [128, 1024].\n");
+    return 1;
+  }
+  // AudioProcessing clamps other delays and reports them with
+  // kBadStreamParameterWarning, which the processors treat as fatal.
+  if (FLAGS_delay_ms < 0 || FLAGS_delay_ms > 500) {
+    fprintf(stderr, "-delay_ms must be in [0, 500].\n");
+    return 1;
+  }
+  if (FLAGS_parallel < 0 || FLAGS_seconds <= 0) {
+    fprintf(stderr, "-parallel must be >= 0 and -seconds > 0.\n");
+    return 1;
+  }
+  const int num_streams =
+      FLAGS_parallel == 0 ? static_cast<int>(CpuInfo::DetectNumberOfCores())
+                          : FLAGS_parallel;
+
+  FILE* out_file = stdout;
+  if (!FLAGS_o.empty()) {
+    out_file = fopen(FLAGS_o.c_str(), "w");
+    if (!out_file) {
+      fprintf(stderr, "Could not open %s\n", FLAGS_o.c_str());
+      return 1;
+    }
+  }
+
+  for (int rate : rates) {
+    for (int channels : channel_counts) {
+      // Prepare the streams once per format; they are shared by all the
+      // configurations and streams.
+      const size_t num_frames =
+          static_cast<size_t>(FLAGS_seconds * AudioFileProcessor::
+                                                  kChunksPerSecond) *
+          (rate / AudioFileProcessor::kChunksPerSecond);
+      rtc::scoped_ptr<ChannelBuffer<float>> capture(
+          new ChannelBuffer<float>(num_frames, channels));
+      rtc::scoped_ptr<ChannelBuffer<float>> reverse(
+          new ChannelBuffer<float>(num_frames, 1));
+      GenerateStreams(rate, FLAGS_delay_ms, capture.get(), reverse.get());
+      if (!FLAGS_i.empty()) {
+        capture = ReadStream(FLAGS_i, rate, channels);
+      }
+      if (!FLAGS_reverse.empty()) {
+        reverse = ReadStream(FLAGS_reverse, rate, 1);
+      }
+      if (reverse->num_frames() < capture->num_frames()) {
+        fprintf(stderr, "The render stream is shorter than the capture "
+                        "stream.\n");
+        return 1;
+      }
+
+      for (const std::string& aec : aec_modes) {
+        for (const std::string& ns : ns_levels) {
+          for (const std::string& agc : agc_modes) {
+            for (const std::string& bf : bf_settings) {
+              BenchConfig config;
+              config.aec = aec;
+              config.ns = ns;
+              config.agc = agc;
+              config.bf = bf == "on";
+              config.sample_rate_hz = rate;
+              config.num_channels = channels;
+              if (config.bf && channels < 2) {
+                continue;
+              }
+
+              const BenchResult single = Run(config, *capture, *reverse, 1);
+              WriteResult(out_file, config, single, nullptr);
+              if (num_streams > 1) {
+                const BenchResult parallel =
+                    Run(config, *capture, *reverse, num_streams);
+                WriteResult(out_file, config, parallel, &single);
+              }
+            }
+          }
+        }
+      }
+    }
+  }
+
+  if (out_file != stdout) {
+    fclose(out_file);
+  }
+  return 0;
+}
+
+}  // namespace webrtc
+
+int main(int argc, char* argv[]) {
+  return webrtc::main(argc, argv);
+}
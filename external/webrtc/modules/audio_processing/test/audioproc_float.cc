@@ -18,6 +18,7 @@
 #include "webrtc/base/scoped_ptr.h"
 #include "webrtc/common_audio/channel_buffer.h"
 #include "webrtc/common_audio/wav_file.h"
+#include "webrtc/modules/audio_processing/beamformer/nonlinear_beamformer.h"
 #include "webrtc/modules/audio_processing/include/audio_processing.h"
 #include "webrtc/modules/audio_processing/test/audio_file_processor.h"
 #include "webrtc/modules/audio_processing/test/protobuf_utils.h"
@@ -41,6 +42,10 @@ DEFINE_double(
     target_angle_degrees,
     90,
     "The azimuth of the target in degrees. Only applies to beamforming.");
+DEFINE_int32(bf_fft_size,
+             256,
+             "The FFT size of the beamformer, a power of two in [128, 1024]. "
+             "Only applies to beamforming.");
 
 DEFINE_bool(aec, false, "Enable echo cancellation.");
 DEFINE_bool(agc, false, "Enable automatic gain control.");
@@ -95,10 +100,16 @@ int main(int argc, char* argv[]) {
       fprintf(stderr, "-mic_positions must be specified when -bf is used.\n");
       return 1;
     }
+    if (!NonlinearBeamformer::IsValidFftSize(FLAGS_bf_fft_size)) {
+      fprintf(stderr,
+              "-bf_fft_size must be a power of two in [128, 1024].\n");
+      return 1;
+    }
     config.Set<Beamforming>(new Beamforming(
         true, ParseArrayGeometry(FLAGS_mic_positions),
         SphericalPointf(DegreesToRadians(FLAGS_target_angle_degrees), 0.f,
-                        1.f)));
+                        1.f),
+        FLAGS_bf_fft_size));
   }
   config.Set<ExperimentalNs>(new ExperimentalNs(FLAGS_ts || FLAGS_all));
   config.Set<Intelligibility>(new Intelligibility(FLAGS_ie || FLAGS_all));
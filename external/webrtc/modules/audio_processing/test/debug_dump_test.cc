@@ -287,6 +287,9 @@ void DebugDumpTest::VerifyDebugDump(const std::string& in_filename) {
       case audioproc::Event::CONFIG:
         OnConfigEvent(event_msg.config());
         break;
+      case audioproc::Event::PROFILE:
+        // Profiles do not affect the processing.
+        break;
       case audioproc::Event::UNKNOWN_EVENT:
         // We do not expect receive UNKNOWN event currently.
         FAIL();
@@ -14,6 +14,10 @@
 #include <stdlib.h>
 #include <string.h>
 
+#if defined(WEBRTC_ARCH_X86_FAMILY) && defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 // Number of right shifts for scaling is linearly depending on number of bits in
 // the far-end binary spectrum.
 static const int kShiftsAtZero = 13;  // Right shifts at zero binary spectrum.
@@ -37,6 +41,10 @@ static const float kMinFractionWhenPossiblyNonCausal = 0.25f;
 
 // Counts and returns number of bits of a 32-bit word.
 static int BitCount(uint32_t u32) {
+#if defined(__GNUC__) && defined(__POPCNT__)
+  // The compiler targets the x86 popcount instruction.
+  return __builtin_popcount(u32);
+#else
   uint32_t tmp = u32 - ((u32 >> 1) & 033333333333) -
       ((u32 >> 2) & 011111111111);
   tmp = ((tmp + (tmp >> 3)) & 030707070707);
@@ -44,6 +52,7 @@ static int BitCount(uint32_t u32) {
   tmp = (tmp + (tmp >> 12) + (tmp >> 24)) & 077;
 
   return ((int) tmp);
+#endif
 }
 
 // Compares the |binary_vector| with all rows of the |binary_matrix| and counts
@@ -65,12 +74,61 @@ static void BitCountComparison(uint32_t binary_vector,
                                int32_t* bit_counts) {
   int n = 0;
 
-  // Compare |binary_vector| with all rows of the |binary_matrix|
+#if defined(WEBRTC_ARCH_X86_FAMILY) && defined(__SSE2__)
+  // Count the bits of four rows at a time, by summing adjacent bits, then bit
+  // pairs, nibbles, bytes and finally half words.
+  const __m128i vector = _mm_set1_epi32((int32_t) binary_vector);
+  const __m128i mask1 = _mm_set1_epi32(0x55555555);
+  const __m128i mask2 = _mm_set1_epi32(0x33333333);
+  const __m128i mask4 = _mm_set1_epi32(0x0F0F0F0F);
+  const __m128i mask6 = _mm_set1_epi32(0x3F);
+  for (; n + 4 <= matrix_size; n += 4) {
+    __m128i x = _mm_xor_si128(
+        vector, _mm_loadu_si128((const __m128i*) &binary_matrix[n]));
+    x = _mm_sub_epi32(x, _mm_and_si128(_mm_srli_epi32(x, 1), mask1));
+    x = _mm_add_epi32(_mm_and_si128(x, mask2),
+                      _mm_and_si128(_mm_srli_epi32(x, 2), mask2));
+    x = _mm_and_si128(_mm_add_epi32(x, _mm_srli_epi32(x, 4)), mask4);
+    x = _mm_add_epi32(x, _mm_srli_epi32(x, 8));
+    x = _mm_and_si128(_mm_add_epi32(x, _mm_srli_epi32(x, 16)), mask6);
+    _mm_storeu_si128((__m128i*) &bit_counts[n], x);
+  }
+#endif
+
+  // Compare |binary_vector| with the remaining rows of the |binary_matrix|
   for (; n < matrix_size; n++) {
     bit_counts[n] = (int32_t) BitCount(binary_vector ^ binary_matrix[n]);
   }
 }
 
+// Updates the |mean_value| recursively with a step size of 2^-|factor|. See
+// WebRtc_MeanEstimatorFix().
+static void MeanEstimatorFix(int32_t new_value,
+                             int factor,
+                             int32_t* mean_value) {
+  int32_t diff = new_value - *mean_value;
+  // All ones if |diff| is negative, zero otherwise.
+  const int32_t sign = -(diff < 0);
+
+  // mean_new = mean_value + ((new_value - mean_value) >> factor);
+  // The shift is done on the magnitude of |diff|, i.e., rounding towards zero.
+  // The sign is handled without branching, since it changes at random.
+  diff = ((((diff ^ sign) - sign) >> factor) ^ sign) - sign;
+  *mean_value += diff;
+}
+
+// Stores |binary_far_spectrum| and its bit count at |index| of the circular
+// far-end history, in both of its copies.
+static void WriteFarSpectrum(BinaryDelayEstimatorFarend* self,
+                             int index,
+                             uint32_t binary_far_spectrum) {
+  const int bit_count = BitCount(binary_far_spectrum);
+  self->binary_far_history[index] = binary_far_spectrum;
+  self->binary_far_history[index + self->history_size] = binary_far_spectrum;
+  self->far_bit_counts[index] = bit_count;
+  self->far_bit_counts[index + self->history_size] = bit_count;
+}
+
 // Collects necessary statistics for the HistogramBasedValidation().  This
 // function has to be called prior to calling HistogramBasedValidation().  The
 // statistics updated and used by the HistogramBasedValidation() are:
@@ -96,6 +154,9 @@ static void UpdateRobustValidationStatistics(BinaryDelayEstimator* self,
   float decrease_in_last_set = valley_depth;
   const int max_hits_for_slow_change = (candidate_delay < self->last_delay) ?
       kMaxHitsWhenPossiblyNonCausal : kMaxHitsWhenPossiblyCausal;
+  int set_bins[8];
+  float set_values[8];
+  int num_set_bins = 0;
   int i = 0;
 
   assert(self->history_size == self->farend->history_size);
@@ -129,20 +190,41 @@ static void UpdateRobustValidationStatistics(BinaryDelayEstimator* self,
         valley_level_q14) * kQ14Scaling;
   }
   // 4. All other bins are decreased with |valley_depth|.
-  // TODO(bjornv): Investigate how to make this loop more efficient.  Split up
-  // the loop?  Remove parts that doesn't add too much.
+  // Since the sets in 2. and 3. hold at most eight bins, all bins are first
+  // decreased as in 4. in one pass, after which the bins of these sets are
+  // recomputed from their previous values.
+  for (i = -2; i <= 1; ++i) {
+    int bin = self->last_delay + i;
+    if (bin >= 0 && bin < self->history_size) {
+      set_bins[num_set_bins] = bin;
+      set_values[num_set_bins++] = self->histogram[bin];
+    }
+    bin = candidate_delay + i;
+    if (bin >= 0 && bin < self->history_size) {
+      set_bins[num_set_bins] = bin;
+      set_values[num_set_bins++] = self->histogram[bin];
+    }
+  }
   for (i = 0; i < self->history_size; ++i) {
-    int is_in_last_set = (i >= self->last_delay - 2) &&
-        (i <= self->last_delay + 1) && (i != candidate_delay);
-    int is_in_candidate_set = (i >= candidate_delay - 2) &&
-        (i <= candidate_delay + 1);
-    self->histogram[i] -= decrease_in_last_set * is_in_last_set +
-        valley_depth * (!is_in_last_set && !is_in_candidate_set);
+    self->histogram[i] -= valley_depth;
     // 5. No histogram bin can go below 0.
     if (self->histogram[i] < 0) {
       self->histogram[i] = 0;
     }
   }
+  for (i = 0; i < num_set_bins; ++i) {
+    const int bin = set_bins[i];
+    int is_in_last_set = (bin >= self->last_delay - 2) &&
+        (bin <= self->last_delay + 1) && (bin != candidate_delay);
+    int is_in_candidate_set = (bin >= candidate_delay - 2) &&
+        (bin <= candidate_delay + 1);
+    self->histogram[bin] = set_values[i] -
+        (decrease_in_last_set * is_in_last_set +
+         valley_depth * (!is_in_last_set && !is_in_candidate_set));
+    if (self->histogram[bin] < 0) {
+      self->histogram[bin] = 0;
+    }
+  }
 }
 
 // Validates the |candidate_delay|, estimated in WebRtc_ProcessBinarySpectrum(),
@@ -283,6 +365,7 @@ BinaryDelayEstimatorFarend* WebRtc_CreateBinaryDelayEstimatorFarend(
   }
 
   self->history_size = 0;
+  self->history_pos = 0;
   self->binary_far_history = NULL;
   self->far_bit_counts = NULL;
   if (WebRtc_AllocateFarendBufferMemory(self, history_size) == 0) {
@@ -294,83 +377,101 @@ BinaryDelayEstimatorFarend* WebRtc_CreateBinaryDelayEstimatorFarend(
 
 int WebRtc_AllocateFarendBufferMemory(BinaryDelayEstimatorFarend* self,
                                       int history_size) {
+  uint32_t* binary_far_history = NULL;
+  int* far_bit_counts = NULL;
+  int kept_size = 0;
+  int i = 0;
   assert(self != NULL);
-  // (Re-)Allocate memory for history buffers.
-  self->binary_far_history =
-      realloc(self->binary_far_history,
-              history_size * sizeof(*self->binary_far_history));
-  self->far_bit_counts = realloc(self->far_bit_counts,
-                                 history_size * sizeof(*self->far_bit_counts));
-  if ((self->binary_far_history == NULL) || (self->far_bit_counts == NULL)) {
+  // (Re-)Allocate memory for history buffers, which hold two copies of the
+  // circular history.
+  binary_far_history = malloc(2 * history_size * sizeof(*binary_far_history));
+  far_bit_counts = malloc(2 * history_size * sizeof(*far_bit_counts));
+  if ((binary_far_history == NULL) || (far_bit_counts == NULL)) {
+    free(binary_far_history);
+    free(far_bit_counts);
+    binary_far_history = NULL;
+    far_bit_counts = NULL;
     history_size = 0;
   }
-  // Fill with zeros if we have expanded the buffers.
-  if (history_size > self->history_size) {
-    int size_diff = history_size - self->history_size;
-    memset(&self->binary_far_history[self->history_size],
-           0,
-           sizeof(*self->binary_far_history) * size_diff);
-    memset(&self->far_bit_counts[self->history_size],
+  // Keep the most recent part of the history, starting over from index 0, and
+  // fill with zeros if we have expanded the buffers.
+  kept_size = (history_size < self->history_size ? history_size :
+      self->history_size);
+  for (i = 0; i < kept_size; ++i) {
+    binary_far_history[i] = self->binary_far_history[self->history_pos + i];
+    far_bit_counts[i] = self->far_bit_counts[self->history_pos + i];
+  }
+  if (history_size > kept_size) {
+    int size_diff = history_size - kept_size;
+    memset(&binary_far_history[kept_size],
            0,
-           sizeof(*self->far_bit_counts) * size_diff);
+           sizeof(*binary_far_history) * size_diff);
+    memset(&far_bit_counts[kept_size], 0, sizeof(*far_bit_counts) * size_diff);
   }
+  if (history_size > 0) {
+    memcpy(&binary_far_history[history_size],
+           binary_far_history,
+           sizeof(*binary_far_history) * history_size);
+    memcpy(&far_bit_counts[history_size],
+           far_bit_counts,
+           sizeof(*far_bit_counts) * history_size);
+  }
+  free(self->binary_far_history);
+  free(self->far_bit_counts);
+  self->binary_far_history = binary_far_history;
+  self->far_bit_counts = far_bit_counts;
   self->history_size = history_size;
+  self->history_pos = 0;
 
   return self->history_size;
 }
 
 void WebRtc_InitBinaryDelayEstimatorFarend(BinaryDelayEstimatorFarend* self) {
   assert(self != NULL);
-  memset(self->binary_far_history, 0, sizeof(uint32_t) * self->history_size);
-  memset(self->far_bit_counts, 0, sizeof(int) * self->history_size);
+  memset(self->binary_far_history,
+         0,
+         2 * sizeof(*self->binary_far_history) * self->history_size);
+  memset(self->far_bit_counts,
+         0,
+         2 * sizeof(*self->far_bit_counts) * self->history_size);
+  self->history_pos = 0;
 }
 
 void WebRtc_SoftResetBinaryDelayEstimatorFarend(
     BinaryDelayEstimatorFarend* self, int delay_shift) {
   int abs_shift = abs(delay_shift);
-  int shift_size = 0;
-  int dest_index = 0;
-  int src_index = 0;
-  int padding_index = 0;
+  int i = 0;
 
   assert(self != NULL);
-  shift_size = self->history_size - abs_shift;
-  assert(shift_size > 0);
-  if (delay_shift == 0) {
-    return;
-  } else if (delay_shift > 0) {
-    dest_index = abs_shift;
-  } else if (delay_shift < 0) {
-    src_index = abs_shift;
-    padding_index = shift_size;
-  }
-
-  // Shift and zero pad buffers.
-  memmove(&self->binary_far_history[dest_index],
-          &self->binary_far_history[src_index],
-          sizeof(*self->binary_far_history) * shift_size);
-  memset(&self->binary_far_history[padding_index], 0,
-         sizeof(*self->binary_far_history) * abs_shift);
-  memmove(&self->far_bit_counts[dest_index],
-          &self->far_bit_counts[src_index],
-          sizeof(*self->far_bit_counts) * shift_size);
-  memset(&self->far_bit_counts[padding_index], 0,
-         sizeof(*self->far_bit_counts) * abs_shift);
+  assert(self->history_size - abs_shift > 0);
+  if (delay_shift > 0) {
+    // Delay the history by zero padding at the newest end.
+    for (i = 0; i < abs_shift; ++i) {
+      WebRtc_AddBinaryFarSpectrum(self, 0);
+    }
+  } else {
+    // Advance the history by dropping the newest spectra. The circular buffer
+    // then wraps them around to the oldest end, where they are zero padded.
+    for (i = 0; i < abs_shift; ++i) {
+      WriteFarSpectrum(self, self->history_pos, 0);
+      self->history_pos++;
+      if (self->history_pos == self->history_size) {
+        self->history_pos = 0;
+      }
+    }
+  }
 }
 
 void WebRtc_AddBinaryFarSpectrum(BinaryDelayEstimatorFarend* handle,
                                  uint32_t binary_far_spectrum) {
   assert(handle != NULL);
-  // Shift binary spectrum history and insert current |binary_far_spectrum|.
-  memmove(&(handle->binary_far_history[1]), &(handle->binary_far_history[0]),
-          (handle->history_size - 1) * sizeof(uint32_t));
-  handle->binary_far_history[0] = binary_far_spectrum;
-
-  // Shift history of far-end binary spectrum bit counts and insert bit count
-  // of current |binary_far_spectrum|.
-  memmove(&(handle->far_bit_counts[1]), &(handle->far_bit_counts[0]),
-          (handle->history_size - 1) * sizeof(int));
-  handle->far_bit_counts[0] = BitCount(binary_far_spectrum);
+  // Step back in the circular history and insert the current
+  // |binary_far_spectrum|, along with its bit count, as the newest spectrum.
+  if (handle->history_pos == 0) {
+    handle->history_pos = handle->history_size;
+  }
+  handle->history_pos--;
+  WriteFarSpectrum(handle, handle->history_pos, binary_far_spectrum);
 }
 
 void WebRtc_FreeBinaryDelayEstimator(BinaryDelayEstimator* self) {
@@ -412,6 +513,7 @@ BinaryDelayEstimator* WebRtc_CreateBinaryDelayEstimator(
 
   self->farend = farend;
   self->near_history_size = max_lookahead + 1;
+  self->near_history_pos = 0;
   self->history_size = 0;
   self->robust_validation_enabled = 0;  // Disabled by default.
   self->allowed_offset = 0;
@@ -483,6 +585,7 @@ void WebRtc_InitBinaryDelayEstimator(BinaryDelayEstimator* self) {
   memset(self->binary_near_history,
          0,
          sizeof(uint32_t) * self->near_history_size);
+  self->near_history_pos = 0;
   for (i = 0; i <= self->history_size; ++i) {
     self->mean_bit_counts[i] = (20 << 9);  // 20 in Q9.
     self->histogram[i] = 0.f;
@@ -524,44 +627,57 @@ int WebRtc_ProcessBinarySpectrum(BinaryDelayEstimator* self,
   int32_t value_worst_candidate = 0;
   int32_t valley_depth = 0;
 
+  const uint32_t* binary_far_history = NULL;
+  const int* far_bit_counts = NULL;
+
   assert(self != NULL);
   if (self->farend->history_size != self->history_size) {
     // Non matching history sizes.
     return -1;
   }
   if (self->near_history_size > 1) {
-    // If we apply lookahead, shift near-end binary spectrum history. Insert
-    // current |binary_near_spectrum| and pull out the delayed one.
-    memmove(&(self->binary_near_history[1]), &(self->binary_near_history[0]),
-            (self->near_history_size - 1) * sizeof(uint32_t));
-    self->binary_near_history[0] = binary_near_spectrum;
-    binary_near_spectrum = self->binary_near_history[self->lookahead];
+    // If we apply lookahead, insert current |binary_near_spectrum| in the
+    // circular near-end binary spectrum history and pull out the delayed one.
+    int delayed_pos = 0;
+    if (self->near_history_pos == 0) {
+      self->near_history_pos = self->near_history_size;
+    }
+    self->near_history_pos--;
+    self->binary_near_history[self->near_history_pos] = binary_near_spectrum;
+    delayed_pos = self->near_history_pos + self->lookahead;
+    if (delayed_pos >= self->near_history_size) {
+      delayed_pos -= self->near_history_size;
+    }
+    binary_near_spectrum = self->binary_near_history[delayed_pos];
   }
 
+  // The far-end history, starting with the newest spectrum, i.e., indexed by
+  // delay.
+  binary_far_history =
+      &self->farend->binary_far_history[self->farend->history_pos];
+  far_bit_counts = &self->farend->far_bit_counts[self->farend->history_pos];
+
   // Compare with delayed spectra and store the |bit_counts| for each delay.
-  BitCountComparison(binary_near_spectrum, self->farend->binary_far_history,
+  BitCountComparison(binary_near_spectrum, binary_far_history,
                      self->history_size, self->bit_counts);
 
-  // Update |mean_bit_counts|, which is the smoothed version of |bit_counts|.
+  // Update |mean_bit_counts|, which is the smoothed version of |bit_counts|,
+  // and find |candidate_delay|, |value_best_candidate| and
+  // |value_worst_candidate| of |mean_bit_counts| in the same pass.
   for (i = 0; i < self->history_size; i++) {
-    // |bit_counts| is constrained to [0, 32], meaning we can smooth with a
-    // factor up to 2^26. We use Q9.
-    int32_t bit_count = (self->bit_counts[i] << 9);  // Q9.
-
     // Update |mean_bit_counts| only when far-end signal has something to
     // contribute. If |far_bit_counts| is zero the far-end signal is weak and
     // we likely have a poor echo condition, hence don't update.
-    if (self->farend->far_bit_counts[i] > 0) {
+    if (far_bit_counts[i] > 0) {
+      // |bit_counts| is constrained to [0, 32], meaning we can smooth with a
+      // factor up to 2^26. We use Q9.
+      int32_t bit_count = (self->bit_counts[i] << 9);  // Q9.
       // Make number of right shifts piecewise linear w.r.t. |far_bit_counts|.
       int shifts = kShiftsAtZero;
-      shifts -= (kShiftsLinearSlope * self->farend->far_bit_counts[i]) >> 4;
-      WebRtc_MeanEstimatorFix(bit_count, shifts, &(self->mean_bit_counts[i]));
+      shifts -= (kShiftsLinearSlope * far_bit_counts[i]) >> 4;
+      MeanEstimatorFix(bit_count, shifts, &(self->mean_bit_counts[i]));
     }
-  }
 
-  // Find |candidate_delay|, |value_best_candidate| and |value_worst_candidate|
-  // of |mean_bit_counts|.
-  for (i = 0; i < self->history_size; i++) {
     if (self->mean_bit_counts[i] < value_best_candidate) {
       value_best_candidate = self->mean_bit_counts[i];
       candidate_delay = i;
@@ -672,13 +788,5 @@ float WebRtc_binary_last_delay_quality(BinaryDelayEstimator* self) {
 void WebRtc_MeanEstimatorFix(int32_t new_value,
                              int factor,
                              int32_t* mean_value) {
-  int32_t diff = new_value - *mean_value;
-
-  // mean_new = mean_value + ((new_value - mean_value) >> factor);
-  if (diff < 0) {
-    diff = -((-diff) >> factor);
-  } else {
-    diff = (diff >> factor);
-  }
-  *mean_value += diff;
+  MeanEstimatorFix(new_value, factor, mean_value);
 }
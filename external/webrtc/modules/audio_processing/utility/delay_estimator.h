@@ -24,6 +24,11 @@ typedef struct {
   // Binary history variables.
   uint32_t* binary_far_history;
   int history_size;
+  // |binary_far_history| and |far_bit_counts| are circular buffers of
+  // |history_size| elements, each stored twice in a row. The history, newest
+  // spectrum first, is then always available contiguously from |history_pos|,
+  // and adding a spectrum does not have to shift the whole history.
+  int history_pos;
 } BinaryDelayEstimatorFarend;
 
 typedef struct {
@@ -33,9 +38,11 @@ typedef struct {
   // determined at run-time.
   int32_t* bit_counts;
 
-  // Binary history variables.
+  // Binary history variables. |binary_near_history| is a circular buffer with
+  // the newest spectrum at |near_history_pos|.
   uint32_t* binary_near_history;
   int near_history_size;
+  int near_history_pos;
   int history_size;
 
   // Delay estimation variables.
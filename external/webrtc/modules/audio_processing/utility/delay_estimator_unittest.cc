@@ -8,6 +8,8 @@
  *  be found in the AUTHORS file in the root of the source tree.
  */
 
+#include <vector>
+
 #include "testing/gtest/include/gtest/gtest.h"
 
 extern "C" {
@@ -616,6 +618,174 @@ TEST_F(DelayEstimatorTest, VerifyHistorySizeIsSetAndKeptAfterInit) {
   EXPECT_EQ(kDifferentHistorySize, WebRtc_history_size(handle_));
 }
 
+TEST_F(DelayEstimatorTest, ExactDelayEstimateWithLongHistory) {
+  // Verifies that delays of about a second, i.e., 250 blocks of 4 ms, are
+  // found without lookahead.
+  const int kLongHistorySize = 250;
+  const int kLongDelay = kLongHistorySize - 10;
+  const int kLongSequenceLength = 2 * kLongHistorySize + kSequenceLength;
+  // Unlike the powers of 3 in |binary_spectrum_|, whose low bits repeat with
+  // short periods, a xorshift sequence has no spurious matches over a history
+  // this long.
+  std::vector<uint32_t> binary_spectrum(kLongSequenceLength);
+  uint32_t state = 1;
+  for (int i = 0; i < kLongSequenceLength; i++) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    binary_spectrum[i] = state;
+  }
+
+  BinaryDelayEstimatorFarend* binary_farend =
+      WebRtc_CreateBinaryDelayEstimatorFarend(kLongHistorySize);
+  ASSERT_TRUE(binary_farend != NULL);
+  BinaryDelayEstimator* binary =
+      WebRtc_CreateBinaryDelayEstimator(binary_farend, 0);
+  ASSERT_TRUE(binary != NULL);
+  for (size_t i = 0; i < kSizeEnable; ++i) {
+    WebRtc_InitBinaryDelayEstimatorFarend(binary_farend);
+    WebRtc_InitBinaryDelayEstimator(binary);
+    binary->robust_validation_enabled = kEnable[i];
+    // Fill the far-end history before the near-end starts, as when render
+    // starts before capture.
+    for (int j = 0; j < kLongHistorySize; j++) {
+      WebRtc_AddBinaryFarSpectrum(binary_farend, binary_spectrum[j]);
+    }
+    for (int j = kLongHistorySize; j < kLongSequenceLength; j++) {
+      WebRtc_AddBinaryFarSpectrum(binary_farend, binary_spectrum[j]);
+      int delay = WebRtc_ProcessBinarySpectrum(binary,
+                                               binary_spectrum[j - kLongDelay]);
+      VerifyDelay(binary, kLongDelay, delay);
+    }
+    EXPECT_EQ(kLongDelay, WebRtc_binary_last_delay(binary));
+  }
+  WebRtc_FreeBinaryDelayEstimator(binary);
+  WebRtc_FreeBinaryDelayEstimatorFarend(binary_farend);
+}
+
+TEST_F(DelayEstimatorTest, FarendHistoryIsKeptOnSoftResetAndReallocation) {
+  // The far-end history, newest spectrum first, is expected at
+  // |binary_far_history| from |history_pos|.
+  const int kShift = 3;
+  InitBinary();
+  for (int i = 0; i < kHistorySize + kShift; i++) {
+    WebRtc_AddBinaryFarSpectrum(binary_farend_, binary_spectrum_[i]);
+  }
+  const uint32_t* history =
+      &binary_farend_->binary_far_history[binary_farend_->history_pos];
+  for (int i = 0; i < kHistorySize; i++) {
+    ASSERT_EQ(binary_spectrum_[kHistorySize + kShift - 1 - i], history[i]);
+  }
+
+  // A positive shift delays the history and zero pads the newest spectra.
+  WebRtc_SoftResetBinaryDelayEstimatorFarend(binary_farend_, kShift);
+  history = &binary_farend_->binary_far_history[binary_farend_->history_pos];
+  for (int i = 0; i < kShift; i++) {
+    EXPECT_EQ(0u, history[i]);
+    EXPECT_EQ(0, binary_farend_->far_bit_counts[binary_farend_->history_pos +
+                                                i]);
+  }
+  for (int i = kShift; i < kHistorySize; i++) {
+    ASSERT_EQ(binary_spectrum_[kHistorySize + 2 * kShift - 1 - i], history[i]);
+  }
+
+  // A negative shift restores it, zero padding the oldest spectra.
+  WebRtc_SoftResetBinaryDelayEstimatorFarend(binary_farend_, -kShift);
+  history = &binary_farend_->binary_far_history[binary_farend_->history_pos];
+  for (int i = 0; i < kHistorySize - kShift; i++) {
+    ASSERT_EQ(binary_spectrum_[kHistorySize + kShift - 1 - i], history[i]);
+  }
+  for (int i = kHistorySize - kShift; i < kHistorySize; i++) {
+    EXPECT_EQ(0u, history[i]);
+  }
+
+  // Reallocation keeps the newest spectra.
+  ASSERT_EQ(kDifferentHistorySize,
+            WebRtc_AllocateHistoryBufferMemory(binary_,
+                                               kDifferentHistorySize));
+  history = &binary_farend_->binary_far_history[binary_farend_->history_pos];
+  for (int i = 0; i < kDifferentHistorySize; i++) {
+    EXPECT_EQ(binary_spectrum_[kHistorySize + kShift - 1 - i], history[i]);
+  }
+  ASSERT_EQ(kHistorySize,
+            WebRtc_AllocateHistoryBufferMemory(binary_, kHistorySize));
+  history = &binary_farend_->binary_far_history[binary_farend_->history_pos];
+  for (int i = 0; i < kDifferentHistorySize; i++) {
+    EXPECT_EQ(binary_spectrum_[kHistorySize + kShift - 1 - i], history[i]);
+  }
+  for (int i = kDifferentHistorySize; i < kHistorySize; i++) {
+    EXPECT_EQ(0u, history[i]);
+  }
+}
+
+// Runs a binary delay estimator through 2000 blocks with changing delays,
+// single bit errors, soft resets and robust validation switched on half way,
+// and returns a hash of the delay estimates and the mean bit counts of every
+// block.
+uint32_t HashBinaryDelayEstimates(int history_size, int lookahead) {
+  const int kNumBlocks = 2000;
+  const int kNumFarSpectra = 512;
+  BinaryDelayEstimatorFarend* binary_farend =
+      WebRtc_CreateBinaryDelayEstimatorFarend(history_size);
+  BinaryDelayEstimator* binary =
+      WebRtc_CreateBinaryDelayEstimator(binary_farend, lookahead);
+  WebRtc_InitBinaryDelayEstimatorFarend(binary_farend);
+  WebRtc_InitBinaryDelayEstimator(binary);
+
+  uint32_t far_spectra[kNumFarSpectra];
+  uint32_t state = 1;
+  for (int i = 0; i < kNumFarSpectra; i++) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    far_spectra[i] = state;
+  }
+
+  uint32_t hash = 2166136261u;
+  int delay = history_size / 3;
+  for (int i = 0; i < kNumBlocks; i++) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    if (i % 500 == 250) {
+      delay = state % (history_size + lookahead);
+    }
+    if (i % 700 == 350) {
+      const int shift = static_cast<int>(state % 7) - 3;
+      WebRtc_SoftResetBinaryDelayEstimatorFarend(binary_farend, shift);
+      WebRtc_SoftResetBinaryDelayEstimator(binary, shift);
+    }
+    if (i == kNumBlocks / 2) {
+      binary->robust_validation_enabled = 1;
+    }
+    WebRtc_AddBinaryFarSpectrum(binary_farend, far_spectra[i % kNumFarSpectra]);
+    uint32_t near_spectrum = far_spectra[(i + lookahead - delay +
+                                          4 * kNumFarSpectra) % kNumFarSpectra];
+    if (state & 1) {
+      near_spectrum ^= 1u << ((state >> 1) % 32);
+    }
+    const int delay_estimate =
+        WebRtc_ProcessBinarySpectrum(binary, near_spectrum);
+    hash = (hash ^ static_cast<uint32_t>(delay_estimate)) * 16777619u;
+    for (int j = 0; j <= history_size; j++) {
+      hash = (hash ^ static_cast<uint32_t>(binary->mean_bit_counts[j])) *
+             16777619u;
+    }
+  }
+  WebRtc_FreeBinaryDelayEstimator(binary);
+  WebRtc_FreeBinaryDelayEstimatorFarend(binary_farend);
+  return hash;
+}
+
+TEST_F(DelayEstimatorTest, BitExactWithPreviousImplementation) {
+  // The reference hashes were recorded with the implementation which shifted
+  // the whole far-end history for every block.
+  EXPECT_EQ(0xa7d0a8beu, HashBinaryDelayEstimates(kHistorySize, 0));
+  EXPECT_EQ(0x2ead624cu, HashBinaryDelayEstimates(kHistorySize, kLookahead));
+  EXPECT_EQ(0x3e67c73eu, HashBinaryDelayEstimates(250, 0));
+  EXPECT_EQ(0x4a05ce0fu, HashBinaryDelayEstimates(250, kLookahead));
+}
+
 // TODO(bjornv): Add tests for SoftReset...(...).
 
 }  // namespace
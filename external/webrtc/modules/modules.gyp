@@ -225,6 +225,8 @@
                 # 'audio_processing/agc/agc_unittest.cc',
                 'audio_processing/agc/histogram_unittest.cc',
                 'audio_processing/agc/mock_agc.h',
+                'audio_processing/batch_audio_processing_unittest.cc',
+                'audio_processing/duplex/duplex_engine_unittest.cc',
                 'audio_processing/beamformer/array_util_unittest.cc',
                 'audio_processing/beamformer/complex_matrix_unittest.cc',
                 'audio_processing/beamformer/covariance_matrix_generator_unittest.cc',
@@ -234,7 +236,10 @@
                 'audio_processing/echo_cancellation_impl_unittest.cc',
                 'audio_processing/intelligibility/intelligibility_enhancer_unittest.cc',
                 'audio_processing/intelligibility/intelligibility_utils_unittest.cc',
+                'audio_processing/processing_profiler_unittest.cc',
+                'audio_processing/render_queue_unittest.cc',
                 'audio_processing/splitting_filter_unittest.cc',
+                'audio_processing/spsc_ring_buffer_unittest.cc',
                 'audio_processing/transient/dyadic_decimator_unittest.cc',
                 'audio_processing/transient/file_utils.cc',
                 'audio_processing/transient/file_utils.h',
@@ -409,6 +414,19 @@
                     'audio_processing/test/test_utils.h',
                   ],
                 }],
+                ['target_arch=="ia32" or target_arch=="x64"', {
+                  'sources': [
+                    'audio_processing/aec/aec_core_avx2_unittest.cc',
+                    'audio_processing/aecm/aecm_core_sse41_unittest.cc',
+                  ],
+                  'conditions': [
+                    ['prefer_fixed_point==1', {
+                      'sources': [
+                        'audio_processing/ns/nsx_core_sse41_unittest.cc',
+                      ],
+                    }],
+                  ],
+                }],
                 ['build_libvpx==1', {
                   'dependencies': [
                     '<(libvpx_dir)/libvpx.gyp:libvpx_new',
@@ -20,7 +20,10 @@ extern "C" {
 // List of features in x86.
 typedef enum {
   kSSE2,
-  kSSE3
+  kSSE3,
+  kSSE4_1,
+  kAVX2,
+  kFMA3
 } CPUFeature;
 
 // List of features in ARM.
@@ -36,6 +36,14 @@ static inline void __cpuid(int cpu_info[4], int info_type) {
     : "=a"(cpu_info[0]), "=D"(cpu_info[1]), "=c"(cpu_info[2]), "=d"(cpu_info[3])
     : "a"(info_type));
 }
+static inline void __cpuidex(int cpu_info[4], int info_type, int sub_type) {
+  __asm__ volatile(
+    "mov %%ebx, %%edi\n"
+    "cpuid\n"
+    "xchg %%edi, %%ebx\n"
+    : "=a"(cpu_info[0]), "=D"(cpu_info[1]), "=c"(cpu_info[2]), "=d"(cpu_info[3])
+    : "a"(info_type), "c"(sub_type));
+}
 #else
 static inline void __cpuid(int cpu_info[4], int info_type) {
   __asm__ volatile(
@@ -43,7 +51,23 @@ static inline void __cpuid(int cpu_info[4], int info_type) {
     : "=a"(cpu_info[0]), "=b"(cpu_info[1]), "=c"(cpu_info[2]), "=d"(cpu_info[3])
     : "a"(info_type));
 }
+static inline void __cpuidex(int cpu_info[4], int info_type, int sub_type) {
+  __asm__ volatile(
+    "cpuid\n"
+    : "=a"(cpu_info[0]), "=b"(cpu_info[1]), "=c"(cpu_info[2]), "=d"(cpu_info[3])
+    : "a"(info_type), "c"(sub_type));
+}
 #endif
+// Reads an extended control register, like the "_xgetbv" intrinsic.
+static inline uint64_t xgetbv(uint32_t xcr) {
+  uint32_t eax, edx;
+  __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(xcr));
+  return (static_cast<uint64_t>(edx) << 32) | eax;
+}
+#else
+static inline uint64_t xgetbv(uint32_t xcr) {
+  return _xgetbv(xcr);
+}
 #endif  // _MSC_VER
 #endif  // WEBRTC_ARCH_X86_FAMILY
 
@@ -58,6 +82,27 @@ static int GetCPUInfo(CPUFeature feature) {
   if (feature == kSSE3) {
     return 0 != (cpu_info[2] & 0x00000001);
   }
+  if (feature == kSSE4_1) {
+    return 0 != (cpu_info[2] & 0x00080000);
+  }
+  if (feature == kAVX2 || feature == kFMA3) {
+    // The AVX registers are only usable if the OS saves them on context
+    // switches, i.e. if OSXSAVE is set and XCR0 enables the XMM and YMM state.
+    const bool os_saves_ymm = (cpu_info[2] & 0x08000000) != 0 &&
+                              (xgetbv(0) & 0x6) == 0x6;
+    if (!os_saves_ymm || (cpu_info[2] & 0x10000000) == 0) {
+      return 0;
+    }
+    if (feature == kFMA3) {
+      return 0 != (cpu_info[2] & 0x00001000);
+    }
+    __cpuid(cpu_info, 0);
+    if (cpu_info[0] < 7) {
+      return 0;
+    }
+    __cpuidex(cpu_info, 7, 0);
+    return 0 != (cpu_info[1] & 0x00000020);
+  }
   return 0;
 }
 #else